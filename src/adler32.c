@@ -1,49 +1,83 @@
 #include "adler32.h"
 #include <ace/utils/file.h>
 #include <ace/managers/log.h>
+#include <ace/managers/memory.h>
 #include <ace/managers/system.h>
+#include "memstats.h"
 
 #define ADLER32_MODULO 65521
+/// Max bytes which may be summed before b overflows 32 bits.
+#define ADLER32_NMAX 5552
+/// Size of file read chunks.
+#define ADLER32_BUFFER_SIZE 4096
 
-ULONG adler32array(const UBYTE *pData, ULONG ulDataSize) {
-	ULONG a = 1, b = 0;
-	for(ULONG i = 0; i < ulDataSize; ++i) {
-		a += pData[i];
-		if(a >= ADLER32_MODULO) {
-			a -= ADLER32_MODULO;
+/**
+ * Continues adler32 calculation over next part of data.
+ * Sums are reduced only once per ADLER32_NMAX bytes instead of every byte,
+ * inner loop is unrolled since it's the only hot spot of cache validation.
+ * @param ulAdler Checksum of preceding data, 1 for start of data.
+ * @param pData Next part of data.
+ * @param ulDataSize Size of data, in bytes.
+ * @return Checksum of all data processed so far.
+ */
+static ULONG adler32update(ULONG ulAdler, const UBYTE *pData, ULONG ulDataSize) {
+	ULONG a = ulAdler & 0xFFFF, b = ulAdler >> 16;
+	while(ulDataSize) {
+		ULONG ulBlock = MIN(ulDataSize, ADLER32_NMAX);
+		ulDataSize -= ulBlock;
+		for(; ulBlock >= 8; ulBlock -= 8) {
+			a += pData[0]; b += a;
+			a += pData[1]; b += a;
+			a += pData[2]; b += a;
+			a += pData[3]; b += a;
+			a += pData[4]; b += a;
+			a += pData[5]; b += a;
+			a += pData[6]; b += a;
+			a += pData[7]; b += a;
+			pData += 8;
 		}
-		b += a;
-		if(b >= ADLER32_MODULO) {
-			b -= ADLER32_MODULO;
+		while(ulBlock--) {
+			a += *(pData++);
+			b += a;
 		}
+		a %= ADLER32_MODULO;
+		b %= ADLER32_MODULO;
 	}
 	return (b << 16) | a;
 }
 
+ULONG adler32array(const UBYTE *pData, ULONG ulDataSize) {
+	return adler32update(1, pData, ulDataSize);
+}
+
 ULONG adler32file(const char *szPath) {
 	systemUse();
 	logBlockBegin("adler32File(szPath: %s)", szPath);
+	ULONG ulAdler = 1;
 	tFile *pFile = fileOpen(szPath, "rb");
-	ULONG a = 1, b = 0;
 	if(!pFile) {
 		logWrite("ERR: File doesn't exist\n");
-		goto fail;
+		logBlockEnd("adler32File()");
+		systemUnuse();
+		return ulAdler;
 	}
-	UBYTE ubBfr;
-	while(!fileIsEof(pFile)) {
-		fileRead(pFile, &ubBfr, 1);
-		a += ubBfr;
-		if(a >= ADLER32_MODULO) {
-			a -= ADLER32_MODULO;
-		}
-		b += a;
-		if(b >= ADLER32_MODULO) {
-			b -= ADLER32_MODULO;
-		}
+	UBYTE *pBuffer = memAllocFastTagged(
+		MEMSTATS_TAG_PRECALC, ADLER32_BUFFER_SIZE
+	);
+	if(!pBuffer) {
+		logWrite("ERR: Couldn't allocate read buffer\n");
+		fileClose(pFile);
+		logBlockEnd("adler32File()");
+		systemUnuse();
+		return ulAdler;
 	}
-fail:
+	ULONG ulRead;
+	while((ulRead = fileRead(pFile, pBuffer, ADLER32_BUFFER_SIZE))) {
+		ulAdler = adler32update(ulAdler, pBuffer, ulRead);
+	}
+	memFreeTagged(MEMSTATS_TAG_PRECALC, pBuffer, ADLER32_BUFFER_SIZE);
 	fileClose(pFile);
 	logBlockEnd("adler32File()");
 	systemUnuse();
-	return (b << 16) | a;
+	return ulAdler;
 }
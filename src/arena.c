@@ -0,0 +1,181 @@
+#include "arena.h"
+#include <string.h>
+#include <ace/macros.h>
+#include <ace/managers/log.h>
+#include "memstats.h"
+
+#define ARENA_ALIGN(ulSize) (((ulSize) + 3) & ~3)
+
+static tArenaBlock *arenaBlockCreate(ULONG ulSize) {
+	tArenaBlock *pBlock = memAllocFastTagged(
+		MEMSTATS_TAG_ARENA, sizeof(tArenaBlock) + ulSize
+	);
+	if(!pBlock) {
+		return 0;
+	}
+	pBlock->pNext = 0;
+	pBlock->ulSize = ulSize;
+	pBlock->ulUsed = 0;
+	pBlock->pData = (UBYTE*)&pBlock[1];
+	return pBlock;
+}
+
+/**
+ * Gives bytes handed out since given state back to MEMSTATS_TAG_ARENA.
+ * @param pArena Arena whose allocations are discarded.
+ * @param pKeep Bytes per tag which stay allocated, 0 to discard all.
+ */
+static void arenaReturnTagBytes(tArena *pArena, const ULONG *pKeep) {
+	for(UBYTE ubTag = 0; ubTag < MEMSTATS_TAG_COUNT; ++ubTag) {
+		ULONG ulKeep = pKeep ? pKeep[ubTag] : 0;
+		if(pArena->pTagBytes[ubTag] > ulKeep) {
+			memStatsMove(
+				ubTag, MEMSTATS_TAG_ARENA, pArena->pTagBytes[ubTag] - ulKeep
+			);
+			pArena->pTagBytes[ubTag] = ulKeep;
+		}
+	}
+}
+
+static ULONG arenaGetUsed(const tArena *pArena) {
+	ULONG ulUsed = 0;
+	for(tArenaBlock *pBlock = pArena->pFirst; pBlock; pBlock = pBlock->pNext) {
+		if(pBlock == pArena->pCurr) {
+			return ulUsed + pBlock->ulUsed;
+		}
+		ulUsed += pBlock->ulSize;
+	}
+	return ulUsed;
+}
+
+tArena *arenaCreate(ULONG ulBlockSize) {
+	logBlockBegin("arenaCreate(ulBlockSize: %lu)", ulBlockSize);
+	tArena *pArena = memAllocFastTagged(MEMSTATS_TAG_ARENA, sizeof(tArena));
+	if(!pArena) {
+		logBlockEnd("arenaCreate()");
+		return 0;
+	}
+	ulBlockSize = ARENA_ALIGN(ulBlockSize);
+	pArena->pFirst = arenaBlockCreate(ulBlockSize);
+	if(!pArena->pFirst) {
+		memFreeTagged(MEMSTATS_TAG_ARENA, pArena, sizeof(tArena));
+		logBlockEnd("arenaCreate()");
+		return 0;
+	}
+	pArena->pCurr = pArena->pFirst;
+	pArena->ulBlockSize = ulBlockSize;
+	pArena->ulPeak = 0;
+	pArena->pParent = 0;
+	memset(pArena->pTagBytes, 0, sizeof(pArena->pTagBytes));
+	logBlockEnd("arenaCreate()");
+	return pArena;
+}
+
+void arenaDestroy(tArena *pArena) {
+	if(!pArena) {
+		// Creation has failed, e.g. game state is torn down after early error
+		return;
+	}
+	logBlockBegin("arenaDestroy(pArena: %p)", pArena);
+	if(pArena->pParent) {
+		logWrite("ERR: Scratch arenas are freed along with parent\n");
+		logBlockEnd("arenaDestroy()");
+		return;
+	}
+	logWrite("Peak usage: %lu bytes\n", pArena->ulPeak);
+	arenaReturnTagBytes(pArena, 0);
+	tArenaBlock *pBlock = pArena->pFirst;
+	while(pBlock) {
+		tArenaBlock *pNext = pBlock->pNext;
+		memFreeTagged(
+			MEMSTATS_TAG_ARENA, pBlock, sizeof(tArenaBlock) + pBlock->ulSize
+		);
+		pBlock = pNext;
+	}
+	memFreeTagged(MEMSTATS_TAG_ARENA, pArena, sizeof(tArena));
+	logBlockEnd("arenaDestroy()");
+}
+
+tArena *arenaCreateScratch(tArena *pParent, UBYTE ubTag, ULONG ulSize) {
+	ulSize = ARENA_ALIGN(ulSize);
+	tArena *pArena = arenaAlloc(
+		pParent, ubTag, sizeof(tArena) + sizeof(tArenaBlock) + ulSize
+	);
+	if(!pArena) {
+		logWrite("ERR: No space for %lu-byte scratch arena\n", ulSize);
+		return 0;
+	}
+	tArenaBlock *pBlock = (tArenaBlock*)&pArena[1];
+	pBlock->pNext = 0;
+	pBlock->ulSize = ulSize;
+	pBlock->ulUsed = 0;
+	pBlock->pData = (UBYTE*)&pBlock[1];
+	pArena->pFirst = pBlock;
+	pArena->pCurr = pBlock;
+	pArena->ulBlockSize = 0;
+	pArena->ulPeak = 0;
+	pArena->pParent = pParent;
+	memset(pArena->pTagBytes, 0, sizeof(pArena->pTagBytes));
+	return pArena;
+}
+
+void *arenaAlloc(tArena *pArena, UBYTE ubTag, ULONG ulSize) {
+	ulSize = ARENA_ALIGN(ulSize);
+	tArenaBlock *pBlock = pArena->pCurr;
+	while(pBlock->ulUsed + ulSize > pBlock->ulSize) {
+		if(pBlock->pNext) {
+			// Reuse block left after rewind
+			pBlock = pBlock->pNext;
+			pBlock->ulUsed = 0;
+			continue;
+		}
+		if(!pArena->ulBlockSize) {
+			logWrite(
+				"ERR: Arena %p out of space, requested %lu bytes\n", pArena, ulSize
+			);
+			return 0;
+		}
+		pBlock->pNext = arenaBlockCreate(MAX(pArena->ulBlockSize, ulSize));
+		if(!pBlock->pNext) {
+			return 0;
+		}
+		pBlock = pBlock->pNext;
+	}
+	pArena->pCurr = pBlock;
+	void *pMem = &pBlock->pData[pBlock->ulUsed];
+	pBlock->ulUsed += ulSize;
+	pArena->ulPeak = MAX(pArena->ulPeak, arenaGetUsed(pArena));
+	if(!pArena->pParent) {
+		memStatsMove(MEMSTATS_TAG_ARENA, ubTag, ulSize);
+		pArena->pTagBytes[ubTag] += ulSize;
+	}
+	return pMem;
+}
+
+void *arenaAllocClear(tArena *pArena, UBYTE ubTag, ULONG ulSize) {
+	void *pMem = arenaAlloc(pArena, ubTag, ulSize);
+	if(pMem) {
+		memset(pMem, 0, ulSize);
+	}
+	return pMem;
+}
+
+tArenaMark arenaGetMark(const tArena *pArena) {
+	tArenaMark sMark;
+	sMark.pBlock = pArena->pCurr;
+	sMark.ulUsed = pArena->pCurr->ulUsed;
+	memcpy(sMark.pTagBytes, pArena->pTagBytes, sizeof(sMark.pTagBytes));
+	return sMark;
+}
+
+void arenaRewind(tArena *pArena, tArenaMark sMark) {
+	arenaReturnTagBytes(pArena, sMark.pTagBytes);
+	pArena->pCurr = sMark.pBlock;
+	pArena->pCurr->ulUsed = sMark.ulUsed;
+}
+
+void arenaReset(tArena *pArena) {
+	arenaReturnTagBytes(pArena, 0);
+	pArena->pCurr = pArena->pFirst;
+	pArena->pFirst->ulUsed = 0;
+}
@@ -0,0 +1,96 @@
+#ifndef GUARD_OF_ARENA_H
+#define GUARD_OF_ARENA_H
+
+#include <ace/types.h>
+#include "memstats.h"
+
+/**
+ * Bump-pointer allocator for data which lives as long as some bigger entity,
+ * e.g. a match. Allocations can't be freed one by one - whole arena is
+ * released at once, so there's no per-allocation overhead or fragmentation.
+ * When current block runs out of space, next one is appended to block list.
+ * Blocks are accounted as MEMSTATS_TAG_ARENA and each allocation moves its
+ * bytes to tag of subsystem which requested it, so memstats report still
+ * shows per-subsystem usage.
+ */
+
+typedef struct _tArenaBlock {
+	struct _tArenaBlock *pNext;
+	ULONG ulSize; ///< Usable size of block, excluding header.
+	ULONG ulUsed;
+	UBYTE *pData;
+} tArenaBlock;
+
+typedef struct _tArena {
+	tArenaBlock *pFirst;
+	tArenaBlock *pCurr; ///< Block from which allocations are made.
+	ULONG ulBlockSize; ///< Size of next blocks, 0 for fixed-size arena.
+	ULONG ulPeak; ///< Peak bytes used, for tuning initial size.
+	struct _tArena *pParent; ///< Non-zero for scratch arenas.
+	ULONG pTagBytes[MEMSTATS_TAG_COUNT]; ///< Bytes handed out to each tag.
+} tArena;
+
+/**
+ * Mark of arena's fill state, used for rewinding temporary allocations.
+ */
+typedef struct _tArenaMark {
+	tArenaBlock *pBlock;
+	ULONG ulUsed;
+	ULONG pTagBytes[MEMSTATS_TAG_COUNT];
+} tArenaMark;
+
+/**
+ * Creates new arena.
+ * @param ulBlockSize Size of each arena block. If allocation doesn't fit
+ * into remaining space, new block of at least that size is allocated.
+ * @return Pointer to newly created arena or 0 on failure.
+ */
+tArena *arenaCreate(ULONG ulBlockSize);
+
+/**
+ * Frees all arena's memory at once. Don't call it on scratch arenas.
+ * @param pArena Arena to be destroyed. Zero is ignored.
+ */
+void arenaDestroy(tArena *pArena);
+
+/**
+ * Creates fixed-size scratch arena inside parent arena.
+ * Scratch arena's memory is reclaimed with arenaReset() and released along
+ * with parent.
+ * @param pParent Parent arena.
+ * @param ubTag Subsystem tag to which whole scratch arena is accounted.
+ * @param ulSize Size of scratch arena.
+ * @return Pointer to newly created scratch arena or 0 on failure.
+ */
+tArena *arenaCreateScratch(tArena *pParent, UBYTE ubTag, ULONG ulSize);
+
+/**
+ * Allocates memory from arena. Returned memory is longword-aligned.
+ * @param pArena Arena to be used.
+ * @param ubTag Subsystem tag, one of MEMSTATS_TAG_*. Ignored for scratch
+ *        arenas, which are accounted as a whole.
+ * @param ulSize Number of bytes to allocate.
+ * @return Pointer to allocated memory or 0 if there's not enough space.
+ */
+void *arenaAlloc(tArena *pArena, UBYTE ubTag, ULONG ulSize);
+
+/**
+ * Same as arenaAlloc() but zero-fills returned memory.
+ */
+void *arenaAllocClear(tArena *pArena, UBYTE ubTag, ULONG ulSize);
+
+tArenaMark arenaGetMark(const tArena *pArena);
+
+/**
+ * Discards all allocations made since given mark was obtained.
+ * @param pArena Arena to be rewinded.
+ * @param sMark Mark obtained by arenaGetMark().
+ */
+void arenaRewind(tArena *pArena, tArenaMark sMark);
+
+/**
+ * Discards all allocations made from arena.
+ */
+void arenaReset(tArena *pArena);
+
+#endif // GUARD_OF_ARENA_H
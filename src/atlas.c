@@ -0,0 +1,428 @@
+#include "atlas.h"
+#include <string.h>
+#include <ace/managers/log.h>
+#include <ace/utils/file.h>
+#include "cache.h"
+#include "memstats.h"
+
+typedef struct _tAtlasHeader {
+	char pMagic[4];
+	UWORD uwVersion;
+	UWORD uwEntryCount;
+	ULONG ulDataSize; ///< Of sheets, loaded into CHIP.
+	ULONG ulBlobSize; ///< Of blobs, loaded into FAST.
+} tAtlasHeader;
+
+typedef struct _tAtlasEntry {
+	char szName[ATLAS_NAME_MAX]; ///< Source path, relative to data dir.
+	ULONG ulOffset;              ///< From start of sheet or blob data.
+	ULONG ulSize;
+	UWORD uwWidth;
+	UWORD uwHeight;
+	UBYTE ubDepth;
+	UBYTE ubFlags;               ///< ATLAS_FLAG_BLOB, BMF_INTERLEAVED or 0.
+	UWORD uwVersion;             ///< Of generator.
+	UWORD uwUserData;
+	UWORD uwPad;
+} tAtlasEntry;
+
+// Doesn't collide with BMF_INTERLEAVED
+#define ATLAS_FLAG_BLOB 0x80
+// Blobs start at ULONG boundaries so that their fields may be read directly
+#define ATLAS_BLOB_ALIGN(x) (((x) + 3) & ~3UL)
+
+static const char s_pMagic[4] = {'O', 'F', 'A', 'T'};
+
+static tAtlasEntry s_pEntries[ATLAS_ENTRY_MAX];
+static tBitMap *s_pSheets[ATLAS_ENTRY_MAX]; ///< View or generated bitmap.
+static void *s_pBlobs[ATLAS_ENTRY_MAX]; ///< Blob in loaded data or added one.
+static UWORD s_uwEntryCount = 0;
+static UBYTE *s_pData = 0; ///< Sheet data of loaded atlas, in CHIP.
+static ULONG s_ulDataSize = 0;
+static UBYTE *s_pBlobData = 0; ///< Blob data of loaded atlas, in FAST.
+static ULONG s_ulBlobSize = 0;
+static UBYTE s_isDirty = 0;
+
+static UWORD atlasFind(const char *szName) {
+	for(UWORD i = 0; i < s_uwEntryCount; ++i) {
+		if(!strcmp(s_pEntries[i].szName, szName)) {
+			return i;
+		}
+	}
+	return s_uwEntryCount;
+}
+
+static UBYTE atlasIsView(const tBitMap *pBitmap) {
+	return (
+		s_pData && pBitmap->Planes[0] >= s_pData &&
+		pBitmap->Planes[0] < s_pData + s_ulDataSize
+	);
+}
+
+/**
+ * Creates bitmap struct pointing to sheet data, laid out same way as
+ * bitmapCreate() would do it.
+ */
+static tBitMap *atlasCreateView(const tAtlasEntry *pEntry) {
+	tBitMap *pBitmap = memAllocFastClearTagged(
+		MEMSTATS_TAG_PRECALC, sizeof(tBitMap)
+	);
+	if(!pBitmap) {
+		return 0;
+	}
+	UWORD uwByteWidth = ((pEntry->uwWidth + 15) >> 4) << 1;
+	UBYTE *pPlane = &s_pData[pEntry->ulOffset];
+	pBitmap->Rows = pEntry->uwHeight;
+	pBitmap->Depth = pEntry->ubDepth;
+	if(pEntry->ubFlags & BMF_INTERLEAVED) {
+		pBitmap->BytesPerRow = uwByteWidth * pEntry->ubDepth;
+		for(UBYTE i = 0; i < pEntry->ubDepth; ++i) {
+			pBitmap->Planes[i] = pPlane + i * uwByteWidth;
+		}
+	}
+	else {
+		pBitmap->BytesPerRow = uwByteWidth;
+		for(UBYTE i = 0; i < pEntry->ubDepth; ++i) {
+			pBitmap->Planes[i] = pPlane + i * uwByteWidth * pEntry->uwHeight;
+		}
+	}
+	return pBitmap;
+}
+
+static void atlasSheetDestroy(tBitMap *pBitmap) {
+	if(atlasIsView(pBitmap)) {
+		memFreeTagged(MEMSTATS_TAG_PRECALC, pBitmap, sizeof(tBitMap));
+	}
+	else {
+		bitmapDestroy(pBitmap);
+	}
+}
+
+static void atlasBlobDestroy(void *pBlob, ULONG ulSize) {
+	UBYTE *pBytes = pBlob;
+	if(
+		!s_pBlobData || pBytes < s_pBlobData ||
+		pBytes >= s_pBlobData + s_ulBlobSize
+	) {
+		memFreeTagged(MEMSTATS_TAG_PRECALC, pBlob, ulSize);
+	}
+}
+
+/**
+ * Frees sheet or blob of entry, unless it's going to be replaced with same one.
+ */
+static void atlasEntryFree(UWORD uwIdx, const void *pReplacement) {
+	if(s_pSheets[uwIdx] && (const void*)s_pSheets[uwIdx] != pReplacement) {
+		atlasSheetDestroy(s_pSheets[uwIdx]);
+	}
+	if(s_pBlobs[uwIdx] && s_pBlobs[uwIdx] != pReplacement) {
+		atlasBlobDestroy(s_pBlobs[uwIdx], s_pEntries[uwIdx].ulSize);
+	}
+	s_pSheets[uwIdx] = 0;
+	s_pBlobs[uwIdx] = 0;
+}
+
+/**
+ * Finds entry of given name or creates new one.
+ * @return Entry index, ATLAS_ENTRY_MAX if there's no room.
+ */
+static UWORD atlasFindOrCreate(const char *szName) {
+	if(strlen(szName) >= ATLAS_NAME_MAX) {
+		logWrite("ERR: Atlas entry name too long: %s\n", szName);
+		return ATLAS_ENTRY_MAX;
+	}
+	UWORD uwIdx = atlasFind(szName);
+	if(uwIdx == s_uwEntryCount) {
+		if(s_uwEntryCount == ATLAS_ENTRY_MAX) {
+			logWrite("ERR: No room in atlas for %s\n", szName);
+			return ATLAS_ENTRY_MAX;
+		}
+		++s_uwEntryCount;
+		memset(&s_pEntries[uwIdx], 0, sizeof(tAtlasEntry));
+		strcpy(s_pEntries[uwIdx].szName, szName);
+	}
+	return uwIdx;
+}
+
+UBYTE atlasLoad(void) {
+	logBlockBegin("atlasLoad()");
+	atlasDestroy();
+	tFile *pFile = fileOpen("precalc/" ATLAS_PATH, "rb");
+	if(!pFile) {
+		logWrite("WARN: Atlas doesn't exist\n");
+		logBlockEnd("atlasLoad()");
+		return 0;
+	}
+
+	tAtlasHeader sHeader;
+	UBYTE isOk = 0;
+	if(fileRead(pFile, &sHeader, sizeof(tAtlasHeader)) != sizeof(tAtlasHeader)) {
+		logWrite("ERR: Atlas header truncated\n");
+	}
+	else if(
+		memcmp(sHeader.pMagic, s_pMagic, sizeof(s_pMagic)) ||
+		sHeader.uwVersion != ATLAS_VERSION ||
+		sHeader.uwEntryCount > ATLAS_ENTRY_MAX
+	) {
+		logWrite("WARN: Atlas has different version, rebuilding\n");
+	}
+	else {
+		ULONG ulIndexSize = sHeader.uwEntryCount * sizeof(tAtlasEntry);
+		if(sHeader.ulDataSize) {
+			s_pData = memStatsAlloc(
+				MEMSTATS_TAG_PRECALC, sHeader.ulDataSize, MEMF_CHIP
+			);
+			if(s_pData) {
+				s_ulDataSize = sHeader.ulDataSize;
+			}
+		}
+		if(sHeader.ulBlobSize) {
+			s_pBlobData = memAllocFastTagged(
+				MEMSTATS_TAG_PRECALC, sHeader.ulBlobSize
+			);
+			if(s_pBlobData) {
+				s_ulBlobSize = sHeader.ulBlobSize;
+			}
+		}
+		isOk = (
+			s_ulDataSize == sHeader.ulDataSize &&
+			s_ulBlobSize == sHeader.ulBlobSize &&
+			fileRead(pFile, s_pEntries, ulIndexSize) == ulIndexSize &&
+			fileRead(pFile, s_pData, s_ulDataSize) == s_ulDataSize &&
+			fileRead(pFile, s_pBlobData, s_ulBlobSize) == s_ulBlobSize
+		);
+		for(UWORD i = 0; isOk && i < sHeader.uwEntryCount; ++i) {
+			const tAtlasEntry *pEntry = &s_pEntries[i];
+			if(pEntry->ubFlags & ATLAS_FLAG_BLOB) {
+				isOk = (
+					pEntry->ulOffset == ATLAS_BLOB_ALIGN(pEntry->ulOffset) &&
+					pEntry->ulOffset <= s_ulBlobSize &&
+					pEntry->ulSize <= s_ulBlobSize - pEntry->ulOffset
+				);
+			}
+			else {
+				isOk = (
+					pEntry->ubDepth && pEntry->ubDepth <= 8 &&
+					pEntry->ulOffset <= s_ulDataSize &&
+					pEntry->ulSize <= s_ulDataSize - pEntry->ulOffset
+				);
+			}
+			isOk = isOk && pEntry->szName[ATLAS_NAME_MAX - 1] == '\0';
+		}
+		if(isOk) {
+			s_uwEntryCount = sHeader.uwEntryCount;
+		}
+		else {
+			logWrite("ERR: Atlas is malformed\n");
+		}
+	}
+	fileClose(pFile);
+	if(!isOk) {
+		atlasDestroy();
+	}
+	else {
+		logWrite(
+			"Loaded %hu entries, %lu bytes of sheets, %lu bytes of blobs\n",
+			s_uwEntryCount, s_ulDataSize, s_ulBlobSize
+		);
+	}
+	logBlockEnd("atlasLoad()");
+	return isOk;
+}
+
+/**
+ * Finds entry of given kind which is still up to date.
+ * @return Entry index, s_uwEntryCount if there is no such entry.
+ */
+static UWORD atlasFindValid(
+	const char *szName, UWORD uwVersion, UBYTE isBlob, UWORD *pUserData
+) {
+	UWORD uwIdx = atlasFind(szName);
+	if(
+		uwIdx == s_uwEntryCount || s_pEntries[uwIdx].uwVersion != uwVersion ||
+		!(s_pEntries[uwIdx].ubFlags & ATLAS_FLAG_BLOB) != !isBlob ||
+		!cacheIsValidCompiled(szName, ATLAS_PATH, uwVersion)
+	) {
+		return s_uwEntryCount;
+	}
+	if(pUserData) {
+		*pUserData = s_pEntries[uwIdx].uwUserData;
+	}
+	return uwIdx;
+}
+
+tBitMap *atlasGet(const char *szName, UWORD uwVersion, UWORD *pUserData) {
+	UWORD uwIdx = atlasFindValid(szName, uwVersion, 0, pUserData);
+	if(uwIdx == s_uwEntryCount) {
+		return 0;
+	}
+	if(!s_pSheets[uwIdx]) {
+		s_pSheets[uwIdx] = atlasCreateView(&s_pEntries[uwIdx]);
+	}
+	return s_pSheets[uwIdx];
+}
+
+const void *atlasGetBlob(
+	const char *szName, UWORD uwVersion, ULONG *pSize, UWORD *pUserData
+) {
+	UWORD uwIdx = atlasFindValid(szName, uwVersion, 1, pUserData);
+	if(uwIdx == s_uwEntryCount) {
+		return 0;
+	}
+	if(!s_pBlobs[uwIdx]) {
+		s_pBlobs[uwIdx] = &s_pBlobData[s_pEntries[uwIdx].ulOffset];
+	}
+	*pSize = s_pEntries[uwIdx].ulSize;
+	return s_pBlobs[uwIdx];
+}
+
+void atlasAdd(
+	const char *szName, UWORD uwVersion, tBitMap *pBitmap, UWORD uwUserData
+) {
+	UWORD uwIdx = atlasFindOrCreate(szName);
+	if(uwIdx == ATLAS_ENTRY_MAX) {
+		return;
+	}
+	atlasEntryFree(uwIdx, pBitmap);
+
+	tAtlasEntry *pEntry = &s_pEntries[uwIdx];
+	UWORD uwByteWidth = bitmapGetByteWidth(pBitmap);
+	pEntry->uwWidth = uwByteWidth * 8;
+	pEntry->uwHeight = pBitmap->Rows;
+	pEntry->ubDepth = pBitmap->Depth;
+	pEntry->ubFlags = bitmapIsInterleaved(pBitmap) ? BMF_INTERLEAVED : 0;
+	pEntry->ulSize = uwByteWidth * pBitmap->Rows * pBitmap->Depth;
+	pEntry->uwVersion = uwVersion;
+	pEntry->uwUserData = uwUserData;
+	s_pSheets[uwIdx] = pBitmap;
+	s_isDirty = 1;
+}
+
+void atlasAddBlob(
+	const char *szName, UWORD uwVersion, void *pBlob, ULONG ulSize,
+	UWORD uwUserData
+) {
+	UWORD uwIdx = atlasFindOrCreate(szName);
+	if(uwIdx == ATLAS_ENTRY_MAX) {
+		return;
+	}
+	atlasEntryFree(uwIdx, pBlob);
+
+	tAtlasEntry *pEntry = &s_pEntries[uwIdx];
+	pEntry->uwWidth = 0;
+	pEntry->uwHeight = 0;
+	pEntry->ubDepth = 0;
+	pEntry->ubFlags = ATLAS_FLAG_BLOB;
+	pEntry->ulSize = ulSize;
+	pEntry->uwVersion = uwVersion;
+	pEntry->uwUserData = uwUserData;
+	s_pBlobs[uwIdx] = pBlob;
+	s_isDirty = 1;
+}
+
+void atlasSave(void) {
+	if(!s_isDirty) {
+		return;
+	}
+	logBlockBegin("atlasSave()");
+
+	// Entries are written from memory, so make sure that each one is there
+	for(UWORD i = 0; i < s_uwEntryCount; ++i) {
+		if(s_pEntries[i].ubFlags & ATLAS_FLAG_BLOB) {
+			if(!s_pBlobs[i]) {
+				s_pBlobs[i] = &s_pBlobData[s_pEntries[i].ulOffset];
+			}
+		}
+		else if(!s_pSheets[i]) {
+			s_pSheets[i] = atlasCreateView(&s_pEntries[i]);
+			if(!s_pSheets[i]) {
+				logWrite("ERR: Couldn't access sheet %s\n", s_pEntries[i].szName);
+				logBlockEnd("atlasSave()");
+				return;
+			}
+		}
+	}
+
+	tAtlasHeader sHeader;
+	memcpy(sHeader.pMagic, s_pMagic, sizeof(s_pMagic));
+	sHeader.uwVersion = ATLAS_VERSION;
+	sHeader.uwEntryCount = s_uwEntryCount;
+	sHeader.ulDataSize = 0;
+	sHeader.ulBlobSize = 0;
+	for(UWORD i = 0; i < s_uwEntryCount; ++i) {
+		if(s_pEntries[i].ubFlags & ATLAS_FLAG_BLOB) {
+			s_pEntries[i].ulOffset = sHeader.ulBlobSize;
+			sHeader.ulBlobSize = ATLAS_BLOB_ALIGN(
+				sHeader.ulBlobSize + s_pEntries[i].ulSize
+			);
+		}
+		else {
+			s_pEntries[i].ulOffset = sHeader.ulDataSize;
+			sHeader.ulDataSize += s_pEntries[i].ulSize;
+		}
+	}
+
+	tFile *pFile = fileOpen("precalc/" ATLAS_PATH, "wb");
+	if(!pFile) {
+		logWrite("ERR: Couldn't write atlas\n");
+		logBlockEnd("atlasSave()");
+		return;
+	}
+	fileWrite(pFile, &sHeader, sizeof(tAtlasHeader));
+	fileWrite(pFile, s_pEntries, s_uwEntryCount * sizeof(tAtlasEntry));
+	for(UWORD i = 0; i < s_uwEntryCount; ++i) {
+		const tBitMap *pBitmap = s_pSheets[i];
+		if(s_pEntries[i].ubFlags & ATLAS_FLAG_BLOB) {
+			continue;
+		}
+		if(s_pEntries[i].ubFlags & BMF_INTERLEAVED) {
+			fileWrite(pFile, pBitmap->Planes[0], s_pEntries[i].ulSize);
+		}
+		else {
+			ULONG ulPlaneSize = pBitmap->BytesPerRow * pBitmap->Rows;
+			for(UBYTE ubPlane = 0; ubPlane < pBitmap->Depth; ++ubPlane) {
+				fileWrite(pFile, pBitmap->Planes[ubPlane], ulPlaneSize);
+			}
+		}
+	}
+	static const UBYTE pPad[3] = {0};
+	for(UWORD i = 0; i < s_uwEntryCount; ++i) {
+		if(s_pEntries[i].ubFlags & ATLAS_FLAG_BLOB) {
+			ULONG ulSize = s_pEntries[i].ulSize;
+			fileWrite(pFile, s_pBlobs[i], ulSize);
+			fileWrite(pFile, pPad, ATLAS_BLOB_ALIGN(ulSize) - ulSize);
+		}
+	}
+	fileClose(pFile);
+
+	// Atlas size has changed, so all manifest entries need to be refreshed
+	for(UWORD i = 0; i < s_uwEntryCount; ++i) {
+		cacheGenerateChecksumCompiled(
+			s_pEntries[i].szName, ATLAS_PATH, s_pEntries[i].uwVersion
+		);
+	}
+	s_isDirty = 0;
+	logWrite(
+		"Saved %hu entries, %lu bytes of sheets, %lu bytes of blobs\n",
+		s_uwEntryCount, sHeader.ulDataSize, sHeader.ulBlobSize
+	);
+	logBlockEnd("atlasSave()");
+}
+
+void atlasDestroy(void) {
+	for(UWORD i = 0; i < s_uwEntryCount; ++i) {
+		atlasEntryFree(i, 0);
+	}
+	if(s_pData) {
+		memFreeTagged(MEMSTATS_TAG_PRECALC, s_pData, s_ulDataSize);
+		s_pData = 0;
+	}
+	s_ulDataSize = 0;
+	if(s_pBlobData) {
+		memFreeTagged(MEMSTATS_TAG_PRECALC, s_pBlobData, s_ulBlobSize);
+		s_pBlobData = 0;
+	}
+	s_ulBlobSize = 0;
+	s_uwEntryCount = 0;
+	s_isDirty = 0;
+}
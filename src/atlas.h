@@ -0,0 +1,96 @@
+#ifndef GUARD_OF_ATLAS_H
+#define GUARD_OF_ATLAS_H
+
+#include <ace/types.h>
+#include <ace/utils/bitmap.h>
+
+/**
+ * Frame atlas - all precalculated frame sheets in single file, so that they
+ * are loaded with one open & sequential read instead of a file per sheet.
+ * Besides bitmaps it stores blobs, e.g. packed frames, which don't need
+ * to be in CHIP RAM.
+ *
+ * Layout of precalc/frames.atl:
+ * - tAtlasHeader,
+ * - tAtlasEntry for each sheet & blob,
+ * - sheet data, contiguous, each at its entry's offset from data start.
+ *   Interleaved sheets are stored as-is, other ones plane after plane.
+ * - blob data, each at its entry's offset from blob data start, which is
+ *   aligned to 4 bytes.
+ * Written & read on same machine, so no endianness conversion is done.
+ * Bump ATLAS_VERSION on each layout change so that stale files get rebuilt.
+ */
+#define ATLAS_VERSION 3
+#define ATLAS_PATH "frames.atl" ///< Relative to precalc dir.
+#define ATLAS_NAME_MAX 40
+#define ATLAS_ENTRY_MAX 32
+
+/**
+ * Loads atlas index, whole sheet data into CHIP RAM & blobs into FAST RAM.
+ * @return 1 on success, 0 if there is no usable atlas file.
+ */
+UBYTE atlasLoad(void);
+
+/**
+ * Returns sheet stored in atlas if it's still up to date.
+ * @param szName Sheet's source path, relative to data dir.
+ * @param uwVersion Version of generator which produces the sheet.
+ * @param pUserData If non-zero, gets value passed to atlasAdd().
+ * @return View of atlas data or zero if sheet needs to be generated.
+ *         Returned bitmap is owned by atlas.
+ */
+tBitMap *atlasGet(const char *szName, UWORD uwVersion, UWORD *pUserData);
+
+/**
+ * Puts freshly generated sheet into atlas, replacing its previous version.
+ * Atlas takes ownership of bitmap.
+ * @param szName Sheet's source path, relative to data dir.
+ * @param uwVersion Version of generator which produced the sheet.
+ * @param pBitmap Generated sheet.
+ * @param uwUserData Generator-specific value stored along with sheet,
+ *        e.g. its frame layout.
+ */
+void atlasAdd(
+	const char *szName, UWORD uwVersion, tBitMap *pBitmap, UWORD uwUserData
+);
+
+/**
+ * Returns blob stored in atlas if it's still up to date.
+ * @param szName Blob's source path, relative to data dir.
+ * @param uwVersion Version of generator which produces the blob.
+ * @param pSize Gets blob size.
+ * @param pUserData If non-zero, gets value passed to atlasAddBlob().
+ * @return Blob owned by atlas or zero if it needs to be generated.
+ *         It's aligned to 4 bytes.
+ */
+const void *atlasGetBlob(
+	const char *szName, UWORD uwVersion, ULONG *pSize, UWORD *pUserData
+);
+
+/**
+ * Puts freshly generated blob into atlas, replacing its previous version.
+ * Atlas takes ownership of blob.
+ * @param szName Blob's source path, relative to data dir.
+ * @param uwVersion Version of generator which produced the blob.
+ * @param pBlob Blob allocated with memAllocFastTagged(MEMSTATS_TAG_PRECALC).
+ * @param ulSize Size of blob.
+ * @param uwUserData Generator-specific value stored along with blob.
+ */
+void atlasAddBlob(
+	const char *szName, UWORD uwVersion, void *pBlob, ULONG ulSize,
+	UWORD uwUserData
+);
+
+/**
+ * Rewrites atlas file if any sheet was added since load.
+ * Call it once, after all generators ran.
+ */
+void atlasSave(void);
+
+/**
+ * Frees all sheets & blobs - ones returned by atlasGet*() & passed
+ * to atlasAdd*() may no longer be used.
+ */
+void atlasDestroy(void);
+
+#endif // GUARD_OF_ATLAS_H
@@ -0,0 +1,135 @@
+#include "blitstats.h"
+
+#ifdef GAME_DEBUG
+
+#include <string.h>
+#include <ace/managers/log.h>
+
+static tBlitStats s_pStats[BLITSTATS_TAG_COUNT] = {{0}};
+
+static const char *s_pTagNames[BLITSTATS_TAG_COUNT] = {
+	"bobs", "map", "control", "HUD"
+};
+
+// USEx bits of bltcon0, D being lowest one
+#define BLITSTATS_USE_SHIFT 8
+#define BLITSTATS_USE_A 0x8
+#define BLITSTATS_USE_B 0x4
+#define BLITSTATS_USE_C 0x2
+#define BLITSTATS_USE_D 0x1
+
+static void blitStatsAdd(tBlitStats *pStats, UBYTE ubUse, ULONG ulWords) {
+	++pStats->ulBlits;
+	for(UBYTE i = 0; i < BLITSTATS_CHANNEL_COUNT; ++i) {
+		if(ubUse & (BLITSTATS_USE_A >> i)) {
+			pStats->pWords[i] += ulWords;
+		}
+	}
+}
+
+void blitStatsAccount(tBlitStats *pStats, UWORD uwBltCon0, UWORD uwBltSize) {
+	// Zero height & width in bltsize mean max ones
+	UWORD uwRows = uwBltSize >> 6;
+	UWORD uwWords = uwBltSize & 0x3F;
+	if(!uwRows) {
+		uwRows = 1024;
+	}
+	if(!uwWords) {
+		uwWords = 64;
+	}
+	blitStatsAdd(
+		pStats, (uwBltCon0 >> BLITSTATS_USE_SHIFT) & 0xF, (ULONG)uwRows * uwWords
+	);
+}
+
+void blitStartTagged(UBYTE ubTag, UWORD uwBltCon0, UWORD uwBltSize) {
+	g_pCustom->bltsize = uwBltSize;
+	blitStatsAccount(&s_pStats[ubTag], uwBltCon0, uwBltSize);
+}
+
+UBYTE blitRectTagged(
+	UBYTE ubTag, tBitMap *pDst, WORD wX, WORD wY, WORD wWidth, WORD wHeight,
+	UBYTE ubColor
+) {
+	if(!blitRect(pDst, wX, wY, wWidth, wHeight, ubColor)) {
+		return 0;
+	}
+	UWORD uwWords = ((wX & 0xF) + wWidth + 15) >> 4;
+	blitStatsAdd(
+		&s_pStats[ubTag], BLITSTATS_USE_D,
+		(ULONG)uwWords * wHeight * pDst->Depth
+	);
+	return 1;
+}
+
+UBYTE blitCopyTagged(
+	UBYTE ubTag, const tBitMap *pSrc, WORD wSrcX, WORD wSrcY,
+	tBitMap *pDst, WORD wDstX, WORD wDstY, WORD wWidth, WORD wHeight,
+	UBYTE ubMinterm, UBYTE ubMask
+) {
+	if(!blitCopy(
+		pSrc, wSrcX, wSrcY, pDst, wDstX, wDstY, wWidth, wHeight, ubMinterm, ubMask
+	)) {
+		return 0;
+	}
+	UWORD uwWords = (((wDstX & 0xF) + wWidth + 15) >> 4) + 1;
+	blitStatsAdd(
+		&s_pStats[ubTag], BLITSTATS_USE_B | BLITSTATS_USE_C | BLITSTATS_USE_D,
+		(ULONG)uwWords * wHeight * pDst->Depth
+	);
+	return 1;
+}
+
+UBYTE blitCopyAlignedTagged(
+	UBYTE ubTag, const tBitMap *pSrc, WORD wSrcX, WORD wSrcY,
+	tBitMap *pDst, WORD wDstX, WORD wDstY, WORD wWidth, WORD wHeight
+) {
+	if(!blitCopyAligned(
+		pSrc, wSrcX, wSrcY, pDst, wDstX, wDstY, wWidth, wHeight
+	)) {
+		return 0;
+	}
+	UWORD uwWords = (wWidth + 15) >> 4;
+	blitStatsAdd(
+		&s_pStats[ubTag], BLITSTATS_USE_A | BLITSTATS_USE_D,
+		(ULONG)uwWords * wHeight * pDst->Depth
+	);
+	return 1;
+}
+
+void blitStatsReset(void) {
+	memset(s_pStats, 0, sizeof(s_pStats));
+}
+
+ULONG blitStatsGetWords(const tBlitStats *pStats) {
+	ULONG ulWords = 0;
+	for(UBYTE i = 0; i < BLITSTATS_CHANNEL_COUNT; ++i) {
+		ulWords += pStats->pWords[i];
+	}
+	return ulWords;
+}
+
+const tBlitStats *blitStatsGet(UBYTE ubTag) {
+	return &s_pStats[ubTag];
+}
+
+void blitStatsReport(const char *szWhen) {
+	logBlockBegin("blitStatsReport(szWhen: %s)", szWhen);
+	ULONG ulTotalBlits = 0, ulTotalWords = 0;
+	for(FUBYTE fubTag = 0; fubTag < BLITSTATS_TAG_COUNT; ++fubTag) {
+		const tBlitStats *pStats = &s_pStats[fubTag];
+		ULONG ulWords = blitStatsGetWords(pStats);
+		logWrite(
+			"%-8s %7lu blits, %9lu words, A: %lu, B: %lu, C: %lu, D: %lu\n",
+			s_pTagNames[fubTag], pStats->ulBlits, ulWords,
+			pStats->pWords[BLITSTATS_CHANNEL_A], pStats->pWords[BLITSTATS_CHANNEL_B],
+			pStats->pWords[BLITSTATS_CHANNEL_C], pStats->pWords[BLITSTATS_CHANNEL_D]
+		);
+		ulTotalBlits += pStats->ulBlits;
+		ulTotalWords += ulWords;
+	}
+	logWrite("Total: %lu blits, %lu words\n", ulTotalBlits, ulTotalWords);
+	logBlockEnd("blitStatsReport()");
+}
+
+#endif // GAME_DEBUG
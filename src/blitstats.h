@@ -0,0 +1,119 @@
+#ifndef GUARD_OF_BLITSTATS_H
+#define GUARD_OF_BLITSTATS_H
+
+#include <ace/types.h>
+#include <ace/managers/blit.h>
+#include <ace/utils/custom.h>
+
+/**
+ * Blitter workload accounting. Each blit is counted as words moved over
+ * the bus by every enabled channel, same as the blitter's DMA would do it,
+ * so that redraw paths can be compared by blit volume per frame. Counts are
+ * derived from blit sizes while game runs - blits themselves are done by
+ * the blitter, nothing is emulated. Blits are started through *Tagged() wrappers, which blit & account in one
+ * call, same as memAllocFastTagged() does for allocations. Counting is done
+ * only in GAME_DEBUG builds - otherwise wrappers are plain blit calls.
+ */
+
+// Subsystems which get their own blit counters
+#define BLITSTATS_TAG_BOBS 0
+#define BLITSTATS_TAG_MAP 1
+#define BLITSTATS_TAG_CONTROL 2
+#define BLITSTATS_TAG_HUD 3
+#define BLITSTATS_TAG_COUNT 4
+
+#define BLITSTATS_CHANNEL_A 0
+#define BLITSTATS_CHANNEL_B 1
+#define BLITSTATS_CHANNEL_C 2
+#define BLITSTATS_CHANNEL_D 3
+#define BLITSTATS_CHANNEL_COUNT 4
+
+typedef struct _tBlitStats {
+	ULONG ulBlits; ///< Number of started blits.
+	ULONG pWords[BLITSTATS_CHANNEL_COUNT]; ///< Words moved by each channel.
+} tBlitStats;
+
+#ifdef GAME_DEBUG
+
+/**
+ * Adds blit programmed through custom registers to given counters.
+ * @param pStats Counters to be updated, e.g. of single frame.
+ * @param uwBltCon0 Value written to bltcon0, USEx bits are used.
+ * @param uwBltSize Value written to bltsize.
+ */
+void blitStatsAccount(tBlitStats *pStats, UWORD uwBltCon0, UWORD uwBltSize);
+
+/**
+ * Starts blit programmed through custom registers by writing bltsize.
+ * All other registers must be already set.
+ * @param ubTag Subsystem tag, one of BLITSTATS_TAG_*.
+ * @param uwBltCon0 Value written to bltcon0, USEx bits are used.
+ * @param uwBltSize Value to be written to bltsize.
+ */
+void blitStartTagged(UBYTE ubTag, UWORD uwBltCon0, UWORD uwBltSize);
+
+/**
+ * Same as blitRect(), accounted as D channel only, each plane separately.
+ * @param ubTag Subsystem tag, one of BLITSTATS_TAG_*.
+ */
+UBYTE blitRectTagged(
+	UBYTE ubTag, tBitMap *pDst, WORD wX, WORD wY, WORD wWidth, WORD wHeight,
+	UBYTE ubColor
+);
+
+/**
+ * Same as blitCopy(), accounted as B & C->D copy with one more word per row
+ * for shift.
+ * @param ubTag Subsystem tag, one of BLITSTATS_TAG_*.
+ */
+UBYTE blitCopyTagged(
+	UBYTE ubTag, const tBitMap *pSrc, WORD wSrcX, WORD wSrcY,
+	tBitMap *pDst, WORD wDstX, WORD wDstY, WORD wWidth, WORD wHeight,
+	UBYTE ubMinterm, UBYTE ubMask
+);
+
+/**
+ * Same as blitCopyAligned(), accounted as A->D copy.
+ * @param ubTag Subsystem tag, one of BLITSTATS_TAG_*.
+ */
+UBYTE blitCopyAlignedTagged(
+	UBYTE ubTag, const tBitMap *pSrc, WORD wSrcX, WORD wSrcY,
+	tBitMap *pDst, WORD wDstX, WORD wDstY, WORD wWidth, WORD wHeight
+);
+
+void blitStatsReset(void);
+
+const tBlitStats *blitStatsGet(UBYTE ubTag);
+
+/**
+ * @return Total words moved by all channels.
+ */
+ULONG blitStatsGetWords(const tBlitStats *pStats);
+
+/**
+ * Writes blit count & moved words of each subsystem to log.
+ * @param szWhen Short description of the moment when report is made.
+ */
+void blitStatsReport(const char *szWhen);
+
+#else
+
+#define blitStartTagged(ubTag, uwBltCon0, uwBltSize) \
+	((void)(uwBltCon0), g_pCustom->bltsize = (uwBltSize))
+#define blitRectTagged(ubTag, pDst, wX, wY, wWidth, wHeight, ubColor) \
+	blitRect(pDst, wX, wY, wWidth, wHeight, ubColor)
+#define blitCopyTagged( \
+	ubTag, pSrc, wSrcX, wSrcY, pDst, wDstX, wDstY, wWidth, wHeight, \
+	ubMinterm, ubMask \
+) blitCopy( \
+	pSrc, wSrcX, wSrcY, pDst, wDstX, wDstY, wWidth, wHeight, ubMinterm, ubMask \
+)
+#define blitCopyAlignedTagged( \
+	ubTag, pSrc, wSrcX, wSrcY, pDst, wDstX, wDstY, wWidth, wHeight \
+) blitCopyAligned(pSrc, wSrcX, wSrcY, pDst, wDstX, wDstY, wWidth, wHeight)
+#define blitStatsReset()
+#define blitStatsReport(szWhen)
+
+#endif // GAME_DEBUG
+
+#endif // GUARD_OF_BLITSTATS_H
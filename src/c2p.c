@@ -0,0 +1,92 @@
+#include "c2p.h"
+
+/**
+ * Transposes 8x8 bit matrix, rows being bytes from MSB of ulHi to LSB
+ * of ulLo. Bit 7 of each byte is column 0.
+ * See Hacker's Delight, section 7-3.
+ */
+static inline void c2pTranspose8(ULONG *pHi, ULONG *pLo) {
+	ULONG ulHi = *pHi, ulLo = *pLo, ulTmp;
+
+	// Swap bits in 2x2 blocks, then 2x2 blocks in 4x4 ones
+	ulTmp = (ulHi ^ (ulHi >> 7)) & 0x00AA00AA;
+	ulHi ^= ulTmp ^ (ulTmp << 7);
+	ulTmp = (ulLo ^ (ulLo >> 7)) & 0x00AA00AA;
+	ulLo ^= ulTmp ^ (ulTmp << 7);
+	ulTmp = (ulHi ^ (ulHi >> 14)) & 0x0000CCCC;
+	ulHi ^= ulTmp ^ (ulTmp << 14);
+	ulTmp = (ulLo ^ (ulLo >> 14)) & 0x0000CCCC;
+	ulLo ^= ulTmp ^ (ulTmp << 14);
+
+	// Swap 4x4 blocks between halves
+	ulTmp = (ulHi & 0xF0F0F0F0) | ((ulLo >> 4) & 0x0F0F0F0F);
+	*pLo = ((ulHi << 4) & 0xF0F0F0F0) | (ulLo & 0x0F0F0F0F);
+	*pHi = ulTmp;
+}
+
+void c2pChunkyToBitmap(
+	const UBYTE *pChunky, tBitMap *pDst,
+	UWORD uwX, UWORD uwY, UWORD uwWidth, UWORD uwHeight
+) {
+	UBYTE ubDepth = pDst->Depth;
+	for(UWORD y = 0; y < uwHeight; ++y) {
+		ULONG ulOffs = (uwY + y) * pDst->BytesPerRow + (uwX >> 3);
+		for(UWORD x = 0; x < uwWidth; x += 8) {
+			// Pixel 0 is top row, so that plane 7 ends up there after transpose
+			ULONG ulHi = (
+				((ULONG)pChunky[0] << 24) | ((ULONG)pChunky[1] << 16) |
+				((ULONG)pChunky[2] << 8) | pChunky[3]
+			);
+			ULONG ulLo = (
+				((ULONG)pChunky[4] << 24) | ((ULONG)pChunky[5] << 16) |
+				((ULONG)pChunky[6] << 8) | pChunky[7]
+			);
+			pChunky += 8;
+			c2pTranspose8(&ulHi, &ulLo);
+			UBYTE pPlanes[8] = {
+				ulLo, ulLo >> 8, ulLo >> 16, ulLo >> 24,
+				ulHi, ulHi >> 8, ulHi >> 16, ulHi >> 24
+			};
+			for(UBYTE ubPlane = 0; ubPlane < ubDepth; ++ubPlane) {
+				pDst->Planes[ubPlane][ulOffs] = pPlanes[ubPlane];
+			}
+			++ulOffs;
+		}
+	}
+}
+
+void c2pBitmapToChunky(
+	const tBitMap *pSrc, UBYTE *pChunky,
+	UWORD uwX, UWORD uwY, UWORD uwWidth, UWORD uwHeight
+) {
+	UBYTE ubDepth = pSrc->Depth;
+	for(UWORD y = 0; y < uwHeight; ++y) {
+		ULONG ulOffs = (uwY + y) * pSrc->BytesPerRow + (uwX >> 3);
+		for(UWORD x = 0; x < uwWidth; x += 8) {
+			// Plane 7 is top row, so that pixel 0 ends up there after transpose
+			UBYTE pPlanes[8] = {0};
+			for(UBYTE ubPlane = 0; ubPlane < ubDepth; ++ubPlane) {
+				pPlanes[ubPlane] = pSrc->Planes[ubPlane][ulOffs];
+			}
+			ULONG ulHi = (
+				((ULONG)pPlanes[7] << 24) | ((ULONG)pPlanes[6] << 16) |
+				((ULONG)pPlanes[5] << 8) | pPlanes[4]
+			);
+			ULONG ulLo = (
+				((ULONG)pPlanes[3] << 24) | ((ULONG)pPlanes[2] << 16) |
+				((ULONG)pPlanes[1] << 8) | pPlanes[0]
+			);
+			c2pTranspose8(&ulHi, &ulLo);
+			pChunky[0] = ulHi >> 24;
+			pChunky[1] = ulHi >> 16;
+			pChunky[2] = ulHi >> 8;
+			pChunky[3] = ulHi;
+			pChunky[4] = ulLo >> 24;
+			pChunky[5] = ulLo >> 16;
+			pChunky[6] = ulLo >> 8;
+			pChunky[7] = ulLo;
+			pChunky += 8;
+			++ulOffs;
+		}
+	}
+}
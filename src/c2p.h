@@ -0,0 +1,43 @@
+#ifndef GUARD_OF_C2P_H
+#define GUARD_OF_C2P_H
+
+#include <ace/types.h>
+#include <ace/utils/bitmap.h>
+
+/**
+ * Chunky <-> planar conversion for precalc, same results as ACE's
+ * chunkyToBitmap() & chunkyFromBitmap() but 8 pixels at a time: their bits
+ * form 8x8 bit matrix which gets transposed within two ULONGs, yielding
+ * byte of each plane. Up to 8 bitplanes are supported.
+ * Both fns require uwX & uwWidth to be multiples of 8.
+ */
+
+/**
+ * Writes chunky pixels to bitmap.
+ * @param pChunky Source pixels, uwWidth per row.
+ * @param pDst Destination bitmap.
+ * @param uwX Destination X, multiple of 8.
+ * @param uwY Destination Y.
+ * @param uwWidth Width of converted area, multiple of 8.
+ * @param uwHeight Height of converted area.
+ */
+void c2pChunkyToBitmap(
+	const UBYTE *pChunky, tBitMap *pDst,
+	UWORD uwX, UWORD uwY, UWORD uwWidth, UWORD uwHeight
+);
+
+/**
+ * Reads bitmap pixels as chunky ones.
+ * @param pSrc Source bitmap.
+ * @param pChunky Destination pixels, uwWidth per row.
+ * @param uwX Source X, multiple of 8.
+ * @param uwY Source Y.
+ * @param uwWidth Width of converted area, multiple of 8.
+ * @param uwHeight Height of converted area.
+ */
+void c2pBitmapToChunky(
+	const tBitMap *pSrc, UBYTE *pChunky,
+	UWORD uwX, UWORD uwY, UWORD uwWidth, UWORD uwHeight
+);
+
+#endif // GUARD_OF_C2P_H
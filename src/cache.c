@@ -1,50 +1,278 @@
 #include "cache.h"
-#include "adler32.h"
+#include <string.h>
+#include <dos/dos.h>
+#include <clib/dos_protos.h>
 #include <ace/managers/log.h>
+#include <ace/managers/memory.h>
+#include <ace/managers/system.h>
 #include <ace/utils/file.h>
+#include "adler32.h"
+#include "memstats.h"
 
-UBYTE cacheIsValid(const char *szPath) {
-	char szFullPath[100];
+#define CACHE_MANIFEST_PATH "precalc/manifest"
+#define CACHE_MANIFEST_VERSION 1
+#define CACHE_MANIFEST_ALLOC_STEP 16
+#define CACHE_PATH_MAX 100
+
+/**
+ * Manifest entry - describes state of source file when its cached
+ * version was generated.
+ */
+typedef struct _tCacheEntry {
+	char szPath[CACHE_PATH_MAX];         ///< Source, relative to data dir.
+	char szCompiledPath[CACHE_PATH_MAX]; ///< Output, relative to precalc dir.
+	tCacheStamp sStamp;                  ///< Of source file.
+	ULONG ulAdler;                       ///< Of source file.
+	ULONG ulCompiledSize;
+	UWORD uwVersion;                     ///< Of generator.
+	UWORD uwPad;
+} tCacheEntry;
+
+static tCacheEntry *s_pEntries = 0;
+static UWORD s_uwEntryCount = 0;
+static UWORD s_uwEntryAlloc = 0;
+static UBYTE s_isManifestLoaded = 0;
+static UBYTE s_isManifestDirty = 0; ///< Set when manifest needs to be saved.
 
-	// Check for precalc
-	sprintf(szFullPath, "precalc/%s.adl", szPath);
-	tFile *pChecksumFile = fileOpen(szFullPath, "rb");
-	if(!pChecksumFile) {
-		logWrite("WARN: Checksum doesn't exist!\n");
+static UBYTE cacheManifestGrow(void) {
+	UWORD uwNewAlloc = s_uwEntryAlloc + CACHE_MANIFEST_ALLOC_STEP;
+	tCacheEntry *pNew = memAllocFastTagged(
+		MEMSTATS_TAG_PRECALC, uwNewAlloc * sizeof(tCacheEntry)
+	);
+	if(!pNew) {
 		return 0;
 	}
-	ULONG ulAdlerPrev;
-	fileRead(pChecksumFile, &ulAdlerPrev, sizeof(ULONG));
-	fileClose(pChecksumFile);
+	if(s_pEntries) {
+		memcpy(pNew, s_pEntries, s_uwEntryCount * sizeof(tCacheEntry));
+		memFreeTagged(
+			MEMSTATS_TAG_PRECALC, s_pEntries, s_uwEntryAlloc * sizeof(tCacheEntry)
+		);
+	}
+	s_pEntries = pNew;
+	s_uwEntryAlloc = uwNewAlloc;
+	return 1;
+}
 
-	// Check if cached file exists
-	sprintf(szFullPath, "precalc/%s", szPath);
-	tFile *pFile = fileOpen(szFullPath, "rb");
+static void cacheManifestLoad(void) {
+	s_isManifestLoaded = 1;
+	tFile *pFile = fileOpen(CACHE_MANIFEST_PATH, "rb");
 	if(!pFile) {
+		logWrite("WARN: Cache manifest doesn't exist\n");
+		return;
+	}
+	UWORD uwVersion = 0, uwCount = 0;
+	fileRead(pFile, &uwVersion, sizeof(UWORD));
+	fileRead(pFile, &uwCount, sizeof(UWORD));
+	if(uwVersion != CACHE_MANIFEST_VERSION) {
+		logWrite("WARN: Cache manifest version %hu, rebuilding\n", uwVersion);
+		fileClose(pFile);
+		return;
+	}
+	while(s_uwEntryAlloc < uwCount) {
+		if(!cacheManifestGrow()) {
+			fileClose(pFile);
+			return;
+		}
+	}
+	ULONG ulSize = uwCount * sizeof(tCacheEntry);
+	if(uwCount && fileRead(pFile, s_pEntries, ulSize) == ulSize) {
+		s_uwEntryCount = uwCount;
+	}
+	fileClose(pFile);
+}
+
+static void cacheManifestSave(void) {
+	tFile *pFile = fileOpen(CACHE_MANIFEST_PATH, "wb");
+	if(!pFile) {
+		logWrite("ERR: Couldn't write cache manifest\n");
+		return;
+	}
+	UWORD uwVersion = CACHE_MANIFEST_VERSION;
+	fileWrite(pFile, &uwVersion, sizeof(UWORD));
+	fileWrite(pFile, &s_uwEntryCount, sizeof(UWORD));
+	fileWrite(pFile, s_pEntries, s_uwEntryCount * sizeof(tCacheEntry));
+	fileClose(pFile);
+	s_isManifestDirty = 0;
+}
+
+static tCacheEntry *cacheManifestFind(const char *szPath) {
+	if(!s_isManifestLoaded) {
+		cacheManifestLoad();
+	}
+	for(UWORD i = 0; i < s_uwEntryCount; ++i) {
+		if(!strcmp(s_pEntries[i].szPath, szPath)) {
+			return &s_pEntries[i];
+		}
+	}
+	return 0;
+}
+
+UBYTE cacheIsValid(const char *szPath, UWORD uwVersion) {
+	return cacheIsValidCompiled(szPath, szPath, uwVersion);
+}
+
+UBYTE cacheIsValidCompiled(
+	const char *szPath, const char *szCompiledPath, UWORD uwVersion
+) {
+	tCacheEntry *pEntry = cacheManifestFind(szPath);
+	if(!pEntry) {
+		logWrite("WARN: No manifest entry for %s\n", szPath);
+		return 0;
+	}
+	if(
+		pEntry->uwVersion != uwVersion ||
+		strcmp(pEntry->szCompiledPath, szCompiledPath)
+	) {
+		logWrite("WARN: Cache of %s made by other generator\n", szPath);
+		return 0;
+	}
+
+	// Check if cached file is still there & wasn't truncated
+	char szFullPath[100];
+	tCacheStamp sStamp;
+	sprintf(szFullPath, "precalc/%s", szCompiledPath);
+	systemUse();
+	UBYTE isOk = (
+		cacheGetStamp(szFullPath, &sStamp) &&
+		sStamp.ulSize == pEntry->ulCompiledSize
+	);
+	systemUnuse();
+	if(!isOk) {
 		logWrite("WARN: Cached file doesn't exist!\n");
 		return 0;
 	}
-	fileClose(pFile);
 
-	// Calc source file checksum
+	// Source with unchanged size & date doesn't need to be rehashed
 	sprintf(szFullPath, "data/%s", szPath);
-	ULONG ulAdlerCurr = adler32file(szFullPath);
-
-	// Check if adler is same
-	if(ulAdlerCurr == ulAdlerPrev) {
+	systemUse();
+	isOk = cacheGetStamp(szFullPath, &sStamp);
+	systemUnuse();
+	if(!isOk) {
+		return 0;
+	}
+	if(cacheStampsEqual(&sStamp, &pEntry->sStamp)) {
 		return 1;
 	}
-	logWrite("WARN: Adler mismatch for %s!\n", szPath);
-	return 0;
+	if(adler32file(szFullPath) != pEntry->ulAdler) {
+		logWrite("WARN: Adler mismatch for %s!\n", szPath);
+		return 0;
+	}
+
+	// Contents are same, e.g. file got touched or copied - skip rehash
+	// next time
+	pEntry->sStamp = sStamp;
+	s_isManifestDirty = 1;
+	return 1;
+}
+
+void cacheGenerateChecksum(const char *szPath, UWORD uwVersion) {
+	cacheGenerateChecksumCompiled(szPath, szPath, uwVersion);
 }
 
-void cacheGenerateChecksum(const char *szPath) {
+void cacheGenerateChecksumCompiled(
+	const char *szPath, const char *szCompiledPath, UWORD uwVersion
+) {
+	if(
+		strlen(szPath) >= CACHE_PATH_MAX ||
+		strlen(szCompiledPath) >= CACHE_PATH_MAX
+	) {
+		logWrite("ERR: Path too long for cache manifest: %s\n", szPath);
+		return;
+	}
+	tCacheEntry *pEntry = cacheManifestFind(szPath);
+	if(!pEntry) {
+		if(s_uwEntryCount >= s_uwEntryAlloc && !cacheManifestGrow()) {
+			logWrite("ERR: No room for cache manifest entry\n");
+			return;
+		}
+		pEntry = &s_pEntries[s_uwEntryCount++];
+		memset(pEntry, 0, sizeof(tCacheEntry));
+		strcpy(pEntry->szPath, szPath);
+	}
+	strcpy(pEntry->szCompiledPath, szCompiledPath);
+	pEntry->uwVersion = uwVersion;
+
 	char szFullPath[100];
+	tCacheStamp sCompiledStamp;
+	systemUse();
+	sprintf(szFullPath, "precalc/%s", szCompiledPath);
+	if(!cacheGetStamp(szFullPath, &sCompiledStamp)) {
+		sCompiledStamp.ulSize = 0;
+	}
+	pEntry->ulCompiledSize = sCompiledStamp.ulSize;
 	sprintf(szFullPath, "data/%s", szPath);
-	ULONG ulAdler = adler32file(szFullPath);
+	cacheGetStamp(szFullPath, &pEntry->sStamp);
+	systemUnuse();
+	pEntry->ulAdler = adler32file(szFullPath);
+	s_isManifestDirty = 1;
+}
+
+void cacheManifestFlush(void) {
+	if(s_isManifestDirty) {
+		cacheManifestSave();
+	}
+}
+
+void cacheManifestDestroy(void) {
+	if(s_pEntries) {
+		memFreeTagged(
+			MEMSTATS_TAG_PRECALC, s_pEntries, s_uwEntryAlloc * sizeof(tCacheEntry)
+		);
+		s_pEntries = 0;
+	}
+	s_uwEntryCount = 0;
+	s_uwEntryAlloc = 0;
+	s_isManifestLoaded = 0;
+	s_isManifestDirty = 0;
+}
+
+UBYTE cacheGetStamp(const char *szPath, tCacheStamp *pStamp) {
+	BPTR pLock = Lock((STRPTR)szPath, ACCESS_READ);
+	if(!pLock) {
+		return 0;
+	}
+	// FileInfoBlock must be longword-aligned - AllocDosObject() isn't in KS1.3
+	struct FileInfoBlock *pInfo = memAllocFastTagged(
+		MEMSTATS_TAG_PRECALC, sizeof(struct FileInfoBlock)
+	);
+	if(!pInfo) {
+		logWrite("ERR: Couldn't allocate FileInfoBlock\n");
+		UnLock(pLock);
+		return 0;
+	}
+	UBYTE isOk = Examine(pLock, pInfo) ? 1 : 0;
+	if(isOk) {
+		pStamp->ulSize = pInfo->fib_Size;
+		pStamp->ulDays = pInfo->fib_Date.ds_Days;
+		pStamp->ulMinute = pInfo->fib_Date.ds_Minute;
+		pStamp->ulTick = pInfo->fib_Date.ds_Tick;
+	}
+	memFreeTagged(MEMSTATS_TAG_PRECALC, pInfo, sizeof(struct FileInfoBlock));
+	UnLock(pLock);
+	return isOk;
+}
+
+UBYTE cacheCreateDir(const char *szPath) {
+	systemUse();
+	BPTR pLock = Lock((STRPTR)szPath, ACCESS_READ);
+	if(!pLock) {
+		// Returns exclusive lock on new dir
+		pLock = CreateDir((STRPTR)szPath);
+	}
+	if(pLock) {
+		UnLock(pLock);
+	}
+	systemUnuse();
+	if(!pLock) {
+		logWrite("ERR: Couldn't create dir %s\n", szPath);
+		return 0;
+	}
+	return 1;
+}
 
-	sprintf(szFullPath, "precalc/%s.adl", szPath);
-	FILE *pChecksumFile = fileOpen(szFullPath, "wb");
-	fileWrite(pChecksumFile, &ulAdler, sizeof(ULONG));
-	fileClose(pChecksumFile);
+UBYTE cacheStampsEqual(const tCacheStamp *pA, const tCacheStamp *pB) {
+	return (
+		pA->ulSize == pB->ulSize && pA->ulDays == pB->ulDays &&
+		pA->ulMinute == pB->ulMinute && pA->ulTick == pB->ulTick
+	);
 }
@@ -3,8 +3,92 @@
 
 #include <ace/types.h>
 
-UBYTE cacheIsValid(const char *szPath);
+/**
+ * File size & modification date, for cheap "has it changed" checks.
+ */
+typedef struct _tCacheStamp {
+	ULONG ulSize;
+	ULONG ulDays;   ///< Modification date, as in DateStamp.
+	ULONG ulMinute;
+	ULONG ulTick;
+} tCacheStamp;
 
-void cacheGenerateChecksum(const char *szPath);
+/**
+ * Checks if file generated from data/szPath to precalc/szPath is up to date.
+ * @param szPath Source file path, relative to data dir.
+ * @param uwVersion Version of generator which produces the cached file.
+ * @return 1 if cached file may be used, otherwise 0.
+ */
+UBYTE cacheIsValid(const char *szPath, UWORD uwVersion);
+
+/**
+ * Checks if file generated from data/szPath is up to date when it's stored
+ * under different name than its source.
+ * Source is rehashed only if its size or modification date differ from
+ * ones stored in manifest.
+ * @param szPath Source file path, relative to data dir.
+ * @param szCompiledPath Generated file path, relative to precalc dir.
+ * @param uwVersion Version of generator which produces the cached file.
+ * Entries made by other generator version are treated as stale.
+ * @return 1 if generated file exists & source matches manifest, otherwise 0.
+ */
+UBYTE cacheIsValidCompiled(
+	const char *szPath, const char *szCompiledPath, UWORD uwVersion
+);
+
+/**
+ * Records source file's state in manifest after its cached file got
+ * generated to precalc/szPath.
+ * @param szPath Source file path, relative to data dir.
+ * @param uwVersion Version of generator which produced the cached file.
+ */
+void cacheGenerateChecksum(const char *szPath, UWORD uwVersion);
+
+/**
+ * Same as cacheGenerateChecksum(), but for cached file stored under
+ * different name than its source.
+ * @param szPath Source file path, relative to data dir.
+ * @param szCompiledPath Generated file path, relative to precalc dir.
+ * @param uwVersion Version of generator which produced the cached file.
+ */
+void cacheGenerateChecksumCompiled(
+	const char *szPath, const char *szCompiledPath, UWORD uwVersion
+);
+
+/**
+ * Writes manifest to disk if any entry has changed since it was last saved.
+ * Entries are only updated in memory, so this should be called once after
+ * batch of generated files, e.g. at the end of precalc.
+ */
+void cacheManifestFlush(void);
+
+/**
+ * Releases manifest kept in memory since first cache check.
+ * Unsaved changes are lost - call cacheManifestFlush() first.
+ */
+void cacheManifestDestroy(void);
+
+/**
+ * Reads file's size & modification date without reading its contents.
+ * Uses dos.library, so OS must be enabled by the caller.
+ * @param szPath Path to file.
+ * @param pStamp Stamp to be filled.
+ * @return 1 on success, 0 if file couldn't be examined.
+ */
+UBYTE cacheGetStamp(const char *szPath, tCacheStamp *pStamp);
+
+/**
+ * Creates directory for generated files unless it already exists.
+ * Parent directory must exist.
+ * @param szPath Directory path, e.g. "precalc/maps".
+ * @return 1 if directory exists or got created, otherwise 0.
+ */
+UBYTE cacheCreateDir(const char *szPath);
+
+/**
+ * Compares two file stamps.
+ * @return 1 if stamps are identical, otherwise 0.
+ */
+UBYTE cacheStampsEqual(const tCacheStamp *pA, const tCacheStamp *pB);
 
 #endif // _OF_CACHE_H_
@@ -0,0 +1,240 @@
+#include "framepack.h"
+#include <string.h>
+#include <ace/macros.h>
+#include <ace/managers/log.h>
+#include "memstats.h"
+
+#define FRAMEPACK_SKIP_MAX 0x80
+#define FRAMEPACK_LITERAL_MAX 0x80
+
+static inline ULONG *framePackGetOffsets(const tFramePack *pPack) {
+	return (ULONG*)&pPack[1];
+}
+
+static inline UBYTE *framePackGetData(const tFramePack *pPack) {
+	return (UBYTE*)&framePackGetOffsets(pPack)[pPack->ubFrameCount + 1];
+}
+
+/**
+ * Encodes XOR of two frames.
+ * @param pCurr Frame to be encoded.
+ * @param pPrev Previous frame or zero if it's a keyframe.
+ * @param uwSize Frame size in bytes.
+ * @param pOut Output buffer, may be zero to only calculate encoded size.
+ * @return Encoded size.
+ */
+static ULONG framePackEncode(
+	const UBYTE *pCurr, const UBYTE *pPrev, UWORD uwSize, UBYTE *pOut
+) {
+	ULONG ulOutSize = 0;
+	UWORD uwPos = 0;
+	while(uwPos < uwSize) {
+		// Zeros up to end of frame are implied by end of stream
+		UWORD uwZeros = 0;
+		while(
+			uwPos + uwZeros < uwSize &&
+			pCurr[uwPos + uwZeros] == (pPrev ? pPrev[uwPos + uwZeros] : 0)
+		) {
+			++uwZeros;
+		}
+		if(uwPos + uwZeros == uwSize) {
+			break;
+		}
+		if(uwZeros >= 2) {
+			while(uwZeros) {
+				UBYTE ubCount = MIN(uwZeros, FRAMEPACK_SKIP_MAX);
+				if(pOut) {
+					pOut[ulOutSize] = ubCount - 1;
+				}
+				++ulOutSize;
+				uwPos += ubCount;
+				uwZeros -= ubCount;
+			}
+			continue;
+		}
+
+		// Gather literals until next run of unchanged bytes
+		UBYTE ubCount = 0;
+		while(uwPos + ubCount < uwSize && ubCount < FRAMEPACK_LITERAL_MAX) {
+			UWORD uwNext = uwPos + ubCount;
+			if(
+				uwNext + 1 < uwSize &&
+				pCurr[uwNext] == (pPrev ? pPrev[uwNext] : 0) &&
+				pCurr[uwNext + 1] == (pPrev ? pPrev[uwNext + 1] : 0)
+			) {
+				break;
+			}
+			++ubCount;
+		}
+		if(pOut) {
+			pOut[ulOutSize] = 0x7F + ubCount;
+			for(UBYTE i = 0; i < ubCount; ++i) {
+				pOut[ulOutSize + 1 + i] = (
+					pCurr[uwPos + i] ^ (pPrev ? pPrev[uwPos + i] : 0)
+				);
+			}
+		}
+		ulOutSize += 1 + ubCount;
+		uwPos += ubCount;
+	}
+	return ulOutSize;
+}
+
+/**
+ * Encodes all frames of sheet.
+ * @param pFrames First frame of sheet.
+ * @param pPack Pack with filled header. If data isn't allocated yet, only
+ *        size of frame data is calculated.
+ * @param isAllocated 1 if offsets & data should be written.
+ * @return Size of frame data.
+ */
+static ULONG framePackEncodeAll(
+	const UBYTE *pFrames, tFramePack *pPack, UBYTE isAllocated
+) {
+	ULONG ulDataSize = 0;
+	UWORD uwFrameSize = pPack->uwFrameSize;
+	for(UBYTE i = 0; i < pPack->ubFrameCount; ++i) {
+		const UBYTE *pCurr = &pFrames[i * uwFrameSize];
+		const UBYTE *pPrev = (i % pPack->ubKeyInterval) ? pCurr - uwFrameSize : 0;
+		UBYTE *pOut = 0;
+		if(isAllocated) {
+			framePackGetOffsets(pPack)[i] = ulDataSize;
+			pOut = &framePackGetData(pPack)[ulDataSize];
+		}
+		ulDataSize += framePackEncode(pCurr, pPrev, uwFrameSize, pOut);
+	}
+	if(isAllocated) {
+		framePackGetOffsets(pPack)[pPack->ubFrameCount] = ulDataSize;
+	}
+	return ulDataSize;
+}
+
+tFramePack *framePackCreate(
+	const tBitMap *pSheet, UWORD uwFrameHeight, ULONG *pSize
+) {
+	// Frames need to be contiguous
+	if(pSheet->Depth > 1 && !bitmapIsInterleaved(pSheet)) {
+		logWrite("ERR: Only interleaved sheets can be packed\n");
+		return 0;
+	}
+	UWORD uwFrameCount = pSheet->Rows / uwFrameHeight;
+	ULONG ulFrameSize = (ULONG)pSheet->BytesPerRow * uwFrameHeight;
+	if(!uwFrameCount || uwFrameCount > 0xFF || ulFrameSize > 0xFFFF) {
+		logWrite(
+			"ERR: Can't pack %hu frames of %lu bytes\n", uwFrameCount, ulFrameSize
+		);
+		return 0;
+	}
+
+	tFramePack sHeader;
+	sHeader.uwFrameSize = ulFrameSize;
+	sHeader.uwBytesPerRow = pSheet->BytesPerRow;
+	sHeader.uwFrameHeight = uwFrameHeight;
+	sHeader.ubFrameCount = uwFrameCount;
+	sHeader.ubKeyInterval = FRAMEPACK_KEY_INTERVAL;
+	ULONG ulDataSize = framePackEncodeAll(pSheet->Planes[0], &sHeader, 0);
+	ULONG ulSize = (
+		sizeof(tFramePack) + (uwFrameCount + 1) * sizeof(ULONG) + ulDataSize
+	);
+	tFramePack *pPack = memAllocFastTagged(MEMSTATS_TAG_PRECALC, ulSize);
+	if(!pPack) {
+		logWrite("ERR: Couldn't allocate frame pack\n");
+		return 0;
+	}
+	*pPack = sHeader;
+	framePackEncodeAll(pSheet->Planes[0], pPack, 1);
+	*pSize = ulSize;
+	return pPack;
+}
+
+UBYTE framePackIsValid(const tFramePack *pPack, ULONG ulSize) {
+	if(
+		ulSize < sizeof(tFramePack) || !pPack->ubFrameCount ||
+		!pPack->ubKeyInterval || !pPack->uwFrameHeight ||
+		pPack->uwFrameSize != pPack->uwBytesPerRow * pPack->uwFrameHeight
+	) {
+		return 0;
+	}
+	ULONG ulHeadSize = (
+		sizeof(tFramePack) + (pPack->ubFrameCount + 1) * sizeof(ULONG)
+	);
+	if(ulSize < ulHeadSize) {
+		return 0;
+	}
+	const ULONG *pOffsets = framePackGetOffsets(pPack);
+	const UBYTE *pData = framePackGetData(pPack);
+	if(pOffsets[0] || pOffsets[pPack->ubFrameCount] != ulSize - ulHeadSize) {
+		return 0;
+	}
+
+	// Walk each frame so that decoding may skip bound checks
+	for(UBYTE i = 0; i < pPack->ubFrameCount; ++i) {
+		if(pOffsets[i + 1] < pOffsets[i]) {
+			return 0;
+		}
+		ULONG ulPos = 0;
+		for(ULONG ulSrc = pOffsets[i]; ulSrc < pOffsets[i + 1];) {
+			UBYTE ubCtl = pData[ulSrc++];
+			if(ubCtl < 0x80) {
+				ulPos += ubCtl + 1;
+			}
+			else {
+				ulPos += ubCtl - 0x7F;
+				ulSrc += ubCtl - 0x7F;
+				if(ulSrc > pOffsets[i + 1]) {
+					return 0;
+				}
+			}
+		}
+		if(ulPos > pPack->uwFrameSize) {
+			return 0;
+		}
+	}
+	return 1;
+}
+
+/**
+ * XORs encoded frame onto destination.
+ */
+static void framePackApply(
+	const tFramePack *pPack, UBYTE ubFrame, UBYTE *pDst
+) {
+	const ULONG *pOffsets = framePackGetOffsets(pPack);
+	const UBYTE *pSrc = &framePackGetData(pPack)[pOffsets[ubFrame]];
+	const UBYTE *pEnd = &framePackGetData(pPack)[pOffsets[ubFrame + 1]];
+	while(pSrc < pEnd) {
+		UBYTE ubCtl = *pSrc++;
+		if(ubCtl < 0x80) {
+			pDst += ubCtl + 1;
+		}
+		else {
+			UBYTE ubCount = ubCtl - 0x7F;
+			do {
+				*pDst++ ^= *pSrc++;
+			} while(--ubCount);
+		}
+	}
+}
+
+void framePackDecode(const tFramePack *pPack, UBYTE ubFrame, UBYTE *pDst) {
+	UBYTE ubKey = ubFrame - (ubFrame % pPack->ubKeyInterval);
+	memset(pDst, 0, pPack->uwFrameSize);
+	for(UBYTE i = ubKey; i <= ubFrame; ++i) {
+		framePackApply(pPack, i, pDst);
+	}
+}
+
+UBYTE framePackStep(
+	const tFramePack *pPack, UBYTE ubFrom, UBYTE ubTo, UBYTE *pDst
+) {
+	// Delta of frame turns previous frame into it and vice versa
+	if(ubTo == ubFrom + 1 && ubTo % pPack->ubKeyInterval) {
+		framePackApply(pPack, ubTo, pDst);
+		return 1;
+	}
+	if(ubFrom == ubTo + 1 && ubFrom % pPack->ubKeyInterval) {
+		framePackApply(pPack, ubFrom, pDst);
+		return 1;
+	}
+	return 0;
+}
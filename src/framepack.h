@@ -0,0 +1,70 @@
+#ifndef GUARD_OF_FRAMEPACK_H
+#define GUARD_OF_FRAMEPACK_H
+
+#include <ace/types.h>
+#include <ace/utils/bitmap.h>
+
+/**
+ * Packed frame sheet. Every ubKeyInterval-th frame is a keyframe, others
+ * are stored as XOR with previous frame, so that only changed bytes take
+ * space. Each frame is then run-length encoded as sequence of:
+ * - 0x00..0x7F: skip next (n+1) bytes, since they're unchanged,
+ * - 0x80..0xFF: XOR next (n-0x7F) bytes with ones following control byte.
+ * Keyframes are XORed with zeroed frame, so decoding is same for all.
+ *
+ * Frames are stored in interleaved layout, same as in source sheet.
+ * Whole pack is single allocation: this header, ULONG offset of each frame
+ * and one past last, then frame data.
+ */
+typedef struct _tFramePack {
+	UWORD uwFrameSize;   ///< Decoded frame size in bytes.
+	UWORD uwBytesPerRow; ///< Of decoded frame, all planes included.
+	UWORD uwFrameHeight;
+	UBYTE ubFrameCount;
+	UBYTE ubKeyInterval;
+} tFramePack;
+
+#define FRAMEPACK_KEY_INTERVAL 4
+
+/**
+ * Packs interleaved frame sheet.
+ * @param pSheet Sheet with frames one below another.
+ * @param uwFrameHeight Height of single frame.
+ * @param pSize Gets size of whole pack.
+ * @return Pack allocated with memAllocFastTagged(MEMSTATS_TAG_PRECALC),
+ *         zero on failure.
+ */
+tFramePack *framePackCreate(
+	const tBitMap *pSheet, UWORD uwFrameHeight, ULONG *pSize
+);
+
+/**
+ * Checks if pack's offsets & frame data lie within its size.
+ * @param pPack Pack to be checked, e.g. after being read from file.
+ * @param ulSize Size of whole pack.
+ * @return 1 if pack may be decoded, otherwise 0.
+ */
+UBYTE framePackIsValid(const tFramePack *pPack, ULONG ulSize);
+
+/**
+ * Decodes frame, starting from its keyframe.
+ * @param pPack Pack to be decoded.
+ * @param ubFrame Frame index.
+ * @param pDst Destination of uwFrameSize bytes.
+ */
+void framePackDecode(const tFramePack *pPack, UBYTE ubFrame, UBYTE *pDst);
+
+/**
+ * Turns adjacent frame into requested one by applying single delta.
+ * @param pPack Pack to be decoded.
+ * @param ubFrom Index of frame currently held in pDst.
+ * @param ubTo Index of requested frame.
+ * @param pDst Frame to be updated.
+ * @return 1 on success, 0 if frames aren't in same keyframe group
+ *         or aren't adjacent - use framePackDecode() then.
+ */
+UBYTE framePackStep(
+	const tFramePack *pPack, UBYTE ubFrom, UBYTE ubTo, UBYTE *pDst
+);
+
+#endif // GUARD_OF_FRAMEPACK_H
@@ -4,14 +4,14 @@
 #include "gamestates/game/player.h"
 #include "gamestates/game/gamemath.h"
 #include "gamestates/game/ai/bot.h"
+#include "gamestates/game/game.h"
 
 // Cost is almost wall/turret hp
 #define TURRET_COST 5
 #define WALL_COST 5
 
 // Costs
-static UWORD **s_pNodeConnectionCosts;
-static UBYTE **s_pTileCosts;
+static tGrid s_sNodeConnectionCosts; ///< UWORD, column per source node.
 
 // Nodes
 tAiNode g_pNodes[AI_MAX_NODES];
@@ -19,7 +19,7 @@ tAiNode *g_pCaptureNodes[AI_MAX_CAPTURE_NODES];
 FUBYTE g_fubNodeCount;
 FUBYTE g_fubCaptureNodeCount;
 
-static void aiGraphAddNode(FUBYTE fubX, FUBYTE fubY, FUBYTE fubNodeType) {
+static void aiGraphAddNode(tTilePos uwX, tTilePos uwY, FUBYTE fubNodeType) {
 	// Check for overflow
 	if(g_fubNodeCount >= AI_MAX_NODES) {
 		logWrite("ERR: No more room for nodes\n");
@@ -28,12 +28,12 @@ static void aiGraphAddNode(FUBYTE fubX, FUBYTE fubY, FUBYTE fubNodeType) {
 
 	// Check for duplicates
 	for(FUBYTE i = 0; i != g_fubNodeCount; ++i)
-		if(g_pNodes[i].fubX == fubX && g_pNodes[i].fubY == fubY)
+		if(g_pNodes[i].uwX == uwX && g_pNodes[i].uwY == uwY)
 			return;
 
 	// Add node
-	g_pNodes[g_fubNodeCount].fubX = fubX;
-	g_pNodes[g_fubNodeCount].fubY = fubY;
+	g_pNodes[g_fubNodeCount].uwX = uwX;
+	g_pNodes[g_fubNodeCount].uwY = uwY;
 	g_pNodes[g_fubNodeCount].fubType = fubNodeType;
 	g_pNodes[g_fubNodeCount].fubIdx = g_fubNodeCount;
 
@@ -43,53 +43,64 @@ static void aiGraphAddNode(FUBYTE fubX, FUBYTE fubY, FUBYTE fubNodeType) {
 			logWrite("ERR: No more room for capture nodes\n");
 		else {
 			g_pCaptureNodes[g_fubCaptureNodeCount] = &g_pNodes[g_fubNodeCount];
-			g_pNodes[g_fubNodeCount].pControlPoint = controlPointGetAt(fubX, fubY);
+			g_pNodes[g_fubNodeCount].pControlPoint = controlPointGetAt(uwX, uwY);
 			++g_fubCaptureNodeCount;
 		}
 	}
 	++g_fubNodeCount;
 }
 
+/**
+ * Returns logic tile, treating anything past map edges as wall so that
+ * neighbour checks at edges don't need separate guards.
+ */
+static UBYTE aiLogicAt(WORD wX, WORD wY) {
+	if(wX < 0 || wY < 0 || wX >= g_sMap.uwWidth || wY >= g_sMap.uwHeight) {
+		return MAP_LOGIC_WALL;
+	}
+	return mapLogicAt(wX, wY);
+}
+
 static FUBYTE aiGraphGenerateMapNodes(void) {
 	// Get all nodes on map
-	for(FUBYTE x = 0; x < g_sMap.fubWidth; ++x) {
-		for(FUBYTE y = 0; y < g_sMap.fubHeight; ++y) {
+	for(tTilePos x = 0; x < g_sMap.uwWidth; ++x) {
+		for(tTilePos y = 0; y < g_sMap.uwHeight; ++y) {
 			if(
-				g_sMap.pData[x][y].ubIdx == MAP_LOGIC_CAPTURE0 ||
-				g_sMap.pData[x][y].ubIdx == MAP_LOGIC_CAPTURE1 ||
-				g_sMap.pData[x][y].ubIdx == MAP_LOGIC_CAPTURE2
+				mapLogicAt(x, y) == MAP_LOGIC_CAPTURE0 ||
+				mapLogicAt(x, y) == MAP_LOGIC_CAPTURE1 ||
+				mapLogicAt(x, y) == MAP_LOGIC_CAPTURE2
 			) {
 				// Capture points
 				aiGraphAddNode(x,y, AI_NODE_TYPE_CAPTURE);
 			}
 			else if(
-				g_sMap.pData[x][y].ubIdx == MAP_LOGIC_SPAWN0 ||
-				g_sMap.pData[x][y].ubIdx == MAP_LOGIC_SPAWN1 ||
-				g_sMap.pData[x][y].ubIdx == MAP_LOGIC_SPAWN2
+				mapLogicAt(x, y) == MAP_LOGIC_SPAWN0 ||
+				mapLogicAt(x, y) == MAP_LOGIC_SPAWN1 ||
+				mapLogicAt(x, y) == MAP_LOGIC_SPAWN2
 			) {
 				// Spawn points
 				aiGraphAddNode(x,y, AI_NODE_TYPE_SPAWN);
 			}
 			else if(
-				g_sMap.pData[x][y].ubIdx == MAP_LOGIC_ROAD &&
-				worldMapIsWall(g_sMap.pData[x-1][y].ubIdx) &&
-				worldMapIsWall(g_sMap.pData[x+1][y].ubIdx)
+				mapLogicAt(x, y) == MAP_LOGIC_ROAD &&
+				worldMapIsWall(aiLogicAt(x-1, y)) &&
+				worldMapIsWall(aiLogicAt(x+1, y))
 			) {
 				// Gate with horizontal walls
-				if(!worldMapIsWall(g_sMap.pData[x-1][y-1].ubIdx) && !worldMapIsWall(g_sMap.pData[x+1][y-1].ubIdx))
+				if(!worldMapIsWall(aiLogicAt(x-1, y-1)) && !worldMapIsWall(aiLogicAt(x+1, y-1)))
 					aiGraphAddNode(x,y-1, AI_NODE_TYPE_ROAD);
-				if(!worldMapIsWall(g_sMap.pData[x-1][y+1].ubIdx) && !worldMapIsWall(g_sMap.pData[x+1][y+1].ubIdx))
+				if(!worldMapIsWall(aiLogicAt(x-1, y+1)) && !worldMapIsWall(aiLogicAt(x+1, y+1)))
 					aiGraphAddNode(x,y+1, AI_NODE_TYPE_ROAD);
 			}
 			else if(
-				g_sMap.pData[x][y].ubIdx == MAP_LOGIC_ROAD &&
-				worldMapIsWall(g_sMap.pData[x][y-1].ubIdx) &&
-				worldMapIsWall(g_sMap.pData[x][y+1].ubIdx)
+				mapLogicAt(x, y) == MAP_LOGIC_ROAD &&
+				worldMapIsWall(aiLogicAt(x, y-1)) &&
+				worldMapIsWall(aiLogicAt(x, y+1))
 			) {
 				// Gate with vertical walls
-				if(!worldMapIsWall(g_sMap.pData[x-1][y-1].ubIdx) && !worldMapIsWall(g_sMap.pData[x-1][y+1].ubIdx))
+				if(!worldMapIsWall(aiLogicAt(x-1, y-1)) && !worldMapIsWall(aiLogicAt(x-1, y+1)))
 					aiGraphAddNode(x-1,y, AI_NODE_TYPE_ROAD);
-				if(!worldMapIsWall(g_sMap.pData[x+1][y-1].ubIdx) && !worldMapIsWall(g_sMap.pData[x+1][y+1].ubIdx))
+				if(!worldMapIsWall(aiLogicAt(x+1, y-1)) && !worldMapIsWall(aiLogicAt(x+1, y+1)))
 					aiGraphAddNode(x+1,y, AI_NODE_TYPE_ROAD);
 			}
 			// TODO this won't work if e.g. horizontal gate is adjacent to vertical wall
@@ -103,16 +114,16 @@ static FUBYTE aiGraphGenerateMapNodes(void) {
 }
 
 static UWORD aiCalcCostBetweenNodes(tAiNode *pFrom, tAiNode *pTo) {
-	BYTE bDeltaX = (BYTE)(pTo->fubX - pFrom->fubX);
-	BYTE bDeltaY = (BYTE)(pTo->fubY - pFrom->fubY);
-	if(!bDeltaX && !bDeltaY)
+	WORD wDeltaX = (WORD)(pTo->uwX - pFrom->uwX);
+	WORD wDeltaY = (WORD)(pTo->uwY - pFrom->uwY);
+	if(!wDeltaX && !wDeltaY)
 		return 0;
 	const fix16_t fHalf = fix16_one>>1;
-	fix16_t fFineX = fix16_from_int((pFrom->fubX << MAP_TILE_SIZE) + MAP_HALF_TILE) + fHalf;
-	fix16_t fFineY = fix16_from_int((pFrom->fubY << MAP_TILE_SIZE) + MAP_HALF_TILE) + fHalf;
+	fix16_t fFineX = fix16_from_int((pFrom->uwX << MAP_TILE_SIZE) + MAP_HALF_TILE) + fHalf;
+	fix16_t fFineY = fix16_from_int((pFrom->uwY << MAP_TILE_SIZE) + MAP_HALF_TILE) + fHalf;
 	UBYTE ubAngle = getAngleBetweenPoints(
-		(UWORD)(pFrom->fubX << MAP_TILE_SIZE), (UWORD)(pFrom->fubY << MAP_TILE_SIZE),
-		(UWORD)(pTo->fubX << MAP_TILE_SIZE), (UWORD)(pTo->fubY << MAP_TILE_SIZE)
+		(UWORD)(pFrom->uwX << MAP_TILE_SIZE), (UWORD)(pFrom->uwY << MAP_TILE_SIZE),
+		(UWORD)(pTo->uwX << MAP_TILE_SIZE), (UWORD)(pTo->uwY << MAP_TILE_SIZE)
 	);
 	tBCoordYX sPtA = {
 		.bX = (BYTE)fix16_to_int(10 * csin(ubAngle)),
@@ -122,36 +133,36 @@ static UWORD aiCalcCostBetweenNodes(tAiNode *pFrom, tAiNode *pTo) {
 		.bX = (BYTE)fix16_to_int(-10 * csin(ubAngle)),
 		.bY = (BYTE)fix16_to_int(-10 * ccos(ubAngle))
 	};
-	FUBYTE fubStart, fubStop;
+	tTilePos uwStart, uwStop;
 	fix16_t fDx, fDy;
-	if(ABS(bDeltaX) > ABS(bDeltaY)) {
-		fDx = fix16_from_int(SGN(bDeltaX)*MAP_FULL_TILE);
-		fDy = fix16_from_int(bDeltaY*MAP_FULL_TILE) / ABS(bDeltaX);
-		fubStart = MIN(pFrom->fubX, pTo->fubX);
-		fubStop = MAX(pFrom->fubX, pTo->fubX);
+	if(ABS(wDeltaX) > ABS(wDeltaY)) {
+		fDx = fix16_from_int(SGN(wDeltaX)*MAP_FULL_TILE);
+		fDy = fix16_from_int(wDeltaY*MAP_FULL_TILE) / ABS(wDeltaX);
+		uwStart = MIN(pFrom->uwX, pTo->uwX);
+		uwStop = MAX(pFrom->uwX, pTo->uwX);
 	}
 	else {
-		fDx = fix16_from_int(bDeltaX*MAP_FULL_TILE) / ABS(bDeltaY);
-		fDy = fix16_from_int(SGN(bDeltaY)*MAP_FULL_TILE);
-		fubStart = MIN(pFrom->fubY, pTo->fubY);
-		fubStop = MAX(pFrom->fubY, pTo->fubY);
+		fDx = fix16_from_int(wDeltaX*MAP_FULL_TILE) / ABS(wDeltaY);
+		fDy = fix16_from_int(SGN(wDeltaY)*MAP_FULL_TILE);
+		uwStart = MIN(pFrom->uwY, pTo->uwY);
+		uwStop = MAX(pFrom->uwY, pTo->uwY);
 	}
 	UWORD uwCost = 0;
-	for(FUBYTE i = fubStart+1; i != fubStop; ++i) {
+	for(tTilePos i = uwStart+1; i != uwStop; ++i) {
 		// Do a step forward
 		fFineX += fDx;
 		fFineY += fDy;
 
 		// Process point A
-		FUBYTE fubChkAX = (FUBYTE)((fix16_to_int(fFineX) + sPtA.bX) >> MAP_TILE_SIZE);
-		FUBYTE fubChkAY = (FUBYTE)((fix16_to_int(fFineY) + sPtA.bY) >> MAP_TILE_SIZE);
-		uwCost += s_pTileCosts[fubChkAX][fubChkAY];
+		tTilePos uwChkAX = (tTilePos)((fix16_to_int(fFineX) + sPtA.bX) >> MAP_TILE_SIZE);
+		tTilePos uwChkAY = (tTilePos)((fix16_to_int(fFineY) + sPtA.bY) >> MAP_TILE_SIZE);
+		uwCost += mapAiCostAt(uwChkAX, uwChkAY);
 
 		// Process point B
-		FUBYTE fubChkBX = (FUBYTE)((fix16_to_int(fFineX) + sPtB.bX) >> MAP_TILE_SIZE);
-		FUBYTE fubChkBY = (FUBYTE)((fix16_to_int(fFineY) + sPtB.bY) >> MAP_TILE_SIZE);
-		if(fubChkBX != fubChkAX || fubChkBY != fubChkAY)
-			uwCost += s_pTileCosts[fubChkBX][fubChkBY];
+		tTilePos uwChkBX = (tTilePos)((fix16_to_int(fFineX) + sPtB.bX) >> MAP_TILE_SIZE);
+		tTilePos uwChkBY = (tTilePos)((fix16_to_int(fFineY) + sPtB.bY) >> MAP_TILE_SIZE);
+		if(uwChkBX != uwChkAX || uwChkBY != uwChkAY)
+			uwCost += mapAiCostAt(uwChkBX, uwChkBY);
 	}
 	return uwCost;
 }
@@ -165,12 +176,22 @@ static void aiGraphCreate(void) {
 	}
 
 	// Create array for connections & calculate costs between nodes
-	s_pNodeConnectionCosts = memAllocFast(sizeof(UWORD*) * g_fubNodeCount);
+	if(!gridCreate(
+		&s_sNodeConnectionCosts, g_pMatchArena, MEMSTATS_TAG_AI,
+		g_fubNodeCount, g_fubNodeCount, sizeof(UWORD), GRID_COLUMN_MAJOR
+	)) {
+		// Bots treat it same as map without nodes
+		logWrite("ERR: Couldn't create AI node graph\n");
+		g_fubNodeCount = 0;
+		g_fubCaptureNodeCount = 0;
+		logBlockEnd("aiGraphCreate()");
+		return;
+	}
 	for(FUBYTE fubFrom = g_fubNodeCount; fubFrom--;) {
-		s_pNodeConnectionCosts[fubFrom] = memAllocFastClear(sizeof(UWORD) * g_fubNodeCount);
+		UWORD *pCostsFrom = gridLine(&s_sNodeConnectionCosts, UWORD, fubFrom);
 		for(FUBYTE fubTo = g_fubNodeCount; fubTo--;) {
 			// logWrite("[%hu -> %hu]\n", fubFrom, fubTo);
-			s_pNodeConnectionCosts[fubFrom][fubTo] = aiCalcCostBetweenNodes(
+			pCostsFrom[fubTo] = aiCalcCostBetweenNodes(
 				&g_pNodes[fubFrom], &g_pNodes[fubTo]
 			);
 		}
@@ -189,44 +210,42 @@ void aiGraphDump(void) {
 	for(FUBYTE fubFrom = 0; fubFrom < g_fubNodeCount; ++fubFrom) {
 		logWrite("%3hu ", fubFrom);
 		for(FUBYTE fubTo = 0; fubTo < g_fubNodeCount; ++fubTo)
-			logWrite("%5hu ", s_pNodeConnectionCosts[fubFrom][fubTo]);
+			logWrite(
+				"%5hu ", gridAt(&s_sNodeConnectionCosts, UWORD, fubFrom, fubTo)
+			);
 		logWrite("\n");
 	}
 	logBlockEnd("aiGraphDump()");
 }
 
-static void aiGraphDestroy(void) {
-	logBlockBegin("aiGraphDestroy()");
-	if(g_fubNodeCount) {
-		for(FUBYTE fubFrom = g_fubNodeCount; fubFrom--;)
-			memFree(s_pNodeConnectionCosts[fubFrom], sizeof(UWORD) * g_fubNodeCount);
-		memFree(s_pNodeConnectionCosts, sizeof(UWORD*) * g_fubNodeCount);
-	}
-	logBlockEnd("aiGraphDestroy()");
-}
 
-static void aiCalcTileCostsFrag(FUBYTE fubX1, FUBYTE fubY1, FUBYTE fubX2, FUBYTE fubY2) {
-	for(FUBYTE x = fubX1; x <= fubX2; ++x) {
-		for(FUBYTE y = fubY1; y <= fubY2; ++y) {
+static void aiCalcTileCostsFrag(
+	tTilePos uwX1, tTilePos uwY1, tTilePos uwX2, tTilePos uwY2
+) {
+	for(tTilePos x = uwX1; x <= uwX2; ++x) {
+		for(tTilePos y = uwY1; y <= uwY2; ++y) {
+			UBYTE *pCost = &mapAiCostAt(x, y);
 			// Check for walls
-			if(g_sMap.pData[x][y].ubIdx == MAP_LOGIC_WATER) {
-				s_pTileCosts[x][y] = 0xFF;
+			if(mapLogicAt(x, y) == MAP_LOGIC_WATER) {
+				*pCost = 0xFF;
 				continue;
 			}
-			if(worldMapIsWall(g_sMap.pData[x][y].ubIdx)) {
-				s_pTileCosts[x][y] = 0xFF;
+			if(worldMapIsWall(mapLogicAt(x, y))) {
+				*pCost = 0xFF;
 				continue;
 			}
 			else {
 				// There should be a minimal cost of transport for finding shortest path
-				s_pTileCosts[x][y] = 1;
+				*pCost = 1;
 			}
 			// Check for turret in range of fire
-			FUBYTE fubTileRange = TURRET_MAX_PROCESS_RANGE_Y >> MAP_TILE_SIZE;
-			for(FUBYTE i = MAX(0, x - fubTileRange); i != MIN(g_sMap.fubWidth, x+fubTileRange); ++i)
-				for(FUBYTE j = MAX(0, y - fubTileRange); j != MIN(g_sMap.fubHeight, y+fubTileRange); ++j)
-					if(g_pTurretTiles[i][j])
-						s_pTileCosts[x][y] += MIN(s_pTileCosts[x][y]+10, 255);
+			WORD wTileRange = TURRET_MAX_PROCESS_RANGE_Y >> MAP_TILE_SIZE;
+			tTilePos uwEndX = MIN(g_sMap.uwWidth, x + wTileRange);
+			tTilePos uwEndY = MIN(g_sMap.uwHeight, y + wTileRange);
+			for(tTilePos i = MAX(0, x - wTileRange); i != uwEndX; ++i)
+				for(tTilePos j = MAX(0, y - wTileRange); j != uwEndY; ++j)
+					if(turretGetAt(i, j) != TURRET_INVALID)
+						*pCost += MIN(*pCost+10, 255);
 		}
 	}
 }
@@ -235,13 +254,13 @@ void aiDumpTileCosts(void) {
 	logBlockBegin("aiDumpTileCosts()");
 	logWrite("Tile costs:\n");
 	logWrite("    ");
-	for(FUBYTE x = 0; x != g_sMap.fubWidth; ++x)
+	for(tTilePos x = 0; x != g_sMap.uwWidth; ++x)
 		logWrite("%3hu ", x);
 	logWrite("\n");
-	for(FUBYTE y = 0; y != g_sMap.fubHeight; ++y) {
+	for(tTilePos y = 0; y != g_sMap.uwHeight; ++y) {
 		logWrite("%3hu ", y);
-		for(FUBYTE x = 0; x != g_sMap.fubWidth; ++x)
-			logWrite("%3hhu ", s_pTileCosts[x][y]);
+		for(tTilePos x = 0; x != g_sMap.uwWidth; ++x)
+			logWrite("%3hhu ", mapAiCostAt(x, y));
 		logWrite("\n");
 	}
 	logBlockEnd("aiDumpTileCosts()");
@@ -249,16 +268,16 @@ void aiDumpTileCosts(void) {
 
 static void aiCalcTileCosts(void) {
 	logBlockBegin("aiCalcTileCosts()");
-	aiCalcTileCostsFrag(0, 0, g_sMap.fubWidth-1, g_sMap.fubHeight-1);
+	aiCalcTileCostsFrag(0, 0, g_sMap.uwWidth-1, g_sMap.uwHeight-1);
 	logBlockEnd("aiCalcTileCosts()");
 }
 
-tAiNode *aiFindClosestNode(FUBYTE fubTileX, FUBYTE fubTileY) {
+tAiNode *aiFindClosestNode(tTilePos uwTileX, tTilePos uwTileY) {
 	UWORD uwClosestDist = 0xFFFF;
 	tAiNode *pClosest = 0;
 	for(FUBYTE i = 0; i != g_fubNodeCount; ++i) {
 		tAiNode *pNode = &g_pNodes[i];
-		UWORD uwDist = ABS(pNode->fubX - fubTileX) + ABS(pNode->fubY - fubTileY);
+		UWORD uwDist = ABS(pNode->uwX - uwTileX) + ABS(pNode->uwY - uwTileY);
 		if(uwDist < uwClosestDist) {
 			uwClosestDist = uwDist;
 			pClosest = pNode;
@@ -268,7 +287,7 @@ tAiNode *aiFindClosestNode(FUBYTE fubTileX, FUBYTE fubTileY) {
 }
 
 UWORD aiGetCostBetweenNodes(tAiNode *pSrc, tAiNode *pDst) {
-	return s_pNodeConnectionCosts[pSrc->fubIdx][pDst->fubIdx];
+	return gridAt(&s_sNodeConnectionCosts, UWORD, pSrc->fubIdx, pDst->fubIdx);
 }
 
 void aiManagerCreate(void) {
@@ -278,10 +297,6 @@ void aiManagerCreate(void) {
 	botManagerCreate(g_ubPlayerLimit);
 
 	// Calculate tile costs
-	s_pTileCosts = memAllocFast(g_sMap.fubWidth * sizeof(UBYTE*));
-	for(FUBYTE x = 0; x != g_sMap.fubWidth; ++x) {
-		s_pTileCosts[x] = memAllocFastClear(g_sMap.fubHeight * sizeof(UBYTE));
-	}
 	aiCalcTileCosts();
 
 	// Create node network
@@ -291,11 +306,7 @@ void aiManagerCreate(void) {
 
 void aiManagerDestroy(void) {
 	logBlockBegin("aiManagerDestroy()");
-	aiGraphDestroy();
+	// Tile & node costs are in match arena
 	botManagerDestroy();
-	for(FUBYTE x = 0; x != g_sMap.fubWidth; ++x) {
-		memFree(s_pTileCosts[x], g_sMap.fubHeight * sizeof(UBYTE));
-	}
-	memFree(s_pTileCosts, g_sMap.fubWidth * sizeof(UBYTE*));
 	logBlockEnd("aiManagerDestroy()");
 }
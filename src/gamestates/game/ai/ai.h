@@ -12,8 +12,8 @@
 #define AI_NODE_TYPE_SPAWN 2
 
 typedef struct _tAiNode {
-	FUBYTE fubY;
-	FUBYTE fubX;
+	tTilePos uwY;
+	tTilePos uwX;
 	FUBYTE fubIdx;
 	FUBYTE fubType;
 	tControlPoint *pControlPoint;
@@ -26,7 +26,7 @@ void aiManagerDestroy(void);
 void aiCalculateTileCosts(void);
 
 void aiCalculateTileCostsFrag(
-	FUBYTE fubX1, FUBYTE fubY1, FUBYTE fubX2, FUBYTE fubY2
+	tTilePos uwX1, tTilePos uwY1, tTilePos uwX2, tTilePos uwY2
 );
 
 void aiGraphDump(void);
@@ -40,11 +40,11 @@ UWORD aiGetCostBetweenNodes(tAiNode *pSrc, tAiNode *pDst);
  * This function doesn't take into account costs to get to given node as it's
  * too costly.
  *
- * @param  fubTileX X-coordinate of tile near which node is to be found.
- * @param  fubTileY Ditto, Y.
+ * @param  uwTileX X-coordinate of tile near which node is to be found.
+ * @param  uwTileY Ditto, Y.
  * @return If found, pointer to closest node, otherwise false.
  */
-tAiNode *aiFindClosestNode(FUBYTE fubTileX, FUBYTE fubTileY);
+tAiNode *aiFindClosestNode(tTilePos uwTileX, tTilePos uwTileY);
 
 
 extern tAiNode g_pNodes[AI_MAX_NODES];
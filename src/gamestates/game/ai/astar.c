@@ -1,18 +1,15 @@
 #include "gamestates/game/ai/astar.h"
 
-tAstarData *astarCreate(void) {
-	tAstarData *pNav = memAllocFast(sizeof(tAstarData));
-	pNav->pFrontier = heapCreate(AI_MAX_NODES*AI_MAX_NODES);
+tAstarData *astarCreate(tArena *pArena) {
+	tAstarData *pNav = arenaAlloc(pArena, MEMSTATS_TAG_AI, sizeof(tAstarData));
+	pNav->pFrontier = heapCreate(pArena, AI_MAX_NODES*AI_MAX_NODES);
 	pNav->ubState = ASTAR_STATE_OFF;
 	return pNav;
 }
 
-void astarDestroy(tAstarData *pNav) {
-	// GCC -O2 heisenbug - hangs if ommited logBlockBegin/End here
-	logBlockBegin("astarDestroy(pNav: %p)", pNav);
-	heapDestroy(pNav->pFrontier);
-	memFree(pNav, sizeof(tAstarData));
-	logBlockEnd("astarDestroy()");
+void astarStop(tAstarData *pNav) {
+	heapClear(pNav->pFrontier);
+	pNav->ubState = ASTAR_STATE_OFF;
 }
 
 void astarStart(tAstarData *pNav, tAiNode *pNodeSrc, tAiNode *pNodeDst) {
@@ -50,8 +47,8 @@ UBYTE astarProcess(tAstarData *pNav) {
 				if(uwCost < pNav->pCostSoFar[pNextNode->fubIdx]) {
 					pNav->pCostSoFar[pNextNode->fubIdx] = uwCost;
 					UWORD uwPriority = uwCost
-						+ ABS(pNextNode->fubX - pNav->pNodeDst->fubX)
-						+ ABS(pNextNode->fubY - pNav->pNodeDst->fubY);
+						+ ABS(pNextNode->uwX - pNav->pNodeDst->uwX)
+						+ ABS(pNextNode->uwY - pNav->pNodeDst->uwY);
 					heapPush(pNav->pFrontier, pNextNode, uwPriority);
 					pNav->pCameFrom[pNextNode->fubIdx] = pNav->pNodeCurr;
 				}
@@ -34,15 +34,17 @@ typedef struct {
 
 /**
  * Allocates data for A* algorithm.
+ * There is no destroy fn - data is released along with arena.
+ * @param pArena Arena from which A* data will be allocated.
  * @return Newly allocated A* data struct.
  */
-tAstarData *astarCreate(void);
+tAstarData *astarCreate(tArena *pArena);
 
 /**
- * Frees A* data structure.
- * @param pNav A* data structure to be freed.
+ * Aborts pathfinding in progress.
+ * @param pNav A* data struct to be used.
  */
-void astarDestroy(tAstarData *pNav);
+void astarStop(tAstarData *pNav);
 
 /**
  * Prepares A* initial conditions.
@@ -2,6 +2,7 @@
 #include <fixmath/fix16.h>
 #include "gamestates/game/spawn.h"
 #include "gamestates/game/ai/astar.h"
+#include "gamestates/game/game.h"
 
 #define AI_BOT_STATE_IDLE           0
 #define AI_BOT_STATE_MOVING_TO_NODE 1
@@ -75,7 +76,9 @@ static void botSay(tBot *pBot, char *szFmt, ...) {
 void botManagerCreate(FUBYTE fubBotLimit) {
 	logBlockBegin("botManagerCreate(fubBotLimit: %"PRI_FUBYTE")", fubBotLimit);
 	s_fubBotCount = 0;
-	s_pBots = memAllocFastClear(sizeof(tBot) * fubBotLimit);
+	s_pBots = arenaAllocClear(
+		g_pMatchArena, MEMSTATS_TAG_AI, sizeof(tBot) * fubBotLimit
+	);
 	s_fubBotLimit = fubBotLimit;
 	botTargetingOrderFlatten();
 	logBlockEnd("botManagerCreate()");
@@ -83,10 +86,8 @@ void botManagerCreate(FUBYTE fubBotLimit) {
 
 void botManagerDestroy(void) {
 	logBlockBegin("botManagerDestroy()");
-	for(UBYTE i = s_fubBotCount; i--;) {
-		astarDestroy(s_pBots[i].pNavData);
-	}
-	memFree(s_pBots, sizeof(tBot) * s_fubBotLimit);
+	// Bots & their A* data are in match arena
+	s_fubBotCount = 0;
 	logBlockEnd("botManagerDestroy()");
 }
 
@@ -104,14 +105,14 @@ void botAdd(const char *szName, UBYTE ubTeam) {
 	pBot->uwNextY = 0;
 	pBot->ubNextAngle = 0;
 	++s_fubBotCount;
-	pBot->pNavData = astarCreate();
+	pBot->pNavData = astarCreate(g_pMatchArena);
 	pBot->pNavData->sRoute.ubCurrNode = 0;
 
 	botSay(pBot, "Ich bin ein computer");
 }
 
 void botRemoveByPtr(tBot *pBot) {
-	astarDestroy(pBot->pNavData);
+	astarStop(pBot->pNavData);
 }
 
 void botRemoveByName(const char *szName) {
@@ -140,8 +141,8 @@ static tAiNode *botFindNewTarget(tBot *pBot, tAiNode *pDestToEvade) {
 		) {
 			tAiNode *pRouteEnd = g_pCaptureNodes[i];
 			botSay(
-				pBot, "New target at %"PRI_FUBYTE",%"PRI_FUBYTE,
-				pRouteEnd->fubX, pRouteEnd->fubY
+				pBot, "New target at %hu,%hu",
+				pRouteEnd->uwX, pRouteEnd->uwY
 			);
 			tAiNode *pRouteStart = aiFindClosestNode(
 				pBot->pPlayer->sVehicle.uwX >> MAP_TILE_SIZE,
@@ -156,8 +157,8 @@ static tAiNode *botFindNewTarget(tBot *pBot, tAiNode *pDestToEvade) {
 	if(pDestToEvade->pControlPoint->fubTeam != pBot->pPlayer->ubTeam) {
 		tAiNode *pRouteEnd = pDestToEvade;
 		botSay(
-			pBot, "New target at %"PRI_FUBYTE",%"PRI_FUBYTE,
-			pRouteEnd->fubX, pRouteEnd->fubY
+			pBot, "New target at %hu,%hu",
+			pRouteEnd->uwX, pRouteEnd->uwY
 		);
 		tAiNode *pRouteStart = aiFindClosestNode(
 			pBot->pPlayer->sVehicle.uwX >> MAP_TILE_SIZE,
@@ -178,9 +179,12 @@ static tTurret *botTargetNearbyTurret(tBot *pBot, UBYTE ubEnemyTeam) {
 	for(UBYTE i = 0; i != BOT_TARGETING_FLAT_SIZE; ++i) {
 		UWORD uwTurretX = (UWORD)(uwBotTileX + pTargetingOrder[i].bX);
 		UWORD uwTurretY = (UWORD)(uwBotTileY + pTargetingOrder[i].bY);
-		if(g_pTurretTiles[uwTurretX][uwTurretY] == TURRET_INVALID)
+		if(uwTurretX >= g_sMap.uwWidth || uwTurretY >= g_sMap.uwHeight)
+			continue;
+		UWORD uwTurretIdx = turretGetAt(uwTurretX, uwTurretY);
+		if(uwTurretIdx == TURRET_INVALID)
 			continue;
-		tTurret *pTurret = &g_pTurrets[g_pTurretTiles[uwTurretX][uwTurretY]];
+		tTurret *pTurret = &g_pTurrets[uwTurretIdx];
 		if(pTurret->ubTeam != ubEnemyTeam)
 			continue;
 		return pTurret;
@@ -233,9 +237,9 @@ static void botProcessDriving(tBot *pBot) {
 				if(!astarProcess(pBot->pNavData))
 					break;
 				tAiNode *pNextNode = pBot->pNavData->sRoute.pNodes[pBot->pNavData->sRoute.ubCurrNode];
-				pBot->uwNextX = (UWORD)((pNextNode->fubX << MAP_TILE_SIZE) + MAP_HALF_TILE);
-				pBot->uwNextY = (UWORD)((pNextNode->fubY << MAP_TILE_SIZE) + MAP_HALF_TILE);
-				botSay(pBot, "Going to %hu,%hu", pNextNode->fubX, pNextNode->fubY);
+				pBot->uwNextX = (UWORD)((pNextNode->uwX << MAP_TILE_SIZE) + MAP_HALF_TILE);
+				pBot->uwNextY = (UWORD)((pNextNode->uwY << MAP_TILE_SIZE) + MAP_HALF_TILE);
+				botSay(pBot, "Going to %hu,%hu", pNextNode->uwX, pNextNode->uwY);
 				pBot->ubTick = 10;
 				pBot->ubState = AI_BOT_STATE_MOVING_TO_NODE;
 			}
@@ -310,13 +314,13 @@ static void botProcessDriving(tBot *pBot) {
 				// Get next node from route
 				--pBot->pNavData->sRoute.ubCurrNode;
 				tAiNode *pNextNode = pBot->pNavData->sRoute.pNodes[pBot->pNavData->sRoute.ubCurrNode];
-				pBot->uwNextX = (UWORD)((pNextNode->fubX << MAP_TILE_SIZE) + MAP_HALF_TILE);
-				pBot->uwNextY = (UWORD)((pNextNode->fubY << MAP_TILE_SIZE) + MAP_HALF_TILE);
+				pBot->uwNextX = (UWORD)((pNextNode->uwX << MAP_TILE_SIZE) + MAP_HALF_TILE);
+				pBot->uwNextY = (UWORD)((pNextNode->uwY << MAP_TILE_SIZE) + MAP_HALF_TILE);
 				pBot->ubTick = 10;
 				pBot->ubState = AI_BOT_STATE_MOVING_TO_NODE;
 				botSay(
 					pBot, "Moving to next pos: %hu, %hu",
-					pNextNode->fubX, pNextNode->fubY
+					pNextNode->uwX, pNextNode->uwY
 				);
 			}
 			break;
@@ -378,7 +382,7 @@ static void botProcessLimbo(tBot *pBot) {
 		tAiNode *pFirstNode = botFindNewTarget(pBot, 0);
 		// Find nearest spawn point
 		pBot->pPlayer->ubSpawnIdx = spawnGetNearest(
-			pFirstNode->fubX, pFirstNode->fubY,
+			pFirstNode->uwX, pFirstNode->uwY,
 			pBot->pPlayer->ubTeam
 		);
 		// After arriving at surface, recalculate where bot is going
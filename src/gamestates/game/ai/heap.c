@@ -1,20 +1,16 @@
 #include "gamestates/game/ai/heap.h"
 #include <ace/managers/log.h>
-#include <ace/managers/memory.h>
 
-tHeap *heapCreate(UWORD uwMaxEntries) {
-	tHeap *pHeap = memAllocFast(sizeof(tHeap));
+tHeap *heapCreate(tArena *pArena, UWORD uwMaxEntries) {
+	tHeap *pHeap = arenaAlloc(pArena, MEMSTATS_TAG_AI, sizeof(tHeap));
 	pHeap->uwMaxEntries = uwMaxEntries;
 	pHeap->uwCount = 0;
-	pHeap->pEntries = memAllocFastClear(uwMaxEntries * sizeof(tHeapEntry));
+	pHeap->pEntries = arenaAllocClear(
+		pArena, MEMSTATS_TAG_AI, uwMaxEntries * sizeof(tHeapEntry)
+	);
 	return pHeap;
 }
 
-void heapDestroy(tHeap *pHeap) {
-	memFree(pHeap->pEntries, pHeap->uwMaxEntries * sizeof(tHeapEntry));
-	memFree(pHeap, sizeof(tHeap));
-}
-
 void heapPush(tHeap *pHeap, void *pData, UWORD uwPriority) {
 	UWORD uwIdx = pHeap->uwCount++;
 	tHeapEntry * const pEntries = pHeap->pEntries;
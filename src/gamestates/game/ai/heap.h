@@ -2,6 +2,7 @@
 #define GUARD_OF_GAMESTATES_GAME_AI_HEAP_H
 
 #include <ace/types.h>
+#include "arena.h"
 
 typedef struct _tHeapEntry {
 	UWORD uwPriority;
@@ -14,9 +15,7 @@ typedef struct _tHeap {
 	tHeapEntry *pEntries;
 } tHeap;
 
-tHeap *heapCreate(UWORD uwMaxEntries);
-
-void heapDestroy(tHeap *pHeap);
+tHeap *heapCreate(tArena *pArena, UWORD uwMaxEntries);
 
 void heapPush(tHeap *pHeap, void *pData, UWORD uwPriority);
 
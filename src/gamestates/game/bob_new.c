@@ -3,16 +3,31 @@
  * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
 
 #include <gamestates/game/bob_new.h>
-#include <ace/managers/memory.h>
+#include <string.h>
+#include <ace/macros.h>
 #include <ace/managers/system.h>
+#include <ace/managers/log.h>
+#include <ace/managers/timer.h>
 #include <ace/utils/custom.h>
+#include <memstats.h>
+#include <blitstats.h>
+
+// Word-aligned rectangle of bg saved in one blit. Overlapping & adjacent bobs
+// share one region, so their bg is saved & restored only once.
+typedef struct _tBobRegion {
+	UWORD uwX; ///< Multiple of 16.
+	UWORD uwY;
+	UWORD uwWords;
+	UWORD uwHeight;
+} tBobRegion;
 
 // Undraw stack must be accessible during adding new bobs, so the most safe
-// approach is to have two lists - undraw list gets populated after draw
+// approach is to have two lists - region list gets populated during bg save
 // and depopulated during undraw
 typedef struct _tBobQueue {
-	UBYTE ubUndrawCount;
+	UBYTE ubRegionCount;
 	tBobNew **pBobs;
+	tBobRegion *pRegions;
 	tBitMap *pBg;
 	tBitMap *pDst;
 } tBobQueue;
@@ -22,6 +37,7 @@ static UBYTE s_ubMaxBobCount;
 
 static UBYTE s_isPushingDone;
 static UBYTE s_ubBpp;
+static tSimpleBufferManager *s_pBfr;
 
 // This can't be a decreasing counter such as in toSave/toDraw since after
 // decrease another bob may be pushed, which would trash bg saving
@@ -31,48 +47,97 @@ static UBYTE s_ubBobsSaved;
 
 tBobQueue s_pQueues[2];
 
+#ifdef GAME_DEBUG
+static tBobNewFrameStats s_pFrameStats[BOB_NEW_STATS_FRAMES];
+static UBYTE s_ubStatsCurr;
+static ULONG s_ulBeginEndTime; ///< When last bobNewBegin() has finished.
+#endif
+
 void bobNewManagerCreate(
-	UBYTE ubMaxBobCount, UWORD uwBgBufferLength,
-	tBitMap *pFront, tBitMap *pBack
+	UBYTE ubMaxBobCount, UWORD uwBgBufferLength, tSimpleBufferManager *pBfr
 ) {
-	s_ubBpp = pFront->Depth;
+	s_pBfr = pBfr;
+	s_ubBpp = pBfr->pFront->Depth;
 	s_ubMaxBobCount = ubMaxBobCount;
 	systemUse();
-	s_pQueues[0].pBobs = memAllocFast(sizeof(tBobNew*) * s_ubMaxBobCount);
-	s_pQueues[1].pBobs = memAllocFast(sizeof(tBobNew*) * s_ubMaxBobCount);
+	s_pQueues[0].pBobs = memAllocFastTagged(
+		MEMSTATS_TAG_BOBS, sizeof(tBobNew*) * s_ubMaxBobCount
+	);
+	s_pQueues[1].pBobs = memAllocFastTagged(
+		MEMSTATS_TAG_BOBS, sizeof(tBobNew*) * s_ubMaxBobCount
+	);
+	s_pQueues[0].pRegions = memAllocFastTagged(
+		MEMSTATS_TAG_BOBS, sizeof(tBobRegion) * s_ubMaxBobCount
+	);
+	s_pQueues[1].pRegions = memAllocFastTagged(
+		MEMSTATS_TAG_BOBS, sizeof(tBobRegion) * s_ubMaxBobCount
+	);
 	s_pQueues[0].pBg = bitmapCreate(16, uwBgBufferLength, s_ubBpp, BMF_INTERLEAVED);
 	s_pQueues[1].pBg = bitmapCreate(16, uwBgBufferLength, s_ubBpp, BMF_INTERLEAVED);
 	systemUnuse();
 
-	s_pQueues[0].pDst = pBack;
-	s_pQueues[1].pDst = pFront;
+	s_pQueues[0].pDst = pBfr->pBack;
+	s_pQueues[1].pDst = pBfr->pFront;
 
 	s_isPushingDone = 0;
 	s_ubBufferCurr = 0;
 	s_ubBobsPushed = 0;
 	s_ubBobsSaved = 0;
 	s_ubBobsDrawn = 0;
-	s_pQueues[0].ubUndrawCount = 0;
-	s_pQueues[1].ubUndrawCount = 0;
+	s_pQueues[0].ubRegionCount = 0;
+	s_pQueues[1].ubRegionCount = 0;
+#ifdef GAME_DEBUG
+	memset(s_pFrameStats, 0, sizeof(s_pFrameStats));
+	s_ubStatsCurr = 0;
+#endif
 }
 
 void bobNewManagerDestroy(void) {
 	blitWait();
 	systemUse();
-	memFree(s_pQueues[0].pBobs, sizeof(tBobNew*) * s_ubMaxBobCount);
-	memFree(s_pQueues[1].pBobs, sizeof(tBobNew*) * s_ubMaxBobCount);
+	memFreeTagged(
+		MEMSTATS_TAG_BOBS, s_pQueues[0].pBobs, sizeof(tBobNew*) * s_ubMaxBobCount
+	);
+	memFreeTagged(
+		MEMSTATS_TAG_BOBS, s_pQueues[1].pBobs, sizeof(tBobNew*) * s_ubMaxBobCount
+	);
+	memFreeTagged(
+		MEMSTATS_TAG_BOBS, s_pQueues[0].pRegions,
+		sizeof(tBobRegion) * s_ubMaxBobCount
+	);
+	memFreeTagged(
+		MEMSTATS_TAG_BOBS, s_pQueues[1].pRegions,
+		sizeof(tBobRegion) * s_ubMaxBobCount
+	);
 	bitmapDestroy(s_pQueues[0].pBg);
 	bitmapDestroy(s_pQueues[1].pBg);
 	systemUnuse();
 }
 
-void bobNewPush(tBobNew *pBob) {
+UBYTE bobNewPush(tBobNew *pBob) {
+	// Culled bob needs no undraw bookkeeping - bg regions are recorded during
+	// save, so its previous position is restored from earlier frame's list.
+	UWORD uwX = pBob->sPos.sUwCoord.uwX;
+	UWORD uwY = pBob->sPos.sUwCoord.uwY;
+	UWORD uwMarginX = MIN(uwX, BOB_NEW_CULL_MARGIN);
+	UWORD uwMarginY = MIN(uwY, BOB_NEW_CULL_MARGIN);
+	if(!simpleBufferIsRectVisible(
+		s_pBfr, uwX - uwMarginX, uwY - uwMarginY,
+		pBob->uwWidth + uwMarginX + BOB_NEW_CULL_MARGIN,
+		pBob->uwHeight + uwMarginY + BOB_NEW_CULL_MARGIN
+	)) {
+#ifdef GAME_DEBUG
+		++s_pFrameStats[s_ubStatsCurr].ubCulled;
+#endif
+		return 0;
+	}
 	tBobQueue *pQueue = &s_pQueues[s_ubBufferCurr];
 	pQueue->pBobs[s_ubBobsPushed] = pBob;
 	++s_ubBobsPushed;
 	if(blitIsIdle()) {
 		bobNewProcessNext();
 	}
+	return 1;
 }
 
 void bobNewInit(
@@ -84,25 +149,135 @@ void bobNewInit(
 	pBob->isUndrawRequired = isUndrawRequired;
 	pBob->pBitmap = pBitMap;
 	pBob->pMask = pMask;
-	UWORD uwBlitWords = (uwWidth+15)/16 + 1; // One word more for aligned copy
-	pBob->_uwBlitSize = ((uwHeight*s_ubBpp) << 6) | uwBlitWords;
-	pBob->_wModuloUndrawSave = bitmapGetByteWidth(s_pQueues[0].pDst) - uwBlitWords*2;
 	pBob->uwOffsetY = 0;
 
 	pBob->sPos.sUwCoord.uwX = uwX;
 	pBob->sPos.sUwCoord.uwY = uwY;
-	pBob->pOldPositions[0].sUwCoord.uwX = uwX;
-	pBob->pOldPositions[0].sUwCoord.uwY = uwY;
-	pBob->pOldPositions[1].sUwCoord.uwX = uwX;
-	pBob->pOldPositions[1].sUwCoord.uwY = uwY;
 }
 
 void bobNewSetBitMapOffset(tBobNew *pBob, UWORD uwOffsetY) {
 	pBob->uwOffsetY = uwOffsetY * pBob->pBitmap->BytesPerRow;
 }
 
+static void bobNewGetRegion(const tBobNew *pBob, tBobRegion *pRegion) {
+	pRegion->uwX = pBob->sPos.sUwCoord.uwX & 0xFFF0;
+	pRegion->uwY = pBob->sPos.sUwCoord.uwY;
+	pRegion->uwWords = (pBob->uwWidth+15)/16 + 1; // One word more for shift
+	pRegion->uwHeight = pBob->uwHeight;
+}
+
+static UBYTE bobNewRegionContains(
+	const tBobRegion *pOuter, const tBobRegion *pInner
+) {
+	return (
+		pOuter->uwX <= pInner->uwX &&
+		pInner->uwX + (pInner->uwWords << 4) <= pOuter->uwX + (pOuter->uwWords << 4) &&
+		pOuter->uwY <= pInner->uwY &&
+		pInner->uwY + pInner->uwHeight <= pOuter->uwY + pOuter->uwHeight
+	);
+}
+
+/**
+ * Extends region so that it covers other one too, but only if bounding box
+ * isn't bigger than both regions blitted separately.
+ * @param pRegion Region to be extended.
+ * @param pOther Region to be merged into pRegion.
+ * @return 1 if regions got merged, otherwise 0.
+ */
+static UBYTE bobNewRegionMerge(tBobRegion *pRegion, const tBobRegion *pOther) {
+	UWORD uwLeft = MIN(pRegion->uwX, pOther->uwX);
+	UWORD uwTop = MIN(pRegion->uwY, pOther->uwY);
+	UWORD uwWords = (MAX(
+		pRegion->uwX + (pRegion->uwWords << 4), pOther->uwX + (pOther->uwWords << 4)
+	) - uwLeft) >> 4;
+	UWORD uwHeight = MAX(
+		pRegion->uwY + pRegion->uwHeight, pOther->uwY + pOther->uwHeight
+	) - uwTop;
+	// Bltsize limits: 6 bits for width, 10 bits for height
+	if(uwWords >= 64 || uwHeight * s_ubBpp >= 1024) {
+		return 0;
+	}
+	ULONG ulMergedArea = uwWords * uwHeight;
+	ULONG ulSeparateArea = (
+		pRegion->uwWords * pRegion->uwHeight + pOther->uwWords * pOther->uwHeight
+	);
+	if(ulMergedArea > ulSeparateArea) {
+		return 0;
+	}
+	pRegion->uwX = uwLeft;
+	pRegion->uwY = uwTop;
+	pRegion->uwWords = uwWords;
+	pRegion->uwHeight = uwHeight;
+	return 1;
+}
+
+static inline UWORD bobNewRegionGetBlitSize(const tBobRegion *pRegion) {
+	return ((pRegion->uwHeight * s_ubBpp) << 6) | pRegion->uwWords;
+}
+
+/**
+ * Starts blit set up in custom registers & accounts it both in bob tag and
+ * in current frame's stats.
+ */
+static inline void bobNewStartBlit(UWORD uwBltCon0, UWORD uwBlitSize) {
+	blitStartTagged(BLITSTATS_TAG_BOBS, uwBltCon0, uwBlitSize);
+#ifdef GAME_DEBUG
+	blitStatsAccount(
+		&s_pFrameStats[s_ubStatsCurr].sBlits, uwBltCon0, uwBlitSize
+	);
+#endif
+}
+
+/**
+ * Saves bg of given bob, unless it's already covered by region saved earlier
+ * in this frame. New region is extended over already pushed bobs which are
+ * to be saved next, so that they get skipped.
+ * @return 1 if save blit was started, otherwise 0.
+ */
+static UBYTE bobNewSaveBg(tBobQueue *pQueue, const tBobNew *pBob) {
+	tBobRegion sRegion;
+	bobNewGetRegion(pBob, &sRegion);
+	for(UBYTE i = 0; i < pQueue->ubRegionCount; ++i) {
+		if(bobNewRegionContains(&pQueue->pRegions[i], &sRegion)) {
+#ifdef GAME_DEBUG
+			++s_pFrameStats[s_ubStatsCurr].ubMerged;
+#endif
+			return 0;
+		}
+	}
+	for(UBYTE i = s_ubBobsSaved; i < s_ubBobsPushed; ++i) {
+		const tBobNew *pNext = pQueue->pBobs[i];
+		if(pNext->isUndrawRequired) {
+			tBobRegion sNext;
+			bobNewGetRegion(pNext, &sNext);
+			bobNewRegionMerge(&sRegion, &sNext);
+		}
+	}
+	pQueue->pRegions[pQueue->ubRegionCount] = sRegion;
+	++pQueue->ubRegionCount;
+
+	ULONG ulSrcOffs = (
+		pQueue->pDst->BytesPerRow * sRegion.uwY + (sRegion.uwX >> 3)
+	);
+	ULONG ulA = (ULONG)(pQueue->pDst->Planes[0]) + ulSrcOffs;
+	UWORD uwBlitSize = bobNewRegionGetBlitSize(&sRegion);
+	g_pCustom->bltamod = (
+		bitmapGetByteWidth(pQueue->pDst) - (sRegion.uwWords << 1)
+	);
+	g_pCustom->bltapt = (APTR)ulA;
+	bobNewStartBlit(USEA|USED | MINTERM_A, uwBlitSize);
+#ifdef GAME_DEBUG
+	++s_pFrameStats[s_ubStatsCurr].ubSaved;
+#endif
+	return 1;
+}
+
 UBYTE bobNewProcessNext(void) {
 	if(s_ubBobsSaved < s_ubBobsPushed) {
+		// Last pushed bob waits for next one, so that they may share bg region
+		if(!s_isPushingDone && s_ubBobsSaved + 1 == s_ubBobsPushed) {
+			return 1;
+		}
 		tBobQueue *pQueue = &s_pQueues[s_ubBufferCurr];
 		if(!s_ubBobsSaved) {
 			// Prepare for saving
@@ -117,18 +292,17 @@ UBYTE bobNewProcessNext(void) {
 			ULONG ulD = (ULONG)(pQueue->pBg->Planes[0]);
 			g_pCustom->bltdpt = (APTR)ulD;
 		}
-		const tBobNew *pBob = pQueue->pBobs[s_ubBobsSaved];
-		++s_ubBobsSaved;
-		if(pBob->isUndrawRequired) {
-			ULONG ulSrcOffs = (
-				pQueue->pDst->BytesPerRow * pBob->sPos.sUwCoord.uwY +
-				pBob->sPos.sUwCoord.uwX/8
-			);
-			ULONG ulA = (ULONG)(pQueue->pDst->Planes[0]) + ulSrcOffs;
-			g_pCustom->bltamod = pBob->_wModuloUndrawSave;
-			g_pCustom->bltapt = (APTR)ulA;
-			g_pCustom->bltsize = pBob->_uwBlitSize;
-		}
+		// Skip bobs which don't need save blit so that blitter isn't left idle
+		do {
+			const tBobNew *pBob = pQueue->pBobs[s_ubBobsSaved];
+			++s_ubBobsSaved;
+			if(pBob->isUndrawRequired && bobNewSaveBg(pQueue, pBob)) {
+				return 1;
+			}
+		} while(
+			s_ubBobsSaved < s_ubBobsPushed &&
+			(s_isPushingDone || s_ubBobsSaved + 1 < s_ubBobsPushed)
+		);
 		return 1;
 	}
 	else {
@@ -190,9 +364,10 @@ UBYTE bobNewProcessNext(void) {
 			g_pCustom->bltbpt = (APTR)ulB;
 			g_pCustom->bltcpt = (APTR)ulCD;
 			g_pCustom->bltdpt = (APTR)ulCD;
-			g_pCustom->bltsize = uwBlitSize;
-
-			pBob->pOldPositions[s_ubBufferCurr].ulYX = pPos->ulYX;
+			bobNewStartBlit(uwBltCon0, uwBlitSize);
+#ifdef GAME_DEBUG
+			++s_pFrameStats[s_ubStatsCurr].ubDrawn;
+#endif
 
 			return 1;
 		}
@@ -202,6 +377,12 @@ UBYTE bobNewProcessNext(void) {
 
 void bobNewBegin(void) {
 	tBobQueue *pQueue = &s_pQueues[s_ubBufferCurr];
+#ifdef GAME_DEBUG
+	ULONG ulStart = timerGetPrec();
+	s_ubStatsCurr = (s_ubStatsCurr + 1) % BOB_NEW_STATS_FRAMES;
+	tBobNewFrameStats *pStats = &s_pFrameStats[s_ubStatsCurr];
+	memset(pStats, 0, sizeof(*pStats));
+#endif
 
 	// Prepare for undraw
 	blitWait();
@@ -217,34 +398,38 @@ void bobNewBegin(void) {
 	UWORD uwDrawnHeight = 0;
 #endif
 
-	for(UBYTE i = 0; i < pQueue->ubUndrawCount; ++i) {
-		const tBobNew *pBob = pQueue->pBobs[i];
-		if(pBob->isUndrawRequired) {
-			// Undraw next
-			ULONG ulDstOffs = (
-				pQueue->pDst->BytesPerRow * pBob->pOldPositions[s_ubBufferCurr].sUwCoord.uwY +
-				pBob->pOldPositions[s_ubBufferCurr].sUwCoord.uwX/8
-			);
-			ULONG ulCD = (ULONG)(pQueue->pDst->Planes[0]) + ulDstOffs;
-			g_pCustom->bltdmod = pBob->_wModuloUndrawSave;
-			g_pCustom->bltdpt = (APTR)ulCD;
-			g_pCustom->bltsize = pBob->_uwBlitSize;
+	// Saved bg is never overdrawn by other bobs, so restore order doesn't matter
+	for(UBYTE i = 0; i < pQueue->ubRegionCount; ++i) {
+		const tBobRegion *pRegion = &pQueue->pRegions[i];
+		ULONG ulDstOffs = (
+			pQueue->pDst->BytesPerRow * pRegion->uwY + (pRegion->uwX >> 3)
+		);
+		ULONG ulCD = (ULONG)(pQueue->pDst->Planes[0]) + ulDstOffs;
+		UWORD uwBlitSize = bobNewRegionGetBlitSize(pRegion);
+		g_pCustom->bltdmod = (
+			bitmapGetByteWidth(pQueue->pDst) - (pRegion->uwWords << 1)
+		);
+		g_pCustom->bltdpt = (APTR)ulCD;
+		bobNewStartBlit(uwBltCon0, uwBlitSize);
 
 #ifdef GAME_DEBUG
-			UWORD uwBlitWords = (pBob->uwWidth+15)/16 + 1;
-			uwDrawnHeight += uwBlitWords * pBob->uwHeight;
+		uwDrawnHeight += pRegion->uwWords * pRegion->uwHeight;
+		++pStats->ubUndrawn;
 #endif
-			blitWait();
-		}
+		blitWait();
 	}
+	pQueue->ubRegionCount = 0;
 #ifdef GAME_DEBUG
-	UWORD uwDrawLimit = s_pQueues[0].pBg->Rows * s_pQueues[0].pBg->Depth;
+	// Bg buffer is one word wide, so each of its rows holds one word per plane
+	UWORD uwDrawLimit = s_pQueues[0].pBg->Rows;
 	if(uwDrawnHeight > uwDrawLimit) {
 		logWrite(
 			"ERR: BG restore out of bounds: used %hu, limit: %hu",
 			uwDrawnHeight, uwDrawLimit
 		);
 	}
+	s_ulBeginEndTime = timerGetPrec();
+	pStats->ulWaitTime = timerGetDelta(ulStart, s_ulBeginEndTime);
 #endif
 	s_ubBobsSaved = 0;
 	s_ubBobsDrawn = 0;
@@ -257,10 +442,72 @@ void bobNewPushingDone(void) {
 }
 
 void bobNewEnd(void) {
+#ifdef GAME_DEBUG
+	ULONG ulStart = timerGetPrec();
+	tBobNewFrameStats *pStats = &s_pFrameStats[s_ubStatsCurr];
+	pStats->ulOverlapTime = timerGetDelta(s_ulBeginEndTime, ulStart);
+#endif
 	bobNewPushingDone();
 	do {
 		blitWait();
 	} while(bobNewProcessNext());
-	s_pQueues[s_ubBufferCurr].ubUndrawCount = s_ubBobsPushed;
 	s_ubBufferCurr = !s_ubBufferCurr;
+#ifdef GAME_DEBUG
+	pStats->ulWaitTime += timerGetDelta(ulStart, timerGetPrec());
+#endif
+}
+
+#ifdef GAME_DEBUG
+
+void bobNewGetAvgStats(tBobNewFrameStats *pAvg) {
+	ULONG pWords[BLITSTATS_CHANNEL_COUNT] = {0};
+	ULONG ulBlits = 0, ulWait = 0, ulOverlap = 0;
+	UWORD uwSaved = 0, uwMerged = 0, uwDrawn = 0, uwUndrawn = 0, uwCulled = 0;
+	for(UBYTE i = 0; i < BOB_NEW_STATS_FRAMES; ++i) {
+		const tBobNewFrameStats *pStats = &s_pFrameStats[i];
+		for(UBYTE ubCh = 0; ubCh < BLITSTATS_CHANNEL_COUNT; ++ubCh) {
+			pWords[ubCh] += pStats->sBlits.pWords[ubCh];
+		}
+		ulBlits += pStats->sBlits.ulBlits;
+		ulWait += pStats->ulWaitTime;
+		ulOverlap += pStats->ulOverlapTime;
+		uwSaved += pStats->ubSaved;
+		uwMerged += pStats->ubMerged;
+		uwDrawn += pStats->ubDrawn;
+		uwUndrawn += pStats->ubUndrawn;
+		uwCulled += pStats->ubCulled;
+	}
+	for(UBYTE ubCh = 0; ubCh < BLITSTATS_CHANNEL_COUNT; ++ubCh) {
+		pAvg->sBlits.pWords[ubCh] = pWords[ubCh] / BOB_NEW_STATS_FRAMES;
+	}
+	pAvg->sBlits.ulBlits = ulBlits / BOB_NEW_STATS_FRAMES;
+	pAvg->ulWaitTime = ulWait / BOB_NEW_STATS_FRAMES;
+	pAvg->ulOverlapTime = ulOverlap / BOB_NEW_STATS_FRAMES;
+	pAvg->ubSaved = uwSaved / BOB_NEW_STATS_FRAMES;
+	pAvg->ubMerged = uwMerged / BOB_NEW_STATS_FRAMES;
+	pAvg->ubDrawn = uwDrawn / BOB_NEW_STATS_FRAMES;
+	pAvg->ubUndrawn = uwUndrawn / BOB_NEW_STATS_FRAMES;
+	pAvg->ubCulled = uwCulled / BOB_NEW_STATS_FRAMES;
 }
+
+void bobNewStatsReport(void) {
+	logBlockBegin("bobNewStatsReport()");
+	for(UBYTE i = 1; i <= BOB_NEW_STATS_FRAMES; ++i) {
+		const tBobNewFrameStats *pStats = &s_pFrameStats[
+			(s_ubStatsCurr + i) % BOB_NEW_STATS_FRAMES
+		];
+		const ULONG *pWords = pStats->sBlits.pWords;
+		logWrite(
+			"saved %3hhu, merged %3hhu, drawn %3hhu, undrawn %3hhu, culled %3hhu, "
+			"words A %5lu B %5lu C %5lu D %5lu, wait %6lu, overlap %6lu\n",
+			pStats->ubSaved, pStats->ubMerged, pStats->ubDrawn, pStats->ubUndrawn,
+			pStats->ubCulled,
+			pWords[BLITSTATS_CHANNEL_A], pWords[BLITSTATS_CHANNEL_B],
+			pWords[BLITSTATS_CHANNEL_C], pWords[BLITSTATS_CHANNEL_D],
+			pStats->ulWaitTime, pStats->ulOverlapTime
+		);
+	}
+	logBlockEnd("bobNewStatsReport()");
+}
+
+#endif // GAME_DEBUG
@@ -7,9 +7,16 @@
 
 #include <ace/types.h>
 #include <ace/managers/blit.h>
+#include <ace/managers/viewport/simplebuffer.h>
+#include <blitstats.h>
+
+// Number of frames kept in stats ring
+#define BOB_NEW_STATS_FRAMES 50
+
+// Bobs this far off camera are still queued - camera moves after pushing.
+#define BOB_NEW_CULL_MARGIN 16
 
 typedef struct _tBobNew {
-	tUwCoordYX pOldPositions[2];
 	tUwCoordYX sPos;
 	UWORD uwWidth;
 	UWORD uwHeight;
@@ -17,19 +24,32 @@ typedef struct _tBobNew {
 	tBitMap *pBitmap;
 	tBitMap *pMask;
 	UWORD uwOffsetY;
-	// Platform-dependent private fields. Don't rely on them externally.
-	UWORD _uwBlitSize;
-	WORD _wModuloUndrawSave;
 } tBobNew;
 
+typedef struct _tBobNewFrameStats {
+	tBlitStats sBlits;   ///< Save, draw & undraw blits.
+	ULONG ulWaitTime;    ///< Spent in bobNewBegin() & bobNewEnd() blit loops.
+	ULONG ulOverlapTime; ///< Between them, when blits run alongside game logic.
+	UBYTE ubSaved;       ///< Bg regions, each covering one or more bobs.
+	UBYTE ubMerged;      ///< Bobs which bg got saved along with other bob's.
+	UBYTE ubDrawn;
+	UBYTE ubUndrawn;     ///< Bg regions restored.
+	UBYTE ubCulled;      ///< Pushed bobs rejected as off-screen.
+} tBobNewFrameStats;
+
 void bobNewManagerCreate(
-	UBYTE ubMaxBobCount, UWORD uwBgBufferLength,
-	tBitMap *pFront, tBitMap *pBack
+	UBYTE ubMaxBobCount, UWORD uwBgBufferLength, tSimpleBufferManager *pBfr
 );
 
 void bobNewManagerDestroy(void);
 
-void bobNewPush(tBobNew *pBob);
+/**
+ * Queues bob for drawing, unless it's off-screen.
+ * Bob's bg from previous draws gets restored regardless of push result.
+ * @param pBob Bob to be drawn at its current position.
+ * @return 1 if bob got queued, 0 if it's culled.
+ */
+UBYTE bobNewPush(tBobNew *pBob);
 
 void bobNewInit(
 	tBobNew *pBob, UWORD uwWidth, UWORD uwHeight, UBYTE isUndrawRequired,
@@ -46,4 +66,20 @@ void bobNewPushingDone(void);
 
 void bobNewEnd(void);
 
+#ifdef GAME_DEBUG
+
+/**
+ * Calculates average stats of last BOB_NEW_STATS_FRAMES frames.
+ * Times are in timerGetPrec() ticks.
+ * @param pAvg Gets averages.
+ */
+void bobNewGetAvgStats(tBobNewFrameStats *pAvg);
+
+/**
+ * Writes stats of each frame in ring to log, oldest first.
+ */
+void bobNewStatsReport(void);
+
+#endif // GAME_DEBUG
+
 #endif // _OF_GAMESTATES_GAME_BOB_NEW_H_
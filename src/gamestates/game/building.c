@@ -36,12 +36,14 @@ tBuilding *buildingGet(UBYTE ubIdx) {
 	return &s_sBuildingManager.pBuildings[ubIdx];
 }
 
-UBYTE buildingAdd(UBYTE ubX, UBYTE ubY, UBYTE ubType, UBYTE ubTeam) {
+UBYTE buildingAdd(
+	tTilePos uwX, tTilePos uwY, UBYTE ubType, UBYTE ubTeam
+) {
 	UBYTE ubIdx;
 
 	logBlockBegin(
-		"buildingAdd(ubX: %hhu, ubY: %hhu, ubType: %hhu, ubTeam: %hhu)",
-		ubX, ubY, ubType, ubTeam
+		"buildingAdd(uwX: %hu, uwY: %hu, ubType: %hhu, ubTeam: %hhu)",
+		uwX, uwY, ubType, ubTeam
 	);
 	if(s_sBuildingManager.ubLastIdx == BUILDING_IDX_LAST)
 		ubIdx = BUILDING_IDX_FIRST;
@@ -54,7 +56,7 @@ UBYTE buildingAdd(UBYTE ubX, UBYTE ubY, UBYTE ubType, UBYTE ubTeam) {
 			s_sBuildingManager.pBuildings[ubIdx].ubType = ubType;
 			if(ubType == BUILDING_TYPE_TURRET)
 				s_sBuildingManager.pBuildings[ubIdx].uwTurretIdx = turretAdd(
-					ubX, ubY,	ubTeam
+					uwX, uwY,	ubTeam
 				);
 			else
 				s_sBuildingManager.pBuildings[ubIdx].uwTurretIdx = TURRET_INVALID;
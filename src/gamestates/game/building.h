@@ -29,7 +29,9 @@ typedef struct {
 
 void buildingManagerReset(void);
 
-UBYTE buildingAdd(UBYTE ubX, UBYTE ubY, UBYTE ubType, UBYTE ubTeam);
+UBYTE buildingAdd(
+	tTilePos uwX, tTilePos uwY, UBYTE ubType, UBYTE ubTeam
+);
 
 UBYTE buildingDamage(UBYTE ubIdx, UBYTE ubDamage);
 
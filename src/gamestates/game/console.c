@@ -4,6 +4,7 @@
 #include "gamestates/game/game.h"
 #include "gamestates/game/hud.h"
 #include "gamestates/game/player.h"
+#include "blitstats.h"
 
 // 210x59
 #define CONSOLE_MAX_ENTRIES 8
@@ -67,14 +68,15 @@ void consoleUpdate(void) {
 		s_pConsoleFont, s_pChatLineBfr, s_sLog.pLog[s_uwToDraw].szMessage
 	)) {
 		// Move remaining messages up
-		blitCopyAligned(
+		blitCopyAlignedTagged(
+			BLITSTATS_TAG_HUD,
 			g_pHudBfr->pBack, 112, 9,
 			g_pHudBfr->pBack, 112, 3,
 			192, 41
 		);
 
 		// Clear last line
-		blitRect(g_pHudBfr->pBack, 112,45, 192, 5, 0);
+		blitRectTagged(BLITSTATS_TAG_HUD, g_pHudBfr->pBack, 112,45, 192, 5, 0);
 
 		// Draw new message
 		fontDrawTextBitMap(
@@ -104,7 +106,7 @@ void consoleChatBegin(void) {
 
 void consoleChatEnd(void) {
 	// Erase chat line
-	blitRect(g_pHudBfr->pBack, 112,51, 192, 5, 0);
+	blitRectTagged(BLITSTATS_TAG_HUD, g_pHudBfr->pBack, 112,51, 192, 5, 0);
 	g_isChatting = 0;
 }
 
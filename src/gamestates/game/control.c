@@ -2,6 +2,7 @@
 #include <ace/macros.h>
 #include <ace/managers/blit.h>
 #include "map.h"
+#include "blitstats.h"
 #include "gamestates/game/turret.h"
 #include "gamestates/game/game.h"
 #include "gamestates/game/console.h"
@@ -17,14 +18,16 @@ static UBYTE s_ubControlPointCount;
 static UBYTE s_ubControlPointMaxCount;
 static UWORD s_uwFrameCounter;
 static UBYTE s_ubAllocSpawnCount;
-static UBYTE s_ubAllocTurretCount;
+static UWORD s_uwAllocTurretCount;
 
 void controlManagerCreate(UBYTE ubPointCount) {
 	logBlockBegin(
 		"controlManagerCreate(ubPointCount: %"PRI_FUBYTE")", ubPointCount
 	);
 	s_ubControlPointMaxCount = ubPointCount;
-	g_pControlPoints = memAllocFastClear(sizeof(tControlPoint) * ubPointCount);
+	g_pControlPoints = arenaAllocClear(
+		g_pMatchArena, MEMSTATS_TAG_MAP, sizeof(tControlPoint) * ubPointCount
+	);
 	s_ubControlPointCount = 0;
 	s_uwFrameCounter = 0;
 	logBlockEnd("controlManagerCreate()");
@@ -32,72 +35,11 @@ void controlManagerCreate(UBYTE ubPointCount) {
 
 void controlManagerDestroy(void) {
 	logBlockBegin("controlManagerDestroy()");
-	for(FUBYTE i = 0; i < s_ubControlPointCount; ++i) {
-		tControlPoint *pPoint = &g_pControlPoints[i];
-		if(pPoint->fubSpawnCount) {
-			memFree(pPoint->pSpawns, pPoint->fubSpawnCount * sizeof(FUBYTE));
-		}
-		if(pPoint->fubTurretCount) {
-			memFree(pPoint->pTurrets, pPoint->fubTurretCount * sizeof(UWORD));
-		}
-	}
-	memFree(g_pControlPoints, sizeof(tControlPoint) * s_ubControlPointMaxCount);
+	// Points and their spawn & turret lists are in match arena
+	s_ubControlPointCount = 0;
 	logBlockEnd("controlManagerDestroy()");
 }
 
-static UBYTE ** controlPolygonMaskCreate(
-	tControlPoint *pPoint, FUBYTE fubPolyPtCnt, tUbCoordYX *pPolyPts,
-	FUBYTE *pX1, FUBYTE *pY1, FUBYTE *pX2, FUBYTE *pY2
-) {
-	logBlockBegin(
-		"controlPolygonMaskCreate(pPoint: %p, fubPolyPtCnt: %"PRI_FUBYTE", "
-		"pPolyPts: %p, pX1: %p, pY1: %p, pX2: %p, pY2: %p)",
-		pPoint, fubPolyPtCnt, pPolyPts, pX1, pY1, pX2, pY2
-	);
-	UBYTE **pMask;
-	pMask = memAllocFast(g_sMap.fubWidth * sizeof(UBYTE*));
-	for(FUBYTE x = 0; x != g_sMap.fubWidth; ++x)
-		pMask[x] = memAllocFastClear(sizeof(UBYTE) * g_sMap.fubHeight);
-
-	*pX1 = 0xFF; *pY1 = 0xFF; *pX2 = 0; *pY2 = 0;
-	for(FUBYTE i = 1; i < fubPolyPtCnt; ++i) {
-		FUBYTE x1 = pPolyPts[i-1].sUbCoord.ubX;
-		FUBYTE y1 = pPolyPts[i-1].sUbCoord.ubY;
-		FUBYTE x2 = pPolyPts[i].sUbCoord.ubX;
-		FUBYTE y2 = pPolyPts[i].sUbCoord.ubY;
-
-		FUBYTE fubStartX = MIN(x1, x2);
-		FUBYTE fubEndX = MAX(x1, x2);
-
-		// Only horizontal lines
-		// TODO: remove this restriction
-		if(y1 == y2) {
-			// Plot on mask
-			for(FUBYTE fubLineX = fubStartX; fubLineX <= fubEndX; ++fubLineX)
-				pMask[fubLineX][y1] = 1;
-		}
-
-		// Polygon bounds
-		*pX1 = MIN(*pX1, fubStartX);
-		*pX2 = MAX(*pX2, fubEndX);
-		*pY1 = MIN(*pY1, y1);
-		*pY2 = MAX(*pY2, y1);
-	}
-	logWrite(
-		"Bounds: %"PRI_FUBYTE",%"PRI_FUBYTE" ; %"PRI_FUBYTE",%"PRI_FUBYTE"\n",
-		*pX1, *pY1, *pX2, *pY2
-	);
-	logBlockEnd("controlPolygonMaskCreate");
-	return pMask;
-}
-
-static void controlPolygonMaskDestroy(UBYTE **pMask) {
-	for(FUBYTE x = 0; x != g_sMap.fubWidth; ++x) {
-		memFree(pMask[x], sizeof(UBYTE) * g_sMap.fubHeight);
-	}
-	memFree(pMask, g_sMap.fubWidth * sizeof(UBYTE*));
-}
-
 static void increaseSpawnCount(
 	UNUSED_ARG tControlPoint *pPoint, UNUSED_ARG FUBYTE fubSpawnIdx
 ) {
@@ -105,87 +47,49 @@ static void increaseSpawnCount(
 }
 
 static void increaseTurretCount(
-	UNUSED_ARG tControlPoint *pPoint, UNUSED_ARG FUBYTE fubTurretIdx
+	UNUSED_ARG tControlPoint *pPoint, UNUSED_ARG FUWORD fuwTurretIdx
 ) {
-	++s_ubAllocTurretCount;
+	++s_uwAllocTurretCount;
 }
 
 static void addSpawn(tControlPoint *pPoint, FUBYTE fubSpawnIdx) {
 	pPoint->pSpawns[pPoint->fubSpawnCount++] = fubSpawnIdx;
 }
 
-static void addTurret(tControlPoint *pPoint, FUBYTE fubTurretIdx) {
-	pPoint->pTurrets[pPoint->fubTurretCount++] = fubTurretIdx;
+static void addTurret(tControlPoint *pPoint, FUWORD fuwTurretIdx) {
+	pPoint->pTurrets[pPoint->fuwTurretCount++] = fuwTurretIdx;
 }
 
-static void controlMaskIterateSpawns(
-	UBYTE **pMask, tControlPoint *pPoint,
-	FUBYTE fubX1, FUBYTE fubY1, FUBYTE fubX2, FUBYTE fubY2,
+static void controlZoneIterateSpawns(
+	tControlPoint *pPoint, UBYTE ubIdx,
 	void (*onFound)(tControlPoint *pPoint, FUBYTE fubSpawnIdx)
 ) {
 	for(FUBYTE i = 0; i < g_ubSpawnCount; ++i) {
-		FUBYTE fubX = g_pSpawns[i].ubTileX;
-		FUBYTE fubY = g_pSpawns[i].ubTileY;
-		if(fubX < fubX1 || fubX > fubX2)
-			continue;
-		FUBYTE isInPoly = 0;
-		for(FUBYTE y = fubY1; y <= fubY2; ++y) {
-			FUBYTE isEdgeProcessed = 0;
-			if(!isInPoly && pMask[fubX][y]) {
-				isInPoly = 1;
-				isEdgeProcessed = 1;
-			}
-
-			if(y == fubY && isInPoly) {
-				onFound(pPoint, i);
-				break;
-			}
-
-			if(isInPoly && pMask[fubX][y] && !isEdgeProcessed) {
-				isInPoly = 0;
-			}
+		if(mapControlAt(g_pSpawns[i].uwTileX, g_pSpawns[i].uwTileY) == ubIdx) {
+			onFound(pPoint, i);
 		}
 	}
 }
 
-static void controlMaskIterateTurrets(
-	UBYTE **pMask, tControlPoint *pPoint,
-	FUBYTE fubX1, FUBYTE fubY1, FUBYTE fubX2, FUBYTE fubY2,
-	void (*onFound)(tControlPoint *pPoint, FUBYTE fubTurretIdx)
+static void controlZoneIterateTurrets(
+	tControlPoint *pPoint, UBYTE ubIdx,
+	void (*onFound)(tControlPoint *pPoint, FUWORD fuwTurretIdx)
 ) {
-	for(FUBYTE i = 0; i < g_uwTurretCount; ++i) {
-		FUBYTE fubX = g_pTurrets[i].uwCenterX >> MAP_TILE_SIZE;
-		FUBYTE fubY = g_pTurrets[i].uwCenterY >> MAP_TILE_SIZE;
-		if(fubX < fubX1 || fubX > fubX2)
-			continue;
-		FUBYTE isInPoly = 0;
-		for(FUBYTE y = fubY1; y <= fubY2; ++y) {
-			FUBYTE isProcessed = 0;
-			if(!isInPoly && pMask[fubX][y]) {
-				isInPoly = 1;
-				isProcessed = 1;
-			}
-
-			if(y == fubY && isInPoly) {
-				onFound(pPoint, i);
-				break;
-			}
-
-			if(isInPoly && pMask[fubX][y] && !isProcessed) {
-				isInPoly = 0;
-			}
+	for(FUWORD i = 0; i < g_uwTurretCount; ++i) {
+		tTilePos uwX = g_pTurrets[i].uwCenterX >> MAP_TILE_SIZE;
+		tTilePos uwY = g_pTurrets[i].uwCenterY >> MAP_TILE_SIZE;
+		if(mapControlAt(uwX, uwY) == ubIdx) {
+			onFound(pPoint, i);
 		}
 	}
 }
 
 void controlAddPoint(
-	char *szName, FUBYTE fubCaptureTileX, FUBYTE fubCaptureTileY,
-	FUBYTE fubPolyPtCnt, tUbCoordYX *pPolyPts
+	const char *szName, tTilePos uwCaptureTileX, tTilePos uwCaptureTileY
 ) {
 	logBlockBegin(
-		"controlAddPoint(szName: %s, fubCaptureTileX: %"PRI_FUBYTE", "
-		"fubCaptureTileY: %"PRI_FUBYTE", fubPolyPtCnt: %"PRI_FUBYTE", pPolyPts: %p)",
-		szName, fubCaptureTileX, fubCaptureTileY, fubPolyPtCnt, pPolyPts
+		"controlAddPoint(szName: %s, uwCaptureTileX: %hu, uwCaptureTileY: %hu)",
+		szName, uwCaptureTileX, uwCaptureTileY
 	);
 	if(s_ubControlPointCount >= s_ubControlPointMaxCount) {
 		logWrite("ERR: No more room for control point %s\n", szName);
@@ -193,37 +97,35 @@ void controlAddPoint(
 	}
 	tControlPoint *pPoint = &g_pControlPoints[s_ubControlPointCount];
 	memcpy(pPoint->szName, szName, MIN(CONTROL_NAME_MAX, strlen(szName)));
-	pPoint->fubTileX = fubCaptureTileX;
-	pPoint->fubTileY = fubCaptureTileY;
-
-	// Plot polygon on mask
-	FUBYTE fubPolyX1, fubPolyY1, fubPolyX2, fubPolyY2;
-	UBYTE **pMask = controlPolygonMaskCreate(
-		pPoint, fubPolyPtCnt, pPolyPts, &fubPolyX1, &fubPolyY1, &fubPolyX2, &fubPolyY2
-	);
+	pPoint->uwTileX = uwCaptureTileX;
+	pPoint->uwTileY = uwCaptureTileY;
 
 	// Count & add spawns
 	s_ubAllocSpawnCount = 0;
 	pPoint->fubSpawnCount = 0;
-	controlMaskIterateSpawns(pMask, pPoint, fubPolyX1, fubPolyY1, fubPolyX2, fubPolyY2, increaseSpawnCount);
+	controlZoneIterateSpawns(pPoint, s_ubControlPointCount, increaseSpawnCount);
 	if(s_ubAllocSpawnCount) {
-		pPoint->pSpawns = memAllocFast(s_ubAllocSpawnCount * sizeof(FUBYTE));
-		controlMaskIterateSpawns(pMask, pPoint, fubPolyX1, fubPolyY1, fubPolyX2, fubPolyY2, addSpawn);
+		pPoint->pSpawns = arenaAlloc(
+			g_pMatchArena, MEMSTATS_TAG_MAP, s_ubAllocSpawnCount * sizeof(FUBYTE)
+		);
+		controlZoneIterateSpawns(pPoint, s_ubControlPointCount, addSpawn);
 	}
 
 	// Count & add turrets
-	s_ubAllocTurretCount = 0;
-	pPoint->fubTurretCount = 0;
-	controlMaskIterateTurrets(pMask, pPoint, fubPolyX1, fubPolyY1, fubPolyX2, fubPolyY2, increaseTurretCount);
-	if(s_ubAllocTurretCount) {
-		pPoint->pTurrets = memAllocFast(s_ubAllocTurretCount * sizeof(UWORD));
-		controlMaskIterateTurrets(pMask, pPoint, fubPolyX1, fubPolyY1, fubPolyX2, fubPolyY2, addTurret);
+	s_uwAllocTurretCount = 0;
+	pPoint->fuwTurretCount = 0;
+	controlZoneIterateTurrets(pPoint, s_ubControlPointCount, increaseTurretCount);
+	if(s_uwAllocTurretCount) {
+		pPoint->pTurrets = arenaAlloc(
+			g_pMatchArena, MEMSTATS_TAG_MAP, s_uwAllocTurretCount * sizeof(FUWORD)
+		);
+		controlZoneIterateTurrets(pPoint, s_ubControlPointCount, addTurret);
 	}
 
 	// Determine team
 	if(pPoint->fubSpawnCount)
 		pPoint->fubTeam = g_pSpawns[pPoint->pSpawns[0]].ubTeam;
-	else if(pPoint->fubTurretCount)
+	else if(pPoint->fuwTurretCount)
 		pPoint->fubTeam = g_pTurrets[pPoint->pTurrets[0]].ubTeam;
 	else
 		pPoint->fubTeam = TEAM_NONE;
@@ -239,12 +141,10 @@ void controlAddPoint(
 	pPoint->fubBrownCount = 0;
 	pPoint->fubGreenCount = 0;
 
-	// Free polygon mask
-	controlPolygonMaskDestroy(pMask);
 	++s_ubControlPointCount;
 	logWrite(
-		"Spawns: %"PRI_FUBYTE", turrets: %"PRI_FUBYTE"\n",
-		pPoint->fubSpawnCount, pPoint->fubTurretCount
+		"Spawns: %"PRI_FUBYTE", turrets: %"PRI_FUWORD"\n",
+		pPoint->fubSpawnCount, pPoint->fuwTurretCount
 	);
 	logBlockEnd("controlAddPoint()");
 }
@@ -272,7 +172,7 @@ static void controlCapturePoint(tControlPoint *pPoint, FUBYTE fubTeam) {
 	for(FUBYTE i = 0; i < pPoint->fubSpawnCount; ++i) {
 		spawnCapture(pPoint->pSpawns[i], fubTeam);
 	}
-	for(FUBYTE i = 0; i < pPoint->fubTurretCount; ++i) {
+	for(FUWORD i = 0; i < pPoint->fuwTurretCount; ++i) {
 		turretCapture(pPoint->pTurrets[i], fubTeam);
 	}
 }
@@ -375,14 +275,14 @@ void controlRedrawPoints(void) {
 		// Omit drawing if not visible
 		if(!simpleBufferIsRectVisible(
 			g_pWorldMainBfr,
-			pPoint->fubTileX << MAP_TILE_SIZE, pPoint->fubTileY << MAP_TILE_SIZE,
+			pPoint->uwTileX << MAP_TILE_SIZE, pPoint->uwTileY << MAP_TILE_SIZE,
 			MAP_FULL_TILE, MAP_FULL_TILE
 		)) {
 			continue;
 		}
-		// TODO could be drawn only on fubTileLife change, but watch out for dblbuf
-		UWORD uwX = pPoint->fubTileX << MAP_TILE_SIZE;
-		UWORD uwY = pPoint->fubTileY << MAP_TILE_SIZE;
+		// TODO could be drawn only on tile life change, but watch out for dblbuf
+		UWORD uwX = pPoint->uwTileX << MAP_TILE_SIZE;
+		UWORD uwY = pPoint->uwTileY << MAP_TILE_SIZE;
 		FUWORD fuwTileProgress = ABS(CONTROL_POINT_LIFE_NEUTRAL - pPoint->fuwLife);
 		if(pPoint->fubDestTeam == TEAM_NONE) {
 			fuwTileProgress = CONTROL_POINT_LIFE - fuwTileProgress;
@@ -391,16 +291,16 @@ void controlRedrawPoints(void) {
 		FUWORD fuwAntiProgress = MAP_FULL_TILE - fuwTileProgress;
 
 		if(fuwTileProgress != MAP_FULL_TILE) {
-			blitCopyAligned(
-				g_pMapTileset, 0,
+			blitCopyAlignedTagged(
+				BLITSTATS_TAG_CONTROL, g_pMapTileset, 0,
 				(MAP_TILE_CAPTURE_BLUE + pPoint->fubTeam) << MAP_TILE_SIZE,
 				g_pWorldMainBfr->pBack, uwX, uwY,
 				MAP_FULL_TILE, fuwAntiProgress
 			);
 		}
 		if(fuwTileProgress) {
-			blitCopyAligned(
-				g_pMapTileset, 0,
+			blitCopyAlignedTagged(
+				BLITSTATS_TAG_CONTROL, g_pMapTileset, 0,
 				((MAP_TILE_CAPTURE_BLUE + pPoint->fubDestTeam) << MAP_TILE_SIZE) + fuwAntiProgress,
 				g_pWorldMainBfr->pBack, uwX, uwY + fuwAntiProgress,
 				MAP_FULL_TILE, fuwTileProgress
@@ -409,32 +309,37 @@ void controlRedrawPoints(void) {
 	}
 }
 
-tControlPoint *controlPointGetAt(FUBYTE fubTileX, FUBYTE fubTileY) {
-	FUBYTE i; tControlPoint *pPoint;
-	for(i = s_ubControlPointCount, pPoint = &g_pControlPoints[0]; i--; ++pPoint) {
-		if(pPoint->fubTileX == fubTileX &&	pPoint->fubTileY == fubTileY) {
-			return pPoint;
-		}
+tControlPoint *controlPointGetAt(tTilePos uwTileX, tTilePos uwTileY) {
+	UBYTE ubIdx = mapControlAt(uwTileX, uwTileY);
+	if(ubIdx >= s_ubControlPointCount) {
+		return 0;
+	}
+	tControlPoint *pPoint = &g_pControlPoints[ubIdx];
+	if(pPoint->uwTileX == uwTileX && pPoint->uwTileY == uwTileY) {
+		return pPoint;
 	}
 	return 0;
 }
 
 void controlIncreaseCounters(UWORD uwTileX, UWORD uwTileY, UBYTE ubTeam) {
-	// Increase counters for control point domination
-	for(FUBYTE i = s_ubControlPointCount; i--;) {
-		// Calc distance
-		// Increase vehicle count near control point for given team
-		if(
-			ABS(uwTileX - g_pControlPoints[i].fubTileX) <= CONTROL_TAKEOVER_TILE_DISTANCE &&
-			ABS(uwTileY - g_pControlPoints[i].fubTileY) <= CONTROL_TAKEOVER_TILE_DISTANCE
-		) {
-			if(ubTeam == TEAM_BLUE) {
-				++g_pControlPoints[i].fubGreenCount;
-			}
-			else {
-				++g_pControlPoints[i].fubBrownCount;
-			}
-			return; // Player can't be in two bases at the same time
+	// Player can't be in two bases at the same time, so only point owning
+	// tile's zone may be dominated from there
+	UBYTE ubIdx = mapControlAt(uwTileX, uwTileY);
+	if(ubIdx >= s_ubControlPointCount) {
+		return;
+	}
+	tControlPoint *pPoint = &g_pControlPoints[ubIdx];
+
+	// Increase vehicle count near control point for given team
+	if(
+		ABS(uwTileX - pPoint->uwTileX) <= CONTROL_TAKEOVER_TILE_DISTANCE &&
+		ABS(uwTileY - pPoint->uwTileY) <= CONTROL_TAKEOVER_TILE_DISTANCE
+	) {
+		if(ubTeam == TEAM_BLUE) {
+			++pPoint->fubGreenCount;
+		}
+		else {
+			++pPoint->fubBrownCount;
 		}
 	}
 }
@@ -2,16 +2,17 @@
 #define GUARD_OF_GAMESTATES_GAME_CONTROL_H
 
 #include <ace/types.h>
+#include "map.h"
 #include "gamestates/game/player.h"
 #include "gamestates/game/team.h"
 
-#define CONTROL_NAME_MAX 20
+#define CONTROL_NAME_MAX MAP_CONTROL_NAME_MAX
 
 typedef struct _tControlPoint {
-	FUBYTE fubTileX;
-	FUBYTE fubTileY;
+	tTilePos uwTileX;
+	tTilePos uwTileY;
 
-	FUBYTE fubTurretCount;
+	FUWORD fuwTurretCount;
 	FUBYTE fubSpawnCount;
 	FUWORD *pTurrets;
 	FUBYTE *pSpawns;
@@ -29,17 +30,17 @@ void controlManagerDestroy(void);
 
 /**
  *  This function expects all logic tiles to be initialized - spawns & turrets too.
+ *  Point's zone is read from map's control plane, using next free point idx.
  */
 void controlAddPoint(
-	char *szName, FUBYTE fubCaptureTileX, FUBYTE fubCaptureTileY,
-	FUBYTE fubPolyPtCnt, tUbCoordYX *pPolyPts
+	const char *szName, tTilePos uwCaptureTileX, tTilePos uwCaptureTileY
 );
 
 void controlSim(void);
 
 void controlRedrawPoints(void);
 
-tControlPoint *controlPointGetAt(FUBYTE fubTileX, FUBYTE fubTileY);
+tControlPoint *controlPointGetAt(tTilePos uwTileX, tTilePos uwTileY);
 
 void controlIncreaseCounters(UWORD uwTileX, UWORD uwTileY, UBYTE ubTeam);
 
@@ -0,0 +1,242 @@
+#include "gamestates/game/framecache.h"
+#include <string.h>
+#include <ace/managers/log.h>
+#include "gamestates/game/game.h"
+#include "gamestates/game/team.h"
+#include "vehicletypes.h"
+#include "memstats.h"
+
+typedef struct _tFrameCacheSlot {
+	const tFramePack *pFrames; ///< Sheet of cached frame, 0 if slot is unused.
+	ULONG ulLastUse;           ///< Game frame of last hit.
+	UBYTE ubFrame;
+	UBYTE ubRefs;              ///< Number of bobs pointing at slot.
+} tFrameCacheSlot;
+
+static tFrameCacheSlot *s_pSlots;
+static UBYTE s_ubSlotCount = 0;
+// Slots one after another, same layout as unpacked vehicle sheets
+static tBitMap *s_pFrames;
+static tBitMap *s_pMasks;
+static UWORD s_uwSlotSize;
+
+/**
+ * Checks if frames of sheet can be decoded into cache slot.
+ * Missing sheet, e.g. one which failed to generate, is never ok.
+ */
+static UBYTE frameCacheIsSheetOk(const tFramePack *pPack) {
+	return (
+		pPack && s_pFrames &&
+		pPack->uwFrameSize == s_uwSlotSize &&
+		pPack->uwBytesPerRow == s_pFrames->BytesPerRow
+	);
+}
+
+static void frameCacheCheckSheet(const tFramePack *pPack) {
+	if(pPack && !frameCacheIsSheetOk(pPack)) {
+		logWrite(
+			"ERR: Packed frames don't fit cache: %hu bytes, %hu bytes per row\n",
+			pPack->uwFrameSize, pPack->uwBytesPerRow
+		);
+	}
+}
+
+void frameCacheCreate(UBYTE ubSlotCount, UBYTE ubBpp) {
+	logBlockBegin(
+		"frameCacheCreate(ubSlotCount: %hhu, ubBpp: %hhu)", ubSlotCount, ubBpp
+	);
+	s_pSlots = memAllocFastClearTagged(
+		MEMSTATS_TAG_BOBS, ubSlotCount * sizeof(tFrameCacheSlot)
+	);
+	s_pFrames = bitmapCreate(
+		VEHICLE_BODY_WIDTH, VEHICLE_BODY_HEIGHT * ubSlotCount, ubBpp,
+		BMF_INTERLEAVED
+	);
+	s_pMasks = bitmapCreate(
+		VEHICLE_BODY_WIDTH, VEHICLE_BODY_HEIGHT * ubSlotCount, ubBpp,
+		BMF_INTERLEAVED
+	);
+	if(!s_pSlots || !s_pFrames || !s_pMasks) {
+		// Without slots no frame can be set, so vehicles just won't be drawn
+		logWrite("ERR: Couldn't allocate frame cache\n");
+		if(s_pSlots) {
+			memFreeTagged(
+				MEMSTATS_TAG_BOBS, s_pSlots, ubSlotCount * sizeof(tFrameCacheSlot)
+			);
+		}
+		if(s_pFrames) {
+			bitmapDestroy(s_pFrames);
+		}
+		if(s_pMasks) {
+			bitmapDestroy(s_pMasks);
+		}
+		s_pSlots = 0;
+		s_pFrames = 0;
+		s_pMasks = 0;
+		s_ubSlotCount = 0;
+		logBlockEnd("frameCacheCreate()");
+		return;
+	}
+	s_uwSlotSize = s_pFrames->BytesPerRow * VEHICLE_BODY_HEIGHT;
+	s_ubSlotCount = ubSlotCount;
+
+	// Bad sheets are reported once here, bad & missing ones are skipped by
+	// frameCacheSetBobFrame()
+	for(UBYTE i = 0; i < VEHICLE_TYPE_COUNT; ++i) {
+		const tVehicleType *pType = &g_pVehicleTypes[i];
+		for(UBYTE ubTeam = 0; ubTeam < TEAM_COUNT; ++ubTeam) {
+			frameCacheCheckSheet(pType->pMainFrames[ubTeam]);
+			frameCacheCheckSheet(pType->pAuxFrames[ubTeam]);
+		}
+		frameCacheCheckSheet(pType->pMainMask);
+		frameCacheCheckSheet(pType->pAuxMask);
+	}
+	logBlockEnd("frameCacheCreate()");
+}
+
+void frameCacheDestroy(void) {
+	if(!s_ubSlotCount) {
+		return;
+	}
+	memFreeTagged(
+		MEMSTATS_TAG_BOBS, s_pSlots, s_ubSlotCount * sizeof(tFrameCacheSlot)
+	);
+	bitmapDestroy(s_pFrames);
+	bitmapDestroy(s_pMasks);
+	s_pFrames = 0;
+	s_pMasks = 0;
+	s_ubSlotCount = 0;
+}
+
+/**
+ * Flips decoded frame vertically, in place.
+ * Interleaved rows hold all planes, so they're swapped as a whole.
+ */
+static void frameCacheFlip(UBYTE *pFrame, UWORD uwBytesPerRow, UBYTE ubMirror) {
+	for(UWORD y = 0; y < VEHICLE_BODY_HEIGHT; ++y) {
+		UWORD uwSrcY = ubMirror - y;
+		UBYTE *pRow = &pFrame[y * uwBytesPerRow];
+		if(uwSrcY >= VEHICLE_BODY_HEIGHT) {
+			memset(pRow, 0, uwBytesPerRow);
+		}
+		else if(y < uwSrcY) {
+			UBYTE *pSrcRow = &pFrame[uwSrcY * uwBytesPerRow];
+			for(UWORD x = 0; x < uwBytesPerRow; ++x) {
+				UBYTE ubTmp = pRow[x];
+				pRow[x] = pSrcRow[x];
+				pSrcRow[x] = ubTmp;
+			}
+		}
+	}
+}
+
+/**
+ * Decodes frame into slot, mirroring it if sheets don't hold it.
+ */
+static void frameCacheFill(
+	const tFramePack *pPack, UBYTE ubMirror, UBYTE ubFrame, UBYTE *pDst
+) {
+	if(!ubMirror || ubFrame < VEHICLE_MIRROR_FRAME_COUNT) {
+		framePackDecode(pPack, ubFrame, pDst);
+	}
+	else {
+		framePackDecode(pPack, VEHICLE_BODY_ANGLE_COUNT - ubFrame, pDst);
+		frameCacheFlip(pDst, pPack->uwBytesPerRow, ubMirror);
+	}
+}
+
+/**
+ * Gets slot held by bob.
+ * @return Slot index, s_ubSlotCount if bob doesn't hold any.
+ */
+static UBYTE frameCacheGetBobSlot(const tBobNew *pBob) {
+	if(!s_ubSlotCount || pBob->pBitmap != s_pFrames) {
+		return s_ubSlotCount;
+	}
+	return pBob->uwOffsetY / s_uwSlotSize;
+}
+
+void frameCacheReleaseBob(tBobNew *pBob) {
+	UBYTE ubSlot = frameCacheGetBobSlot(pBob);
+	if(ubSlot != s_ubSlotCount) {
+		--s_pSlots[ubSlot].ubRefs;
+		pBob->pBitmap = 0;
+	}
+}
+
+UBYTE frameCacheSetBobFrame(
+	tBobNew *pBob, const tFramePack *pFrames, const tFramePack *pMask,
+	UBYTE ubMirror, UBYTE ubFrame
+) {
+	UBYTE ubPrevSlot = frameCacheGetBobSlot(pBob);
+	frameCacheReleaseBob(pBob);
+	if(!frameCacheIsSheetOk(pFrames) || !frameCacheIsSheetOk(pMask)) {
+		// Decoding would overflow slot
+		pBob->pBitmap = 0;
+		return 0;
+	}
+
+	// Find cached frame or least recently used free slot
+	UBYTE ubSlot = s_ubSlotCount;
+	UBYTE isHit = 0;
+	for(UBYTE i = 0; i < s_ubSlotCount; ++i) {
+		tFrameCacheSlot *pSlot = &s_pSlots[i];
+		if(pSlot->pFrames == pFrames && pSlot->ubFrame == ubFrame) {
+			ubSlot = i;
+			isHit = 1;
+			break;
+		}
+		if(!pSlot->ubRefs && (
+			ubSlot == s_ubSlotCount ||
+			pSlot->ulLastUse < s_pSlots[ubSlot].ulLastUse
+		)) {
+			ubSlot = i;
+		}
+	}
+	if(ubSlot == s_ubSlotCount) {
+		// Shouldn't happen - all slots are held by other bobs
+		logWrite("ERR: Frame cache full\n");
+		pBob->pBitmap = 0;
+		return 0;
+	}
+
+	tFrameCacheSlot *pSlot = &s_pSlots[ubSlot];
+	if(!isHit) {
+		UBYTE *pDstFrame = &s_pFrames->Planes[0][ubSlot * s_uwSlotSize];
+		UBYTE *pDstMask = &s_pMasks->Planes[0][ubSlot * s_uwSlotSize];
+		const tFrameCacheSlot *pPrev = &s_pSlots[ubPrevSlot];
+		if(
+			ubPrevSlot != s_ubSlotCount && !pPrev->ubRefs &&
+			pPrev->pFrames == pFrames && (!ubMirror || (
+				ubFrame < VEHICLE_MIRROR_FRAME_COUNT &&
+				pPrev->ubFrame < VEHICLE_MIRROR_FRAME_COUNT
+			))
+		) {
+			// Bob rotates by single frame most of the time, so try to update
+			// its previous frame with one delta instead of decoding it again.
+			// All sheets share key interval, so both steps succeed or none.
+			UBYTE *pPrevFrame = &s_pFrames->Planes[0][ubPrevSlot * s_uwSlotSize];
+			UBYTE *pPrevMask = &s_pMasks->Planes[0][ubPrevSlot * s_uwSlotSize];
+			if(
+				framePackStep(pFrames, pPrev->ubFrame, ubFrame, pPrevFrame) &&
+				framePackStep(pMask, pPrev->ubFrame, ubFrame, pPrevMask)
+			) {
+				ubSlot = ubPrevSlot;
+				pSlot = &s_pSlots[ubSlot];
+				pDstFrame = 0;
+			}
+		}
+		if(pDstFrame) {
+			frameCacheFill(pFrames, ubMirror, ubFrame, pDstFrame);
+			frameCacheFill(pMask, ubMirror, ubFrame, pDstMask);
+		}
+		pSlot->pFrames = pFrames;
+		pSlot->ubFrame = ubFrame;
+	}
+	++pSlot->ubRefs;
+	pSlot->ulLastUse = g_ulGameFrame;
+	pBob->pBitmap = s_pFrames;
+	pBob->pMask = s_pMasks;
+	bobNewSetBitMapOffset(pBob, ubSlot * VEHICLE_BODY_HEIGHT);
+	return 1;
+}
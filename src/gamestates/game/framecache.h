@@ -0,0 +1,43 @@
+#ifndef GUARD_OF_GAMESTATES_GAME_FRAMECACHE_H
+#define GUARD_OF_GAMESTATES_GAME_FRAMECACHE_H
+
+#include <ace/types.h>
+#include <ace/utils/bitmap.h>
+#include "gamestates/game/bob_new.h"
+#include "framepack.h"
+
+/**
+ * Cache of vehicle frames decoded from packed sheets. Frames past
+ * VEHICLE_MIRROR_FRAME_COUNT of mirrored sheets are produced from ones with
+ * opposite angle, flipped vertically. Each bob holds at most one slot
+ * and slots are reused only when no bob holds them, so there must be a slot
+ * for each vehicle bob.
+ * @param ubSlotCount Number of cached frames.
+ * @param ubBpp Depth of frames, same as of bob destination buffer.
+ */
+void frameCacheCreate(UBYTE ubSlotCount, UBYTE ubBpp);
+
+void frameCacheDestroy(void);
+
+/**
+ * Points bob at given frame of its sheets, decoding it into cache if no slot
+ * holds it yet. On failure bob is left without bitmap and mustn't be drawn.
+ * @param pBob Bob to be updated. Its width & height must be same as frame's.
+ * @param pFrames Packed frames sheet.
+ * @param pMask Packed mask sheet, with same layout as pFrames.
+ * @param ubMirror Mirror row sum of sheets, 0 if they hold all frames.
+ * @param ubFrame Frame index.
+ * @return 1 on success, 0 if sheets don't fit slots or all slots are taken.
+ */
+UBYTE frameCacheSetBobFrame(
+	tBobNew *pBob, const tFramePack *pFrames, const tFramePack *pMask,
+	UBYTE ubMirror, UBYTE ubFrame
+);
+
+/**
+ * Releases cache slot held by bob, if any.
+ * Call it before pointing bob at other bitmap.
+ */
+void frameCacheReleaseBob(tBobNew *pBob);
+
+#endif // GUARD_OF_GAMESTATES_GAME_FRAMECACHE_H
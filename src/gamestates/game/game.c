@@ -10,12 +10,15 @@
 #include <ace/managers/system.h>
 #include <ace/utils/extview.h>
 #include <ace/utils/palette.h>
+#include "blitstats.h"
 #include "cursor.h"
+#include "memstats.h"
 #include "gamestates/game/worldmap.h"
 #include "gamestates/game/vehicle.h"
 #include "gamestates/game/player.h"
 #include "gamestates/game/team.h"
 #include "gamestates/game/projectile.h"
+#include "gamestates/game/framecache.h"
 #include "gamestates/game/data.h"
 #include "gamestates/game/hud.h"
 #include "gamestates/game/turret.h"
@@ -27,6 +30,9 @@
 #include "gamestates/game/scoretable.h"
 #include "gamestates/menu/menu.h"
 
+// Big enough for typical map's turret list, blocks are appended if needed
+#define MATCH_ARENA_BLOCK_SIZE 65536
+
 // Viewport stuff
 tView *g_pWorldView;
 tSimpleBufferManager *g_pWorldMainBfr;
@@ -38,6 +44,7 @@ ULONG g_ulGameFrame;
 static tFont *s_pSmallFont;
 
 UBYTE g_isLocalBot;
+tArena *g_pMatchArena;
 
 void displayPrepareLimbo(void) {
 	mouseSetBounds(MOUSE_PORT_1, 0,0, 320, 255);
@@ -53,6 +60,14 @@ void gsGameCreate(void) {
 	logBlockBegin("gsGameCreate()");
 	randInit(2184);
 
+	g_pMatchArena = arenaCreate(MATCH_ARENA_BLOCK_SIZE);
+	if(!g_pMatchArena) {
+		logWrite("ERR: Couldn't create match arena\n");
+		logBlockEnd("gsGameCreate()");
+		gamePopState();
+		return;
+	}
+
 	// Prepare view
 	g_pWorldView = viewCreate(0,
 		TAG_VIEW_GLOBAL_CLUT, 1,
@@ -68,8 +83,8 @@ void gsGameCreate(void) {
 	TAG_DONE);
 	g_pWorldMainBfr = simpleBufferCreate(0,
 		TAG_SIMPLEBUFFER_VPORT, s_pWorldMainVPort,
-		TAG_SIMPLEBUFFER_BOUND_WIDTH, g_sMap.fubWidth << MAP_TILE_SIZE,
-		TAG_SIMPLEBUFFER_BOUND_HEIGHT, g_sMap.fubHeight << MAP_TILE_SIZE,
+		TAG_SIMPLEBUFFER_BOUND_WIDTH, g_sMap.uwWidth << MAP_TILE_SIZE,
+		TAG_SIMPLEBUFFER_BOUND_HEIGHT, g_sMap.uwHeight << MAP_TILE_SIZE,
 		TAG_SIMPLEBUFFER_COPLIST_OFFSET, WORLD_COP_VPMAIN_POS,
 		TAG_SIMPLEBUFFER_BITMAP_FLAGS, BMF_INTERLEAVED | BMF_CLEAR,
 		TAG_SIMPLEBUFFER_IS_DBLBUF, 1,
@@ -84,11 +99,13 @@ void gsGameCreate(void) {
 	const UBYTE ubProjectilesMax = 16;
 	const UBYTE ubPlayersMax = 8;
 	bobNewManagerCreate(
-		ubPlayersMax*2 + EXPLOSIONS_MAX + ubProjectilesMax,
+		ubPlayersMax*2 + EXPLOSIONS_MAX + ubProjectilesMax +
+			TURRET_BOB_POOL_SIZE,
 		ubPlayersMax*2*(VEHICLE_BODY_WIDTH/16 + 1)*VEHICLE_BODY_HEIGHT +
 			ubProjectilesMax*2*(1+1)*2 + EXPLOSIONS_MAX*2*(2+1)*32,
-		g_pWorldMainBfr->pFront, g_pWorldMainBfr->pBack
+		g_pWorldMainBfr
 	);
+	frameCacheCreate(ubPlayersMax*2, g_pWorldMainBfr->pBack->Depth);
 
 	worldMapCreate(g_pWorldMainBfr->pFront, g_pWorldMainBfr->pBack);
 
@@ -152,6 +169,24 @@ static void gameSummaryLoop(void) {
 	scoreTableProcessView();
 }
 
+#if defined(GAME_DEBUG)
+static UBYTE s_isBobStatsShown = 0;
+
+static void gameShowBobStats(void) {
+	tBobNewFrameStats sAvg;
+	bobNewGetAvgStats(&sAvg);
+	ULONG ulBusy = sAvg.ulWaitTime + sAvg.ulOverlapTime;
+	char szMsg[50];
+	sprintf(
+		szMsg, "Bobs %hhu/%hhu/%hhu, %lu words, wait %lu%%",
+		sAvg.ubSaved, sAvg.ubDrawn, sAvg.ubUndrawn,
+		blitStatsGetWords(&sAvg.sBlits),
+		ulBusy ? (sAvg.ulWaitTime * 100) / ulBusy : 0
+	);
+	consoleWrite(szMsg, CONSOLE_COLOR_GENERAL);
+}
+#endif
+
 void gameDebugKeys(void) {
 #if defined(GAME_DEBUG)
 	if(keyUse(KEY_C)) {
@@ -162,6 +197,21 @@ void gameDebugKeys(void) {
 	if(keyUse(KEY_L)) {
 		copDumpBfr(g_pWorldView->pCopList->pFrontBfr);
 	}
+	if(keyUse(KEY_M)) {
+		memStatsReport("debug key");
+	}
+	if(keyUse(KEY_B)) {
+		blitStatsReport("debug key");
+		blitStatsReset();
+		bobNewStatsReport();
+	}
+	// Saved/drawn/undrawn bobs, words moved & share of bob time spent waiting
+	if(keyUse(KEY_O)) {
+		s_isBobStatsShown = !s_isBobStatsShown;
+	}
+	if(s_isBobStatsShown && !(g_ulGameFrame % BOB_NEW_STATS_FRAMES)) {
+		gameShowBobStats();
+	}
 #endif
 }
 
@@ -257,6 +307,7 @@ void gsGameDestroy(void) {
 	projectileListDestroy();
 
 	bobNewManagerDestroy();
+	frameCacheDestroy();
 
 	aiManagerDestroy();
 
@@ -269,5 +320,14 @@ void gsGameDestroy(void) {
 
 	worldMapDestroy();
 
+	// Releases all map-lifetime data in one go
+	arenaDestroy(g_pMatchArena);
+	g_pMatchArena = 0;
+
+	memStatsReport("gsGameDestroy");
+	memStatsResetPeaks();
+	blitStatsReport("gsGameDestroy");
+	blitStatsReset();
+
 	logBlockEnd("gsGameDestroy()");
 }
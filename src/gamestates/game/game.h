@@ -3,6 +3,7 @@
 
 #include <ace/managers/viewport/simplebuffer.h>
 #include <gamestates/game/bob_new.h>
+#include "arena.h"
 
 #define WORLD_BPP 4
 
@@ -36,6 +37,11 @@ extern tSimpleBufferManager *g_pWorldMainBfr;
 extern tCameraManager *g_pWorldCamera;
 
 extern ULONG g_ulGameFrame;
+/**
+ * Arena for all data which lives exactly as long as the match.
+ * Freed in one go in gsGameDestroy(), so managers don't free its contents.
+ */
+extern tArena *g_pMatchArena;
 extern UBYTE g_isLocalBot;
 
 void gsGameCreate(void);
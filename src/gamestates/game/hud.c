@@ -7,6 +7,7 @@
 #include "gamestates/game/player.h"
 #include "gamestates/game/console.h"
 #include "vehicletypes.h"
+#include "blitstats.h"
 
 static tVPort *s_pHudVPort;
 tSimpleBufferManager *g_pHudBfr;
@@ -107,16 +108,17 @@ static void hudDrawBar(
 
 	// Black part of bar
 	if(uwCurrBarWidth != uwMaxBarWidth) {
-		blitRect(
-			g_pHudBfr->pBack,	(WORD)(uwBarX + uwCurrBarWidth), (WORD)uwBarY,
+		blitRectTagged(
+			BLITSTATS_TAG_HUD, g_pHudBfr->pBack,
+			(WORD)(uwBarX + uwCurrBarWidth), (WORD)uwBarY,
 			(WORD)(uwMaxBarWidth - uwCurrBarWidth), uwBarHeight, 0
 		);
 	}
 
 	// Colored part of bar
 	if(uwCurrBarWidth) {
-		blitRect(
-			g_pHudBfr->pBack, (WORD)uwBarX, (WORD)uwBarY,
+		blitRectTagged(
+			BLITSTATS_TAG_HUD, g_pHudBfr->pBack, (WORD)uwBarX, (WORD)uwBarY,
 			(WORD)uwCurrBarWidth, (WORD)uwBarHeight, ubColor
 		);
 	}
@@ -127,7 +129,10 @@ static void hudDrawTeamScore(FUBYTE fubTeam) {
 	const UWORD uwTicketY[2] = {2+35+3, 2+35+3+5+4};
 	const UBYTE pTeamColors[2] = {12, 10};
 	char szSpawnBfr[6];
-	blitRect(g_pHudBfr->pBack, (WORD)uwTicketX, (WORD)uwTicketY[fubTeam], 26, 5, 0);
+	blitRectTagged(
+		BLITSTATS_TAG_HUD, g_pHudBfr->pBack,
+		(WORD)uwTicketX, (WORD)uwTicketY[fubTeam], 26, 5, 0
+	);
 	sprintf(szSpawnBfr, "%5hu", g_pTeams[fubTeam].uwTicketsLeft);
 	fontFillTextBitMap(s_pHudFont, s_pSpawnTextBfr, szSpawnBfr);
 	fontDrawTextBitMap(
@@ -139,8 +144,9 @@ static void hudDrawTeamScore(FUBYTE fubTeam) {
 
 void hudUpdate(void) {
 	if(s_fubHudState != s_fubHudPrevState) {
-		blitCopy(
-			s_pHudPanels[s_fubHudState], 0, 0, g_pHudBfr->pBack, 2, 2,
+		blitCopyTagged(
+			BLITSTATS_TAG_HUD, s_pHudPanels[s_fubHudState], 0, 0,
+			g_pHudBfr->pBack, 2, 2,
 			104, (WORD)s_pHudPanels[0]->Rows, MINTERM_COOKIE, 0xFF
 		);
 	}
@@ -32,15 +32,14 @@ void playerListInit(UBYTE ubPlayerLimit) {
 	memset(g_pPlayers, 0, PLAYER_MAX_COUNT * sizeof(tPlayer));
 	g_ubPlayerLimit = ubPlayerLimit;
 	for(UBYTE i = 0; i < ubPlayerLimit; ++i) {
+		// Frames are assigned from frame cache on vehicle init
 		bobNewInit(
 			&g_pPlayers[i].sVehicle.sBob, VEHICLE_BODY_WIDTH, VEHICLE_BODY_HEIGHT, 1,
-			g_pVehicleTypes[VEHICLE_TYPE_TANK].pMainFrames[TEAM_BLUE],
-			g_pVehicleTypes[VEHICLE_TYPE_TANK].pMainMask, 0, 0
+			0, 0, 0, 0
 		);
 		bobNewInit(
 			&g_pPlayers[i].sVehicle.sAuxBob, VEHICLE_BODY_WIDTH, VEHICLE_BODY_HEIGHT, 0,
-			g_pVehicleTypes[VEHICLE_TYPE_TANK].pAuxFrames[TEAM_BLUE],
-			g_pVehicleTypes[VEHICLE_TYPE_TANK].pAuxMask, 0, 0
+			0, 0, 0, 0
 		);
 	}
 
@@ -59,8 +58,8 @@ static void playerMoveToLimbo(tPlayer *pPlayer, FUBYTE fubSpawnIdx) {
 		pPlayer->ubSpawnIdx = fubSpawnIdx;
 	}
 
-	pPlayer->sVehicle.uwX = (g_pSpawns[fubSpawnIdx].ubTileX << MAP_TILE_SIZE) + MAP_HALF_TILE;
-	pPlayer->sVehicle.uwY = (g_pSpawns[fubSpawnIdx].ubTileY << MAP_TILE_SIZE) + MAP_HALF_TILE;
+	pPlayer->sVehicle.uwX = (g_pSpawns[fubSpawnIdx].uwTileX << MAP_TILE_SIZE) + MAP_HALF_TILE;
+	pPlayer->sVehicle.uwY = (g_pSpawns[fubSpawnIdx].uwTileY << MAP_TILE_SIZE) + MAP_HALF_TILE;
 	pPlayer->sVehicle.fX = fix16_from_int(pPlayer->sVehicle.uwX);
 	pPlayer->sVehicle.fY = fix16_from_int(pPlayer->sVehicle.uwY);
 	if(pPlayer == g_pLocalPlayer)
@@ -237,27 +236,27 @@ static UBYTE playerCheckDeathFromSpawn(tPlayer *pPlayer) {
 	tBCoordYX *pCollisionPts = pPlayer->sVehicle.pType->pCollisionPts[pPlayer->sVehicle.ubBodyAngle >> 1].pPts;
 
 	// Unrolling for best results
-	FUBYTE fubTileX = (pPlayer->sVehicle.uwX + pCollisionPts[0].bX) >> MAP_TILE_SIZE;
-	FUBYTE fubTileY = (pPlayer->sVehicle.uwY + pCollisionPts[0].bY) >> MAP_TILE_SIZE;
-	FUBYTE fubSpawnIdx = spawnGetAt(fubTileX, fubTileY);
+	tTilePos uwTileX = (pPlayer->sVehicle.uwX + pCollisionPts[0].bX) >> MAP_TILE_SIZE;
+	tTilePos uwTileY = (pPlayer->sVehicle.uwY + pCollisionPts[0].bY) >> MAP_TILE_SIZE;
+	FUBYTE fubSpawnIdx = spawnGetAt(uwTileX, uwTileY);
 	if(fubSpawnIdx != SPAWN_INVALID && g_pSpawns[fubSpawnIdx].ubBusy != SPAWN_BUSY_NOT)
 		goto kill;
 
-	fubTileX = (pPlayer->sVehicle.uwX + pCollisionPts[2].bX) >> MAP_TILE_SIZE;
-	fubTileY = (pPlayer->sVehicle.uwY + pCollisionPts[2].bY) >> MAP_TILE_SIZE;
-	fubSpawnIdx = spawnGetAt(fubTileX, fubTileY);
+	uwTileX = (pPlayer->sVehicle.uwX + pCollisionPts[2].bX) >> MAP_TILE_SIZE;
+	uwTileY = (pPlayer->sVehicle.uwY + pCollisionPts[2].bY) >> MAP_TILE_SIZE;
+	fubSpawnIdx = spawnGetAt(uwTileX, uwTileY);
 	if(fubSpawnIdx != SPAWN_INVALID && g_pSpawns[fubSpawnIdx].ubBusy != SPAWN_BUSY_NOT)
 		goto kill;
 
-	fubTileX = (pPlayer->sVehicle.uwX + pCollisionPts[5].bX) >> MAP_TILE_SIZE;
-	fubTileY = (pPlayer->sVehicle.uwY + pCollisionPts[5].bY) >> MAP_TILE_SIZE;
-	fubSpawnIdx = spawnGetAt(fubTileX, fubTileY);
+	uwTileX = (pPlayer->sVehicle.uwX + pCollisionPts[5].bX) >> MAP_TILE_SIZE;
+	uwTileY = (pPlayer->sVehicle.uwY + pCollisionPts[5].bY) >> MAP_TILE_SIZE;
+	fubSpawnIdx = spawnGetAt(uwTileX, uwTileY);
 	if(fubSpawnIdx != SPAWN_INVALID && g_pSpawns[fubSpawnIdx].ubBusy != SPAWN_BUSY_NOT)
 		goto kill;
 
-	fubTileX = (pPlayer->sVehicle.uwX + pCollisionPts[7].bX) >> MAP_TILE_SIZE;
-	fubTileY = (pPlayer->sVehicle.uwY + pCollisionPts[7].bY) >> MAP_TILE_SIZE;
-	fubSpawnIdx = spawnGetAt(fubTileX, fubTileY);
+	uwTileX = (pPlayer->sVehicle.uwX + pCollisionPts[7].bX) >> MAP_TILE_SIZE;
+	uwTileY = (pPlayer->sVehicle.uwY + pCollisionPts[7].bY) >> MAP_TILE_SIZE;
+	fubSpawnIdx = spawnGetAt(uwTileX, uwTileY);
 	if(fubSpawnIdx != SPAWN_INVALID && g_pSpawns[fubSpawnIdx].ubBusy != SPAWN_BUSY_NOT)
 		goto kill;
 
@@ -273,7 +272,7 @@ void playerSimVehicle(tPlayer *pPlayer) {
 	UWORD uwVy = pVehicle->uwY;
 	UWORD uwVTileX = uwVx >> MAP_TILE_SIZE;
 	UWORD uwVTileY = uwVy >> MAP_TILE_SIZE;
-	UBYTE ubTileType = g_sMap.pData[uwVTileX][uwVTileY].ubIdx;
+	UBYTE ubTileType = mapLogicAt(uwVTileX, uwVTileY);
 
 	// Drowning
 	if(ubTileType == MAP_LOGIC_WATER) {
@@ -326,12 +325,19 @@ void playerSimVehicle(tPlayer *pPlayer) {
 	switch(pPlayer->ubCurrentVehicleType) {
 		case VEHICLE_TYPE_TANK:
 			vehicleSteerTank(pVehicle, &pPlayer->sSteerRequest);
-			bobNewPush(&pVehicle->sBob);
-			bobNewPush(&pVehicle->sAuxBob);
+			// Bobs without frame couldn't get frame cache slot
+			if(pVehicle->sBob.pBitmap) {
+				bobNewPush(&pVehicle->sBob);
+			}
+			if(pVehicle->sAuxBob.pBitmap) {
+				bobNewPush(&pVehicle->sAuxBob);
+			}
 			break;
 		case VEHICLE_TYPE_JEEP:
 			vehicleSteerJeep(pVehicle, &pPlayer->sSteerRequest);
-			bobNewPush(&pVehicle->sBob);
+			if(pVehicle->sBob.pBitmap) {
+				bobNewPush(&pVehicle->sBob);
+			}
 			break;
 	}
 }
@@ -7,6 +7,7 @@
 #include "gamestates/game/player.h"
 #include "gamestates/game/explosions.h"
 #include "gamestates/game/console.h"
+#include "memstats.h"
 
 #define PROJECTILE_BULLET_HEIGHT 2
 #define PROJECTILE_DAMAGE 10
@@ -31,7 +32,9 @@ void projectileListCreate(FUBYTE fubProjectileMaxCount) {
 
 	// Create projectiles
 	s_fubProjectileMaxCount = fubProjectileMaxCount;
-	s_pProjectiles = memAllocFastClear(fubProjectileMaxCount * sizeof(tProjectile));
+	s_pProjectiles = memAllocFastClearTagged(
+		MEMSTATS_TAG_OTHER, fubProjectileMaxCount * sizeof(tProjectile)
+	);
 	s_fubPrevProjectileAdded = fubProjectileMaxCount - 1;
 	for(FUBYTE i = 0; i < fubProjectileMaxCount; ++i) {
 		s_pProjectiles[i].ubType = PROJECTILE_TYPE_OFF;
@@ -54,7 +57,10 @@ void projectileListCreate(FUBYTE fubProjectileMaxCount) {
 void projectileListDestroy(void) {
 	logBlockBegin("projectileListDestroy()");
 
-	memFree(s_pProjectiles, s_fubProjectileMaxCount * sizeof(tProjectile));
+	memFreeTagged(
+		MEMSTATS_TAG_OTHER, s_pProjectiles,
+		s_fubProjectileMaxCount * sizeof(tProjectile)
+	);
 	// Dealloc bob bitmaps
 	bitmapDestroy(s_pBulletBitmap);
 	bitmapDestroy(s_pBulletMask);
@@ -138,20 +144,20 @@ void projectileSim(void) {
 		}
 
 		// Check collistion with buildings
-		UBYTE ubTileX = fix16_to_int(pProjectile->fX) >> MAP_TILE_SIZE;
-		UBYTE ubTileY = fix16_to_int(pProjectile->fY) >> MAP_TILE_SIZE;
-		UBYTE ubBuildingIdx = g_sMap.pData[ubTileX][ubTileY].ubBuilding;
+		tTilePos uwTileX = fix16_to_int(pProjectile->fX) >> MAP_TILE_SIZE;
+		tTilePos uwTileY = fix16_to_int(pProjectile->fY) >> MAP_TILE_SIZE;
+		UBYTE ubBuildingIdx = mapBuildingAt(uwTileX, uwTileY);
 		if(ubBuildingIdx != BUILDING_IDX_INVALID && (
 			pProjectile->ubOwnerType != PROJECTILE_OWNER_TYPE_TURRET ||
-			g_sMap.pData[ubTileX][ubTileY].ubIdx != MAP_LOGIC_WALL
+			mapLogicAt(uwTileX, uwTileY) != MAP_LOGIC_WALL
 		)) {
 			if(buildingDamage(ubBuildingIdx, PROJECTILE_DAMAGE) == BUILDING_DESTROYED) {
-				mapSetLogic(ubTileX, ubTileY, MAP_LOGIC_DIRT);
-				g_sMap.pData[ubTileX][ubTileY].ubBuilding = 0;
-				worldMapSetTile(ubTileX, ubTileY, worldMapTileDirt(ubTileX, ubTileY));
+				mapSetLogic(uwTileX, uwTileY, MAP_LOGIC_DIRT);
+				mapBuildingAt(uwTileX, uwTileY) = 0;
+				worldMapSetTile(uwTileX, uwTileY, worldMapTileDirt(uwTileX, uwTileY));
 				explosionsAdd(
-					(ubTileX << MAP_TILE_SIZE) + MAP_HALF_TILE,
-					(ubTileY << MAP_TILE_SIZE) + MAP_HALF_TILE
+					(uwTileX << MAP_TILE_SIZE) + MAP_HALF_TILE,
+					(uwTileY << MAP_TILE_SIZE) + MAP_HALF_TILE
 				);
 			}
 			projectileDestroy(pProjectile);
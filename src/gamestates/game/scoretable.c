@@ -2,6 +2,7 @@
 #include <ace/managers/viewport/simplebuffer.h>
 #include <ace/utils/palette.h>
 #include "gamestates/game/player.h"
+#include "blitstats.h"
 
 #define SCORE_TABLE_BPP 4
 
@@ -78,15 +79,15 @@ void scoreTableCreate(tVPort *pHudVPort, tFont *pFont) {
 	);
 
 	// Add a border
-	blitRect(s_pBfr->pBack, 0, 0, 1, 192, 13);
-	blitRect(s_pBfr->pBack, 0, 0, 320, 1, 13);
-	blitRect(s_pBfr->pBack, 1, 1, 1, 191, 9);
-	blitRect(s_pBfr->pBack, 1, 1, 319, 1, 9);
-
-	blitRect(s_pBfr->pBack, 0, 190, 320, 1, 13);
-	blitRect(s_pBfr->pBack, 318, 0, 1, 191, 13);
-	blitRect(s_pBfr->pBack, 0, 191, 320, 1, 9);
-	blitRect(s_pBfr->pBack, 319, 0, 1, 192, 9);
+	blitRectTagged(BLITSTATS_TAG_HUD, s_pBfr->pBack, 0, 0, 1, 192, 13);
+	blitRectTagged(BLITSTATS_TAG_HUD, s_pBfr->pBack, 0, 0, 320, 1, 13);
+	blitRectTagged(BLITSTATS_TAG_HUD, s_pBfr->pBack, 1, 1, 1, 191, 9);
+	blitRectTagged(BLITSTATS_TAG_HUD, s_pBfr->pBack, 1, 1, 319, 1, 9);
+
+	blitRectTagged(BLITSTATS_TAG_HUD, s_pBfr->pBack, 0, 190, 320, 1, 13);
+	blitRectTagged(BLITSTATS_TAG_HUD, s_pBfr->pBack, 318, 0, 1, 191, 13);
+	blitRectTagged(BLITSTATS_TAG_HUD, s_pBfr->pBack, 0, 191, 320, 1, 9);
+	blitRectTagged(BLITSTATS_TAG_HUD, s_pBfr->pBack, 319, 0, 1, 192, 9);
 
 	s_pFont = pFont;
 	s_pBotTextBfr = fontCreateTextBitMapFromStr(s_pFont, "[BOT]");
@@ -14,17 +14,20 @@ void spawnManagerCreate(FUBYTE fubMaxCount) {
 	logBlockBegin("spawnManagerCreate(fubMaxCount: %"PRI_FUBYTE")", fubMaxCount);
 	s_ubSpawnMaxCount = fubMaxCount;
 	g_ubSpawnCount = 0;
-	g_pSpawns = memAllocFastClear(sizeof(tSpawn) * fubMaxCount);
+	g_pSpawns = arenaAllocClear(
+		g_pMatchArena, MEMSTATS_TAG_MAP, sizeof(tSpawn) * fubMaxCount
+	);
 	logBlockEnd("spawnManagerCreate()");
 }
 
 void spawnManagerDestroy(void) {
 	logBlockBegin("spawnManagerDestroy()");
-	memFree(g_pSpawns, sizeof(tSpawn) * s_ubSpawnMaxCount);
+	// Spawn list is in match arena
+	g_ubSpawnCount = 0;
 	logBlockEnd("spawnManagerDestroy()");
 }
 
-UBYTE spawnAdd(UBYTE ubTileX, UBYTE ubTileY, UBYTE ubTeam) {
+UBYTE spawnAdd(tTilePos uwTileX, tTilePos uwTileY, UBYTE ubTeam) {
 	if(g_ubSpawnCount == s_ubSpawnMaxCount) {
 		logWrite("ERR: No more room for spawns");
 		return 0;
@@ -34,8 +37,8 @@ UBYTE spawnAdd(UBYTE ubTileX, UBYTE ubTileY, UBYTE ubTeam) {
 	pSpawn->ubBusy = SPAWN_BUSY_NOT;
 	pSpawn->ubFrame = 0;
 	pSpawn->ubTeam = ubTeam;
-	pSpawn->ubTileX = ubTileX;
-	pSpawn->ubTileY = ubTileY;
+	pSpawn->uwTileX = uwTileX;
+	pSpawn->uwTileY = uwTileY;
 
 	return g_ubSpawnCount++;
 }
@@ -43,26 +46,26 @@ UBYTE spawnAdd(UBYTE ubTileX, UBYTE ubTileY, UBYTE ubTeam) {
 void spawnCapture(UBYTE ubSpawnIdx, UBYTE ubTeam) {
 	g_pSpawns[ubSpawnIdx].ubTeam = ubTeam;
 	worldMapSetTile(
-		g_pSpawns[ubSpawnIdx].ubTileX, g_pSpawns[ubSpawnIdx].ubTileY,
+		g_pSpawns[ubSpawnIdx].uwTileX, g_pSpawns[ubSpawnIdx].uwTileY,
 		worldMapTileSpawn(ubTeam, 0)
 	);
 	mapSetLogic(
-		g_pSpawns[ubSpawnIdx].ubTileX, g_pSpawns[ubSpawnIdx].ubTileY,
+		g_pSpawns[ubSpawnIdx].uwTileX, g_pSpawns[ubSpawnIdx].uwTileY,
 		ubTeam == TEAM_BLUE ? MAP_LOGIC_SPAWN1
 		: ubTeam == TEAM_RED ? MAP_LOGIC_SPAWN2
 		: MAP_LOGIC_SPAWN0
 	);
 }
 
-UBYTE spawnGetNearest(UBYTE ubTileX, UBYTE ubTileY, UBYTE ubTeam) {
+UBYTE spawnGetNearest(tTilePos uwTileX, tTilePos uwTileY, UBYTE ubTeam) {
 	UBYTE ubNearestIdx = SPAWN_INVALID;
-	UWORD uwNearestDist = 0xFF;
+	UWORD uwNearestDist = 0xFFFF;
 	for(FUBYTE i = 0; i != g_ubSpawnCount; ++i) {
 		if(g_pSpawns[i].ubTeam != ubTeam)
 			continue;
 		// Maybe this will suffice
 		// If not, sum of squares - no need for sqrting since actual range is irrelevant
-		UWORD uwDist = ABS(g_pSpawns[i].ubTileX - ubTileX) + ABS(g_pSpawns[i].ubTileY - ubTileY);
+		UWORD uwDist = ABS(g_pSpawns[i].uwTileX - uwTileX) + ABS(g_pSpawns[i].uwTileY - uwTileY);
 		if(uwDist < uwNearestDist) {
 			uwNearestDist = uwDist;
 			ubNearestIdx = i;
@@ -71,15 +74,15 @@ UBYTE spawnGetNearest(UBYTE ubTileX, UBYTE ubTileY, UBYTE ubTeam) {
 	return ubNearestIdx;
 }
 
-UBYTE spawnGetAt(UBYTE ubTileX, UBYTE ubTileY) {
+UBYTE spawnGetAt(tTilePos uwTileX, tTilePos uwTileY) {
 	if(
-		g_sMap.pData[ubTileX][ubTileY].ubIdx != MAP_LOGIC_SPAWN0 &&
-		g_sMap.pData[ubTileX][ubTileY].ubIdx != MAP_LOGIC_SPAWN1 &&
-		g_sMap.pData[ubTileX][ubTileY].ubIdx != MAP_LOGIC_SPAWN2
+		mapLogicAt(uwTileX, uwTileY) != MAP_LOGIC_SPAWN0 &&
+		mapLogicAt(uwTileX, uwTileY) != MAP_LOGIC_SPAWN1 &&
+		mapLogicAt(uwTileX, uwTileY) != MAP_LOGIC_SPAWN2
 	)
 		return SPAWN_INVALID;
 	for(FUBYTE i = g_ubSpawnCount; i--;) {
-		if(g_pSpawns[i].ubTileX == ubTileX && g_pSpawns[i].ubTileY == ubTileY)
+		if(g_pSpawns[i].uwTileX == uwTileX && g_pSpawns[i].uwTileY == uwTileY)
 			return i;
 	}
 	return SPAWN_INVALID;
@@ -111,7 +114,7 @@ void spawnAnimate(UBYTE ubSpawnIdx) {
 	}
 	if(pSpawn->ubFrame == PLAYER_SURFACING_COOLDOWN) {
 		worldMapTrySetTile(
-			pSpawn->ubTileX, pSpawn->ubTileY, worldMapTileSpawn(pSpawn->ubTeam, 0)
+			pSpawn->uwTileX, pSpawn->uwTileY, worldMapTileSpawn(pSpawn->ubTeam, 0)
 		);
 	}
 	else {
@@ -123,7 +126,7 @@ void spawnAnimate(UBYTE ubSpawnIdx) {
 		if(pSpawn->ubTeam == TEAM_RED) {
 			ubTile += 6;
 		}
-		worldMapTrySetTile(pSpawn->ubTileX, pSpawn->ubTileY, ubTile);
+		worldMapTrySetTile(pSpawn->uwTileX, pSpawn->uwTileY, ubTile);
 	}
 }
 
@@ -136,8 +139,8 @@ UBYTE spawnIsCoveredByAnyPlayer(UBYTE ubSpawnIdx) {
 		UWORD uwX = pPlayer->sVehicle.uwX;
 		UWORD uwY = pPlayer->sVehicle.uwY;
 		if(
-			ABS((uwX >> MAP_TILE_SIZE) - pSpawn->ubTileX) > 1 ||
-			ABS((uwY >> MAP_TILE_SIZE) - pSpawn->ubTileY) > 1
+			ABS((uwX >> MAP_TILE_SIZE) - pSpawn->uwTileX) > 1 ||
+			ABS((uwY >> MAP_TILE_SIZE) - pSpawn->uwTileY) > 1
 		) {
 			continue;
 		}
@@ -145,26 +148,26 @@ UBYTE spawnIsCoveredByAnyPlayer(UBYTE ubSpawnIdx) {
 		// Unrolled for performance
 		tBCoordYX *pEdges = pPlayer->sVehicle.pType->pCollisionPts[pPlayer->sVehicle.ubBodyAngle >> 1].pPts;
 		if(
-			((uwX + pEdges[0].bX) >> MAP_TILE_SIZE) == pSpawn->ubTileX &&
-			((uwY + pEdges[0].bY) >> MAP_TILE_SIZE) == pSpawn->ubTileY
+			((uwX + pEdges[0].bX) >> MAP_TILE_SIZE) == pSpawn->uwTileX &&
+			((uwY + pEdges[0].bY) >> MAP_TILE_SIZE) == pSpawn->uwTileY
 		) {
 			return 1;
 		}
 		if(
-			((uwX + pEdges[2].bX) >> MAP_TILE_SIZE) == pSpawn->ubTileX &&
-			((uwY + pEdges[2].bY) >> MAP_TILE_SIZE) == pSpawn->ubTileY
+			((uwX + pEdges[2].bX) >> MAP_TILE_SIZE) == pSpawn->uwTileX &&
+			((uwY + pEdges[2].bY) >> MAP_TILE_SIZE) == pSpawn->uwTileY
 		) {
 			return 1;
 		}
 		if(
-			((uwX + pEdges[5].bX) >> MAP_TILE_SIZE) == pSpawn->ubTileX &&
-			((uwY + pEdges[5].bY) >> MAP_TILE_SIZE) == pSpawn->ubTileY
+			((uwX + pEdges[5].bX) >> MAP_TILE_SIZE) == pSpawn->uwTileX &&
+			((uwY + pEdges[5].bY) >> MAP_TILE_SIZE) == pSpawn->uwTileY
 		) {
 			return 1;
 		}
 		if(
-			((uwX + pEdges[7].bX) >> MAP_TILE_SIZE) == pSpawn->ubTileX &&
-			((uwY + pEdges[7].bY) >> MAP_TILE_SIZE) == pSpawn->ubTileY
+			((uwX + pEdges[7].bX) >> MAP_TILE_SIZE) == pSpawn->uwTileX &&
+			((uwY + pEdges[7].bY) >> MAP_TILE_SIZE) == pSpawn->uwTileY
 		) {
 			return 1;
 		}
@@ -2,6 +2,7 @@
 #define GUARD_OF_GAMESTATES_GAME_SPAWN_H
 
 #include <ace/types.h>
+#include "map.h"
 
 #define SPAWN_BUSY_NOT 0
 #define SPAWN_BUSY_SURFACING 1
@@ -10,8 +11,8 @@
 #define SPAWN_INVALID 0xFF
 
 typedef struct _tSpawn {
-	UBYTE ubTileY;
-	UBYTE ubTileX;
+	tTilePos uwTileY;
+	tTilePos uwTileX;
 	UBYTE ubTeam;
 	UBYTE ubBusy;
 	UBYTE ubFrame;
@@ -22,13 +23,13 @@ void spawnManagerCreate(FUBYTE fubMaxCount);
 
 void spawnManagerDestroy(void);
 
-UBYTE spawnAdd(UBYTE ubTileX, UBYTE ubTileY, UBYTE ubTeam);
+UBYTE spawnAdd(tTilePos uwTileX, tTilePos uwTileY, UBYTE ubTeam);
 
 void spawnCapture(UBYTE ubSpawnIdx, UBYTE ubTeam);
 
-UBYTE spawnGetNearest(UBYTE ubTileX, UBYTE ubTileY, UBYTE ubTeam);
+UBYTE spawnGetNearest(tTilePos uwTileX, tTilePos uwTileY, UBYTE ubTeam);
 
-UBYTE spawnGetAt(UBYTE ubTileX, UBYTE ubTileY);
+UBYTE spawnGetAt(tTilePos uwTileX, tTilePos uwTileY);
 
 void spawnSetBusy(FUBYTE fubSpawnIdx, FUBYTE fubBusyType, FUBYTE fubVehicleType);
 
@@ -1,44 +1,107 @@
 #include "gamestates/game/turret.h"
-#include <ace/managers/memory.h>
 #include <ace/managers/key.h>
 #include <ace/managers/rand.h>
 #include <ace/managers/system.h>
 #include <ace/utils/custom.h>
 #include <ace/utils/chunky.h>
-#include "cache.h"
+#include "atlas.h"
+#include "c2p.h"
 #include "gamestates/game/vehicle.h"
 #include "gamestates/game/player.h"
 #include "gamestates/game/explosions.h"
 #include "gamestates/game/team.h"
+#include "gamestates/game/game.h"
+#include "memstats.h"
 
 #define TURRET_BOB_WIDTH  32
 #define TURRET_BOB_HEIGHT 16
+// Bump on each change of frame generator so that caches get rebuilt
+#define TURRET_FRAMES_VERSION 1
 
 UWORD g_uwTurretCount;
-tTurret *g_pTurrets; // 20x25: 1100*7 ~ 8KiB
+tTurret *g_pTurrets;
 tBitMap *g_pTurretFrames[TEAM_COUNT+1];
 
 static UWORD s_uwMaxTurrets;
-UWORD g_pTurretTiles[MAP_MAX_SIZE][MAP_MAX_SIZE]; // 32k FAST
 
-static FUBYTE s_fubMapWidth, s_fubMapHeight;
-
-void turretListCreate(FUBYTE fubMapWidth, FUBYTE fubMapHeight) {
+/**
+ * Turret lookup by tile - open addressing hash with linear probing.
+ * Table is at most half full, so probing always ends on an empty slot.
+ * Destroyed turrets keep their slot with TURRET_INVALID idx, since turrets
+ * are never re-added during match and probe chains must stay intact.
+ */
+typedef struct _tTurretTile {
+	tTilePos uwTileX; ///< TURRET_TILE_EMPTY for unused slot.
+	tTilePos uwTileY;
+	UWORD uwIdx;
+} tTurretTile;
+
+#define TURRET_TILE_EMPTY 0xFFFF
+// Largest power of two which fits in UWORD slot count
+#define TURRET_TILE_SLOTS_MAX 32768
+
+static tTurretTile *s_pTurretTiles;
+static UWORD s_uwTurretTileMask;
+static UBYTE s_ubTurretTileShift; ///< 16 - log2 of slot count.
+/// Used when table can't be allocated so that lookups always miss.
+static tTurretTile s_sTurretTileNone = {.uwTileX = TURRET_TILE_EMPTY};
+
+// Turret bobs don't need undraw, so slots may be reused each frame - queued
+// pointers are only checked for isUndrawRequired, which is same for all.
+static tBobNew s_pBobPool[TURRET_BOB_POOL_SIZE];
+static UBYTE s_ubBobPoolUsed;
+
+void turretListCreate(void) {
 	logBlockBegin("turretListCreate()");
-	s_fubMapWidth = fubMapWidth;
-	s_fubMapHeight = fubMapHeight;
+
+	// Alloc only as much turrets as there are on map
+	s_uwMaxTurrets = g_sMap.fuwTurretCount;
+	logWrite("Turret count: %hu\n", s_uwMaxTurrets);
 
 	g_uwTurretCount = 0;
-	s_uwMaxTurrets = (fubMapWidth/2 + 1) * fubMapHeight;
-	g_pTurrets = memAllocFastClear(s_uwMaxTurrets * sizeof(tTurret));
+	g_pTurrets = arenaAllocClear(
+		g_pMatchArena, MEMSTATS_TAG_TURRETS, MAX(1, s_uwMaxTurrets) * sizeof(tTurret)
+	);
+
+	// Power of two with at least twice as much slots as turrets
+	UWORD uwTileSlots = 16;
+	s_ubTurretTileShift = 16 - 4;
+	s_pTurretTiles = 0;
+	if(s_uwMaxTurrets > TURRET_TILE_SLOTS_MAX / 2) {
+		logWrite(
+			"ERR: Too many turrets: %hu, max %u\n",
+			s_uwMaxTurrets, TURRET_TILE_SLOTS_MAX / 2
+		);
+	}
+	else {
+		while(uwTileSlots < 2 * s_uwMaxTurrets) {
+			uwTileSlots <<= 1;
+			--s_ubTurretTileShift;
+		}
+		s_uwTurretTileMask = uwTileSlots - 1;
+		s_pTurretTiles = arenaAlloc(
+			g_pMatchArena, MEMSTATS_TAG_TURRETS, uwTileSlots * sizeof(tTurretTile)
+		);
+	}
+	if(!g_pTurrets || !s_pTurretTiles) {
+		logWrite("ERR: Couldn't create turret list\n");
+		s_uwMaxTurrets = 0;
+		s_pTurretTiles = &s_sTurretTileNone;
+		s_uwTurretTileMask = 0;
+		s_ubTurretTileShift = 16;
+		uwTileSlots = 0;
+	}
+	for(UWORD i = 0; i < uwTileSlots; ++i) {
+		s_pTurretTiles[i].uwTileX = TURRET_TILE_EMPTY;
+	}
 
-	// TODO: could be only number of turrets per frame + prev for undraw (or not)
-	for(UWORD i = 0; i < s_uwMaxTurrets; ++i) {
+	for(UBYTE i = 0; i < TURRET_BOB_POOL_SIZE; ++i) {
 		bobNewInit(
-			&g_pTurrets[i].sBob, TURRET_BOB_WIDTH, TURRET_BOB_HEIGHT, 0,
+			&s_pBobPool[i], TURRET_BOB_WIDTH, TURRET_BOB_HEIGHT, 0,
 			g_pTurretFrames[TEAM_NONE], 0, 0, 0
 		);
 	}
+	s_ubBobPoolUsed = 0;
 
 	logBlockEnd("turretListCreate()");
 }
@@ -46,16 +109,52 @@ void turretListCreate(FUBYTE fubMapWidth, FUBYTE fubMapHeight) {
 void turretListDestroy(void) {
 	logBlockBegin("turretListDestroy()");
 
-	memFree(g_pTurrets, s_uwMaxTurrets * sizeof(tTurret));
+	// Turret list is in match arena
+	g_uwTurretCount = 0;
 
 	logBlockEnd("turretListDestroy()");
 }
 
+static UWORD turretTileHash(tTilePos uwTileX, tTilePos uwTileY) {
+	// Fibonacci hashing - 2^16/phi multiplier, top bits of 16-bit product are
+	// the slot, so neighbouring tiles land in distant slots
+	UWORD uwKey = uwTileX ^ (uwTileY << 7);
+	UWORD uwProduct = (UWORD)(uwKey * 40503UL);
+	return (uwProduct >> s_ubTurretTileShift) & s_uwTurretTileMask;
+}
+
+static tTurretTile *turretTileFind(tTilePos uwTileX, tTilePos uwTileY) {
+	UWORD uwSlot = turretTileHash(uwTileX, uwTileY);
+	for(;;) {
+		tTurretTile *pTile = &s_pTurretTiles[uwSlot];
+		if(
+			pTile->uwTileX == TURRET_TILE_EMPTY ||
+			(pTile->uwTileX == uwTileX && pTile->uwTileY == uwTileY)
+		) {
+			return pTile;
+		}
+		uwSlot = (uwSlot + 1) & s_uwTurretTileMask;
+	}
+}
+
+UWORD turretGetAt(tTilePos uwTileX, tTilePos uwTileY) {
+	const tTurretTile *pTile = turretTileFind(uwTileX, uwTileY);
+	if(pTile->uwTileX == TURRET_TILE_EMPTY) {
+		return TURRET_INVALID;
+	}
+	return pTile->uwIdx;
+}
+
 UWORD turretAdd(UWORD uwTileX, UWORD uwTileY, UBYTE ubTeam) {
 	logBlockBegin(
 		"turretAdd(uwTileX: %hu, uwTileY: %hu, ubTeam: %hhu)",
 		uwTileX, uwTileY, ubTeam
 	);
+	if(g_uwTurretCount >= s_uwMaxTurrets) {
+		logWrite("ERR: No more room for turrets\n");
+		logBlockEnd("turretAdd()");
+		return TURRET_INVALID;
+	}
 
 	// Initial values
 	tTurret *pTurret = &g_pTurrets[g_uwTurretCount];
@@ -69,15 +168,11 @@ UWORD turretAdd(UWORD uwTileX, UWORD uwTileY, UBYTE ubTeam) {
 	pTurret->ubCooldown = 0;
 	pTurret->fubSeq = (uwTileX & 3) |	((uwTileY & 3) << 2);
 
-	bobNewSetBitMapOffset(&pTurret->sBob, angleToFrame(ubAngle) * TURRET_BOB_HEIGHT);
-
 	// Add to tile-based list
-	g_pTurretTiles[uwTileX][uwTileY] = g_uwTurretCount;
-
-	// Setup bob
-	pTurret->sBob.sPos.sUwCoord.uwX = pTurret->uwCenterX - TURRET_BOB_WIDTH/2;
-	pTurret->sBob.sPos.sUwCoord.uwY = pTurret->uwCenterY - TURRET_BOB_HEIGHT/2;
-	pTurret->sBob.pBitmap = g_pTurretFrames[ubTeam];
+	tTurretTile *pTile = turretTileFind(uwTileX, uwTileY);
+	pTile->uwTileX = uwTileX;
+	pTile->uwTileY = uwTileY;
+	pTile->uwIdx = g_uwTurretCount;
 
 	logBlockEnd("turretAdd()");
 	return g_uwTurretCount++;
@@ -98,7 +193,7 @@ void turretDestroy(UWORD uwIdx) {
 	// Remove from tile-based list
 	UWORD uwTileX = pTurret->uwCenterX >> MAP_TILE_SIZE;
 	UWORD uwTileY = pTurret->uwCenterY >> MAP_TILE_SIZE;
-	g_pTurretTiles[uwTileX][uwTileY] = TURRET_INVALID;
+	turretTileFind(uwTileX, uwTileY)->uwIdx = TURRET_INVALID;
 
 	// Add explosion
 	explosionsAdd(pTurret->uwCenterX, pTurret->uwCenterY);
@@ -128,9 +223,27 @@ static void turretUpdateTarget(tTurret *pTurret) {
 	}
 }
 
+static void turretPushBob(const tTurret *pTurret) {
+	const UWORD uwBobX = pTurret->uwCenterX - TURRET_BOB_WIDTH/2;
+	const UWORD uwBobY = pTurret->uwCenterY - TURRET_BOB_HEIGHT/2;
+	if(s_ubBobPoolUsed >= TURRET_BOB_POOL_SIZE) {
+		return;
+	}
+	tBobNew *pBob = &s_pBobPool[s_ubBobPoolUsed];
+	pBob->sPos.sUwCoord.uwX = uwBobX;
+	pBob->sPos.sUwCoord.uwY = uwBobY;
+	pBob->pBitmap = g_pTurretFrames[pTurret->ubTeam];
+	bobNewSetBitMapOffset(pBob, angleToFrame(pTurret->ubAngle) * TURRET_BOB_HEIGHT);
+	if(bobNewPush(pBob)) {
+		++s_ubBobPoolUsed;
+	}
+	// Otherwise it will be drawn on next draw seq if it gets visible
+}
+
 void turretSim(void) {
 	FUBYTE fubSeq = g_ulGameFrame & 15;
 	UBYTE ubDrawSeq = (g_ulGameFrame>>1) & 15;
+	s_ubBobPoolUsed = 0;
 
 	for(UWORD uwTurretIdx = 0; uwTurretIdx != s_uwMaxTurrets; ++uwTurretIdx) {
 		tTurret *pTurret = &g_pTurrets[uwTurretIdx];
@@ -154,9 +267,6 @@ void turretSim(void) {
 			if(pTurret->ubAngle >= ANGLE_360) {
 				pTurret->ubAngle -= ANGLE_360;
 			}
-			bobNewSetBitMapOffset(
-				&pTurret->sBob, angleToFrame(pTurret->ubAngle) * TURRET_BOB_HEIGHT
-			);
 		}
 		else if(pTurret->isTargeting && !pTurret->ubCooldown) {
 			tProjectileOwner uOwner;
@@ -166,7 +276,7 @@ void turretSim(void) {
 		}
 
 		if(pTurret->fubSeq == ubDrawSeq) {
-			bobNewPush(&pTurret->sBob);
+			turretPushBob(pTurret);
 		}
 	}
 }
@@ -175,22 +285,20 @@ void turretCapture(UWORD uwIdx, FUBYTE fubTeam) {
 	tTurret *pTurret = &g_pTurrets[uwIdx];
 	pTurret->ubTeam = fubTeam;
 	pTurret->isTargeting = 0;
-	pTurret->sBob.pBitmap = g_pTurretFrames[fubTeam];
 }
 
 tBitMap *turretGenerateFrames(const char *szPath) {
 	logBlockBegin("turretGenerateFrames(szPath: '%s')", szPath);
 
 	// Check for cache
-	char szBitmapFileName[100];
-	if(cacheIsValid(szPath)) {
-		sprintf(szBitmapFileName, "precalc/%s", szPath);
-		tBitMap *pBitmap = bitmapCreateFromFile(szBitmapFileName);
+	tBitMap *pBitmap = atlasGet(szPath, TURRET_FRAMES_VERSION, 0);
+	if(pBitmap) {
 		logBlockEnd("turretGenerateFrames()");
 		return pBitmap;
 	}
 
 	// Load source frame
+	char szBitmapFileName[100];
 	sprintf(szBitmapFileName, "data/%s", szPath);
 	tBitMap *pFirstFrame = bitmapCreateFromFile(szBitmapFileName);
 	UWORD uwFrameWidth = bitmapGetByteWidth(pFirstFrame) * 8;
@@ -201,21 +309,31 @@ tBitMap *turretGenerateFrames(const char *szPath) {
 		pFirstFrame->Depth, BMF_INTERLEAVED
 	);
 
-	UBYTE *pChunkySrc = memAllocFast(uwFrameWidth * uwFrameWidth);
-	chunkyFromBitmap(pFirstFrame, pChunkySrc, 0, 0, uwFrameWidth, uwFrameWidth);
+	UBYTE *pChunkySrc = memAllocFastTagged(
+		MEMSTATS_TAG_PRECALC, uwFrameWidth * uwFrameWidth
+	);
+	c2pBitmapToChunky(
+		pFirstFrame, pChunkySrc, 0, 0, uwFrameWidth, uwFrameWidth
+	);
 	bitmapDestroy(pFirstFrame);
 
 	// Get background for blending
-	UBYTE *pChunkyBg = memAllocFast(TURRET_BOB_WIDTH * TURRET_BOB_HEIGHT);
+	UBYTE *pChunkyBg = memAllocFastTagged(
+		MEMSTATS_TAG_PRECALC, TURRET_BOB_WIDTH * TURRET_BOB_HEIGHT
+	);
 	UWORD uwMargin = (MAP_FULL_TILE-uwFrameWidth) / 2;
-	chunkyFromBitmap(
+	c2pBitmapToChunky(
 		g_pMapTileset, pChunkyBg,
 		0, MAP_TILE_WALL*MAP_FULL_TILE + uwMargin,
 		TURRET_BOB_WIDTH, TURRET_BOB_HEIGHT
 	);
 
-	UBYTE *pChunkyRotated = memAllocFast(uwFrameWidth * uwFrameWidth);
-	UBYTE *pChunkyDst = memAllocFast(TURRET_BOB_WIDTH * TURRET_BOB_HEIGHT);
+	UBYTE *pChunkyRotated = memAllocFastTagged(
+		MEMSTATS_TAG_PRECALC, uwFrameWidth * uwFrameWidth
+	);
+	UBYTE *pChunkyDst = memAllocFastTagged(
+		MEMSTATS_TAG_PRECALC, TURRET_BOB_WIDTH * TURRET_BOB_HEIGHT
+	);
 	for(UBYTE ubFrame = 0; ubFrame < VEHICLE_BODY_ANGLE_COUNT; ++ubFrame) {
 		// Rotate frame
 		UBYTE ubAngle = (ANGLE_360 - (ubFrame<<1)) % ANGLE_360;
@@ -240,21 +358,25 @@ tBitMap *turretGenerateFrames(const char *szPath) {
 		}
 
 		// Put it on huge-ass bitmap
-		chunkyToBitmap(
+		c2pChunkyToBitmap(
 			pChunkyDst, pBitmapDst, 0, TURRET_BOB_HEIGHT*ubFrame,
 			TURRET_BOB_WIDTH, TURRET_BOB_HEIGHT
 		);
 	}
 
-	// Write cache
-	sprintf(szBitmapFileName, "precalc/%s", szPath);
-	bitmapSave(pBitmapDst, szBitmapFileName);
-	cacheGenerateChecksum(szPath);
+	// Atlas gets saved after all sheets are generated
+	atlasAdd(szPath, TURRET_FRAMES_VERSION, pBitmapDst, 0);
 
-	memFree(pChunkyBg, TURRET_BOB_WIDTH * TURRET_BOB_HEIGHT);
-	memFree(pChunkySrc, uwFrameWidth * uwFrameWidth);
-	memFree(pChunkyRotated, uwFrameWidth * uwFrameWidth);
-	memFree(pChunkyDst, TURRET_BOB_WIDTH * TURRET_BOB_HEIGHT);
+	memFreeTagged(
+		MEMSTATS_TAG_PRECALC, pChunkyBg, TURRET_BOB_WIDTH * TURRET_BOB_HEIGHT
+	);
+	memFreeTagged(MEMSTATS_TAG_PRECALC, pChunkySrc, uwFrameWidth * uwFrameWidth);
+	memFreeTagged(
+		MEMSTATS_TAG_PRECALC, pChunkyRotated, uwFrameWidth * uwFrameWidth
+	);
+	memFreeTagged(
+		MEMSTATS_TAG_PRECALC, pChunkyDst, TURRET_BOB_WIDTH * TURRET_BOB_HEIGHT
+	);
 	logBlockEnd("turretGenerateFrames()");
 	return pBitmapDst;
 }
@@ -4,19 +4,22 @@
 #include "gamestates/game/projectile.h"
 #include "gamestates/game/game.h"
 #include "gamestates/game/bob_new.h"
+#include "map.h"
 
 #define TURRET_INVALID      0xFFFF
 #define TURRET_MIN_DISTANCE (PROJECTILE_RANGE+32)
 #define TURRET_COOLDOWN     PROJECTILE_FRAME_LIFE
 #define TURRET_MAX_PROCESS_RANGE_Y ((WORLD_VPORT_HEIGHT>>MAP_TILE_SIZE) + 1)
+/// Max turret bobs pushed per frame - visible ones with matching draw seq.
+#define TURRET_BOB_POOL_SIZE 16
 
 /**
- *  Turret struct.
+ *  Turret struct - only fields needed by sim, render state is taken
+ *  from small bob pool when turret is drawn.
  *  Turrets can't have X = 0, because that's the way for checking
  *  if they are valid.
  */
 typedef struct _tTurret {
-	tBobNew sBob;
 	UWORD uwCenterX; ///< In pixels.
 	UWORD uwCenterY;
 	UBYTE ubTeam;     ///< See TEAM_* defines.
@@ -30,15 +33,22 @@ typedef struct _tTurret {
 extern tBitMap *g_pTurretFrames[TEAM_COUNT+1];
 extern UWORD g_uwTurretCount;
 extern tTurret *g_pTurrets;
-extern UWORD g_pTurretTiles[MAP_MAX_SIZE][MAP_MAX_SIZE];
 
-void turretListCreate(FUBYTE fubMapWidth, FUBYTE fubMapHeight);
+void turretListCreate(void);
 void turretListDestroy(void);
 
 UWORD turretAdd(UWORD uwX, UWORD uwY, UBYTE ubTeam);
 
 void turretDestroy(UWORD uwIdx);
 
+/**
+ * Finds turret standing on given tile.
+ * @param uwTileX Tile X coordinate.
+ * @param uwTileY Ditto, Y.
+ * @return Index of live turret on tile, otherwise TURRET_INVALID.
+ */
+UWORD turretGetAt(tTilePos uwTileX, tTilePos uwTileY);
+
 void turretCapture(UWORD uwIdx, FUBYTE fubTeam);
 
 void turretSim(void);
@@ -6,15 +6,34 @@
 #include "gamestates/game/team.h"
 #include "gamestates/game/worldmap.h"
 #include "gamestates/game/explosions.h"
+#include "gamestates/game/framecache.h"
 #include "gamestates/game/spawn.h"
 #include "gamestates/game/player.h"
 #include "vehicletypes.h"
 
+static void vehicleSetBodyFrame(tVehicle *pVehicle, UBYTE ubFrame) {
+	const tVehicleType *pType = pVehicle->pType;
+	UBYTE ubTeam = playerGetByVehicle(pVehicle)->ubTeam;
+	frameCacheSetBobFrame(
+		&pVehicle->sBob, pType->pMainFrames[ubTeam], pType->pMainMask,
+		pType->ubMainMirror, ubFrame
+	);
+}
+
+static void vehicleSetAuxFrame(tVehicle *pVehicle, UBYTE ubFrame) {
+	const tVehicleType *pType = pVehicle->pType;
+	UBYTE ubTeam = playerGetByVehicle(pVehicle)->ubTeam;
+	frameCacheSetBobFrame(
+		&pVehicle->sAuxBob, pType->pAuxFrames[ubTeam], pType->pAuxMask,
+		pType->ubAuxMirror, ubFrame
+	);
+}
+
 void vehicleInit(tVehicle *pVehicle, UBYTE ubVehicleType, UBYTE ubSpawnIdx) {
 	// Fill struct fields
 	pVehicle->pType = &g_pVehicleTypes[ubVehicleType];
-	pVehicle->fX = fix16_from_int((g_pSpawns[ubSpawnIdx].ubTileX << MAP_TILE_SIZE) + MAP_HALF_TILE);
-	pVehicle->fY = fix16_from_int((g_pSpawns[ubSpawnIdx].ubTileY << MAP_TILE_SIZE) + MAP_HALF_TILE);
+	pVehicle->fX = fix16_from_int((g_pSpawns[ubSpawnIdx].uwTileX << MAP_TILE_SIZE) + MAP_HALF_TILE);
+	pVehicle->fY = fix16_from_int((g_pSpawns[ubSpawnIdx].uwTileY << MAP_TILE_SIZE) + MAP_HALF_TILE);
 	pVehicle->uwX = fix16_to_int(pVehicle->fX);
 	pVehicle->uwY = fix16_to_int(pVehicle->fY);
 	pVehicle->ubBodyAngle = ANGLE_90;
@@ -26,11 +45,15 @@ void vehicleInit(tVehicle *pVehicle, UBYTE ubVehicleType, UBYTE ubSpawnIdx) {
 	pVehicle->bRotDiv = 0;
 	pVehicle->ubCooldown = 0;
 
-	UBYTE ubTeam = playerGetByVehicle(pVehicle)->ubTeam;
-	pVehicle->sBob.pBitmap = g_pVehicleTypes[ubVehicleType].pMainFrames[ubTeam];
-	pVehicle->sBob.pMask = g_pVehicleTypes[ubVehicleType].pMainMask;
-	pVehicle->sAuxBob.pBitmap = g_pVehicleTypes[ubVehicleType].pAuxFrames[ubTeam];
-	pVehicle->sAuxBob.pMask = g_pVehicleTypes[ubVehicleType].pAuxMask;
+	vehicleSetBodyFrame(pVehicle, angleToFrame(pVehicle->ubBodyAngle));
+	if(pVehicle->pType->pAuxMask) {
+		vehicleSetAuxFrame(pVehicle, angleToFrame(pVehicle->ubTurretAngle));
+	}
+	else {
+		frameCacheReleaseBob(&pVehicle->sAuxBob);
+		pVehicle->sAuxBob.pBitmap = 0;
+		pVehicle->sAuxBob.pMask = 0;
+	}
 	spawnSetBusy(ubSpawnIdx, SPAWN_BUSY_SURFACING, VEHICLE_TYPE_TANK);
 }
 
@@ -114,7 +137,7 @@ static UBYTE vehicleCollidesWithWall(
 	for(p = 0; p != 8; ++p) {
 		UWORD uwPX = uwX + pCollisionPoints[p].bX;
 		UWORD uwPY = uwY + pCollisionPoints[p].bY;
-		UBYTE ubLogicTile = g_sMap.pData[uwPX >> MAP_TILE_SIZE][uwPY >> MAP_TILE_SIZE].ubIdx;
+		UBYTE ubLogicTile = mapLogicAt(uwPX >> MAP_TILE_SIZE, uwPY >> MAP_TILE_SIZE);
 		if(
 			ubLogicTile == MAP_LOGIC_WALL    ||
 			ubLogicTile == MAP_LOGIC_SENTRY0 ||
@@ -209,9 +232,7 @@ void vehicleSteerTank(
 		// Angle frame
 		pVehicle->ubBodyAngle = ubNewAngle;
 		pVehicle->ubTurretAngle = ubNewTurretAngle;
-		bobNewSetBitMapOffset(
-			&pVehicle->sBob, angleToFrame(ubNewAngle) * VEHICLE_BODY_HEIGHT
-		);
+		vehicleSetBodyFrame(pVehicle, angleToFrame(ubNewAngle));
 	}
 
 	pVehicle->ubTurretAngle += ANGLE_360 + getDeltaAngleDirection(
@@ -220,9 +241,7 @@ void vehicleSteerTank(
 	if(pVehicle->ubTurretAngle >= ANGLE_360) {
 		pVehicle->ubTurretAngle -= ANGLE_360;
 	}
-	bobNewSetBitMapOffset(
-		&pVehicle->sAuxBob, angleToFrame(pVehicle->ubTurretAngle) * VEHICLE_BODY_HEIGHT
-	);
+	vehicleSetAuxFrame(pVehicle, angleToFrame(pVehicle->ubTurretAngle));
 	pVehicle->sAuxBob.sPos.ulYX = pVehicle->sBob.sPos.ulYX;
 
 	// Fire straight
@@ -307,6 +326,6 @@ void vehicleSteerJeep(
 		pVehicle->sBob.sPos.sUwCoord.uwY = pVehicle->uwY - VEHICLE_BODY_HEIGHT/2;
 		// Angle frame
 		pVehicle->ubBodyAngle = ubNewAngle;
-		bobNewSetBitMapOffset(&pVehicle->sBob, angleToFrame(ubNewAngle) * VEHICLE_BODY_HEIGHT);
+		vehicleSetBodyFrame(pVehicle, angleToFrame(ubNewAngle));
 	}
 }
@@ -4,7 +4,7 @@
 #include <ace/managers/viewport/simplebuffer.h>
 #include <ace/utils/extview.h>
 #include "map.h"
-#include "mapjson.h"
+#include "blitstats.h"
 #include "gamestates/game/team.h"
 #include "gamestates/game/building.h"
 #include "gamestates/game/turret.h"
@@ -14,8 +14,6 @@
 #define BUFFER_BACK 1
 #define PENDING_QUEUE_MAX 255
 
-static UBYTE s_pBufferTiles[MAP_MAX_SIZE][MAP_MAX_SIZE] = {0};
-
 static tTileCoord s_pTilesToRedraw[2][PENDING_QUEUE_MAX] = {{{0, 0}}};
 static UBYTE s_ubPendingTiles[2];
 static UBYTE s_ubBufIdx;
@@ -56,34 +54,36 @@ static UBYTE worldMapIsRoadFriend(UBYTE ubMapTile) {
 	);
 }
 
-static UBYTE worldMapCheckWater(UBYTE ubX, UBYTE ubY) {
+static UBYTE worldMapCheckWater(tTilePos uwX, tTilePos uwY) {
 	UBYTE ubOut;
-	if(ubX && g_sMap.pData[ubX-1][ubY].ubIdx == MAP_LOGIC_WATER) {
-		if(ubY && g_sMap.pData[ubX][ubY-1].ubIdx == MAP_LOGIC_WATER)
+	if(uwX && mapLogicAt(uwX-1, uwY) == MAP_LOGIC_WATER) {
+		if(uwY && mapLogicAt(uwX, uwY-1) == MAP_LOGIC_WATER)
 			ubOut = 1;
-		else if(ubY < g_sMap.fubHeight-1 && g_sMap.pData[ubX][ubY+1].ubIdx == MAP_LOGIC_WATER)
+		else if(uwY < g_sMap.uwHeight-1 && mapLogicAt(uwX, uwY+1) == MAP_LOGIC_WATER)
 			ubOut = 2;
 		else
-			ubOut = 5 + (ubY & 1);
+			ubOut = 5 + (uwY & 1);
 	}
-	else if(ubX < g_sMap.fubWidth-1 && g_sMap.pData[ubX+1][ubY].ubIdx == MAP_LOGIC_WATER) {
-		if(ubY && g_sMap.pData[ubX][ubY-1].ubIdx == MAP_LOGIC_WATER)
+	else if(uwX < g_sMap.uwWidth-1 && mapLogicAt(uwX+1, uwY) == MAP_LOGIC_WATER) {
+		if(uwY && mapLogicAt(uwX, uwY-1) == MAP_LOGIC_WATER)
 			ubOut = 3;
-		else if(ubY < g_sMap.fubHeight-1 && g_sMap.pData[ubX][ubY+1].ubIdx == MAP_LOGIC_WATER)
+		else if(uwY < g_sMap.uwHeight-1 && mapLogicAt(uwX, uwY+1) == MAP_LOGIC_WATER)
 			ubOut = 4;
 		else
-			ubOut = 7 + (ubY & 1);
+			ubOut = 7 + (uwY & 1);
 	}
-	else if(ubY && g_sMap.pData[ubX][ubY-1].ubIdx == MAP_LOGIC_WATER)
-		ubOut = 9 + (ubX & 1);
-	else if(ubY < g_sMap.fubHeight-1 && g_sMap.pData[ubX][ubY+1].ubIdx == MAP_LOGIC_WATER)
-		ubOut = 11 + (ubX & 1);
+	else if(uwY && mapLogicAt(uwX, uwY-1) == MAP_LOGIC_WATER)
+		ubOut = 9 + (uwX & 1);
+	else if(uwY < g_sMap.uwHeight-1 && mapLogicAt(uwX, uwY+1) == MAP_LOGIC_WATER)
+		ubOut = 11 + (uwX & 1);
 	else
 		ubOut = 0;
 	return ubOut;
 }
 
-static UBYTE worldMapCheckNeighbours(UBYTE ubX, UBYTE ubY, UBYTE (*checkFn)(UBYTE)) {
+static UBYTE worldMapCheckNeighbours(
+	tTilePos uwX, tTilePos uwY, UBYTE (*checkFn)(UBYTE)
+) {
 	UBYTE ubOut;
 	const UBYTE ubE = 8;
 	const UBYTE ubW = 4;
@@ -91,21 +91,22 @@ static UBYTE worldMapCheckNeighbours(UBYTE ubX, UBYTE ubY, UBYTE (*checkFn)(UBYT
 	const UBYTE ubN = 1;
 
 	ubOut = 0;
-	if(ubX && checkFn(g_sMap.pData[ubX+1][ubY].ubIdx))
+	// Planes are sized exactly to map, so don't peek past its edges
+	if(uwX+1 < g_sMap.uwWidth && checkFn(mapLogicAt(uwX+1, uwY)))
 		ubOut |= ubE;
-	if(ubX-1 < g_sMap.fubWidth && checkFn(g_sMap.pData[ubX-1][ubY].ubIdx))
+	if(uwX && checkFn(mapLogicAt(uwX-1, uwY)))
 		ubOut |= ubW;
-	if(ubY && checkFn(g_sMap.pData[ubX][ubY-1].ubIdx))
+	if(uwY && checkFn(mapLogicAt(uwX, uwY-1)))
 		ubOut |= ubN;
-	if(ubY-1 < g_sMap.fubHeight && checkFn(g_sMap.pData[ubX][ubY+1].ubIdx))
+	if(uwY+1 < g_sMap.uwHeight && checkFn(mapLogicAt(uwX, uwY+1)))
 		ubOut |= ubS;
 	return ubOut;
 }
 
-static void worldMapDrawTile(UBYTE ubX, UBYTE ubY) {
-	blitCopyAligned(
-		g_pMapTileset, 0, s_pBufferTiles[ubX][ubY] << MAP_TILE_SIZE,
-		s_pBuffers[s_ubBufIdx], ubX << MAP_TILE_SIZE, ubY << MAP_TILE_SIZE,
+static void worldMapDrawTile(tTilePos uwX, tTilePos uwY) {
+	blitCopyAlignedTagged(
+		BLITSTATS_TAG_MAP, g_pMapTileset, 0, mapGfxAt(uwX, uwY) << MAP_TILE_SIZE,
+		s_pBuffers[s_ubBufIdx], uwX << MAP_TILE_SIZE, uwY << MAP_TILE_SIZE,
 		MAP_FULL_TILE, MAP_FULL_TILE
 	);
 }
@@ -113,37 +114,37 @@ static void worldMapDrawTile(UBYTE ubX, UBYTE ubY) {
 static void worldMapInitFromLogic(void) {
 	logBlockBegin("worldMapInitFromLogic()");
 	// 2nd data pass - generate additional logic
-	for(UBYTE x = g_sMap.fubWidth; x--;) {
-		for(UBYTE y = g_sMap.fubHeight; y--;) {
-			UBYTE ubTileIdx = g_sMap.pData[x][y].ubIdx;
+	for(tTilePos x = g_sMap.uwWidth; x--;) {
+		for(tTilePos y = g_sMap.uwHeight; y--;) {
+			UBYTE ubTileIdx = mapLogicAt(x, y);
 			switch(ubTileIdx) {
 				case MAP_LOGIC_WATER:
-					s_pBufferTiles[x][y] = worldMapTileWater();
+					mapGfxAt(x, y) = worldMapTileWater();
 					break;
 				case MAP_LOGIC_SPAWN0:
 					spawnAdd(x, y, TEAM_NONE);
-					s_pBufferTiles[x][y] = worldMapTileSpawn(TEAM_NONE, 0);
+					mapGfxAt(x, y) = worldMapTileSpawn(TEAM_NONE, 0);
 					break;
 				case MAP_LOGIC_SPAWN1:
 					spawnAdd(x, y, TEAM_BLUE);
-					s_pBufferTiles[x][y] = worldMapTileSpawn(TEAM_BLUE, 0);
+					mapGfxAt(x, y) = worldMapTileSpawn(TEAM_BLUE, 0);
 					break;
 				case MAP_LOGIC_SPAWN2:
 					spawnAdd(x, y, TEAM_RED);
-					s_pBufferTiles[x][y] = worldMapTileSpawn(TEAM_RED, 0);
+					mapGfxAt(x, y) = worldMapTileSpawn(TEAM_RED, 0);
 					break;
 				case MAP_LOGIC_ROAD:
-					s_pBufferTiles[x][y] = worldMapTileRoad(x, y);
+					mapGfxAt(x, y) = worldMapTileRoad(x, y);
 					break;
 				case MAP_LOGIC_WALL_VERTICAL:
-					g_sMap.pData[x][y].ubIdx = MAP_LOGIC_WALL;
+					mapLogicAt(x, y) = MAP_LOGIC_WALL;
 				case MAP_LOGIC_WALL:
-					g_sMap.pData[x][y].ubBuilding = buildingAdd(x, y, BUILDING_TYPE_WALL, TEAM_NONE);
-					s_pBufferTiles[x][y] = worldMapTileWall(x, y);
+					mapBuildingAt(x, y) = buildingAdd(x, y, BUILDING_TYPE_WALL, TEAM_NONE);
+					mapGfxAt(x, y) = worldMapTileWall(x, y);
 					break;
 				case MAP_LOGIC_FLAG1:
 				case MAP_LOGIC_FLAG2:
-					g_sMap.pData[x][y].ubBuilding = buildingAdd(
+					mapBuildingAt(x, y) = buildingAdd(
 						x, y,
 						BUILDING_TYPE_FLAG,
 						ubTileIdx == MAP_LOGIC_FLAG1 ? TEAM_BLUE : TEAM_RED
@@ -154,28 +155,28 @@ static void worldMapInitFromLogic(void) {
 				case MAP_LOGIC_SENTRY2:
 					// Change logic type so that projectiles will threat turret walls
 					// in same way as any other
-					g_sMap.pData[x][y].ubIdx = MAP_LOGIC_WALL;
-					g_sMap.pData[x][y].ubBuilding = buildingAdd(
+					mapLogicAt(x, y) = MAP_LOGIC_WALL;
+					mapBuildingAt(x, y) = buildingAdd(
 						x, y,
 						BUILDING_TYPE_TURRET,
 						ubTileIdx == MAP_LOGIC_SENTRY0? TEAM_NONE
 							: ubTileIdx == MAP_LOGIC_SENTRY1? TEAM_BLUE
 							:TEAM_RED
 					);
-					s_pBufferTiles[x][y] = worldMapTileTurret();
+					mapGfxAt(x, y) = worldMapTileTurret();
 					break;
 				case MAP_LOGIC_CAPTURE0:
-					s_pBufferTiles[x][y] = worldMapTileCapture(TEAM_NONE);
+					mapGfxAt(x, y) = worldMapTileCapture(TEAM_NONE);
 					break;
 				case MAP_LOGIC_CAPTURE1:
-					s_pBufferTiles[x][y] = worldMapTileCapture(TEAM_BLUE);
+					mapGfxAt(x, y) = worldMapTileCapture(TEAM_BLUE);
 					break;
 				case MAP_LOGIC_CAPTURE2:
-					s_pBufferTiles[x][y] = worldMapTileCapture(TEAM_RED);
+					mapGfxAt(x, y) = worldMapTileCapture(TEAM_RED);
 					break;
 				case MAP_LOGIC_DIRT:
 				default:
-					s_pBufferTiles[x][y] = worldMapTileDirt(x, y);
+					mapGfxAt(x, y) = worldMapTileDirt(x, y);
 			}
 			// Draw immediately
 			s_ubBufIdx = BUFFER_FRONT;
@@ -196,19 +197,19 @@ void worldMapCreate(tBitMap *pFront, tBitMap *pBack) {
 	s_pBuffers[BUFFER_BACK] = pBack;
 	s_ubBufIdx = BUFFER_BACK;
 
-	tJson *pMapJson = jsonCreate(g_sMap.szPath);
-	UWORD uwTokPts = jsonGetDom(pMapJson, "controlPoints");
-	UWORD uwControlPointCount = pMapJson->pTokens[uwTokPts].size;
-
 	buildingManagerReset();
-	controlManagerCreate(uwControlPointCount);
+	controlManagerCreate(g_sMap.fubControlPointCount);
 	spawnManagerCreate(g_sMap.fubSpawnCount);
-	turretListCreate(g_sMap.fubWidth, g_sMap.fubHeight);
+	turretListCreate();
 	worldMapInitFromLogic();
 
-	// Read remaining JSON data
-	mapJsonReadControlPoints(pMapJson);
-	jsonDestroy(pMapJson);
+	// Control points need spawns & turrets to be already placed
+	for(FUBYTE i = 0; i < g_sMap.fubControlPointCount; ++i) {
+		const tMapControlPoint *pPoint = &g_sMap.pControlPoints[i];
+		controlAddPoint(
+			pPoint->szName, pPoint->uwCaptureX, pPoint->uwCaptureY
+		);
+	}
 
 	logBlockEnd("worldMapCreate()");
 }
@@ -221,15 +222,15 @@ void worldMapDestroy(void) {
 	logBlockEnd("worldMapDestroy()");
 }
 
-void worldMapRequestUpdateTile(UBYTE ubTileX, UBYTE ubTileY) {
+void worldMapRequestUpdateTile(tTilePos uwTileX, tTilePos uwTileY) {
 	// TODO when scrolling trick: omit if not on buffer
 	// TODO when scrolling trick: omit if not yet drawn on redraw margin
 	++s_ubPendingTiles[BUFFER_BACK];
-	s_pTilesToRedraw[BUFFER_BACK][s_ubPendingTiles[BUFFER_BACK]].ubX = ubTileX;
-	s_pTilesToRedraw[BUFFER_BACK][s_ubPendingTiles[BUFFER_BACK]].ubY = ubTileY;
+	s_pTilesToRedraw[BUFFER_BACK][s_ubPendingTiles[BUFFER_BACK]].uwX = uwTileX;
+	s_pTilesToRedraw[BUFFER_BACK][s_ubPendingTiles[BUFFER_BACK]].uwY = uwTileY;
 	++s_ubPendingTiles[BUFFER_FRONT];
-	s_pTilesToRedraw[BUFFER_FRONT][s_ubPendingTiles[BUFFER_FRONT]].ubX = ubTileX;
-	s_pTilesToRedraw[BUFFER_FRONT][s_ubPendingTiles[BUFFER_FRONT]].ubY = ubTileY;
+	s_pTilesToRedraw[BUFFER_FRONT][s_ubPendingTiles[BUFFER_FRONT]].uwX = uwTileX;
+	s_pTilesToRedraw[BUFFER_FRONT][s_ubPendingTiles[BUFFER_FRONT]].uwY = uwTileY;
 }
 
 /**
@@ -237,21 +238,23 @@ void worldMapRequestUpdateTile(UBYTE ubTileX, UBYTE ubTileY) {
  */
 void worldMapUpdateTiles(void) {
 	if(s_ubPendingTiles[s_ubBufIdx]) {
-		UBYTE ubTileX = s_pTilesToRedraw[s_ubBufIdx][s_ubPendingTiles[s_ubBufIdx]].ubX;
-		UBYTE ubTileY = s_pTilesToRedraw[s_ubBufIdx][s_ubPendingTiles[s_ubBufIdx]].ubY;
-		worldMapDrawTile(ubTileX, ubTileY);
+		tTilePos uwTileX = s_pTilesToRedraw[s_ubBufIdx][s_ubPendingTiles[s_ubBufIdx]].uwX;
+		tTilePos uwTileY = s_pTilesToRedraw[s_ubBufIdx][s_ubPendingTiles[s_ubBufIdx]].uwY;
+		worldMapDrawTile(uwTileX, uwTileY);
 		--s_ubPendingTiles[s_ubBufIdx];
 	}
 }
 
-void worldMapSetTile(UBYTE ubX, UBYTE ubY, UBYTE ubLogicTileIdx) {
-	s_pBufferTiles[ubX][ubY] = ubLogicTileIdx;
-	worldMapRequestUpdateTile(ubX, ubY);
+void worldMapSetTile(tTilePos uwX, tTilePos uwY, UBYTE ubLogicTileIdx) {
+	mapGfxAt(uwX, uwY) = ubLogicTileIdx;
+	worldMapRequestUpdateTile(uwX, uwY);
 }
 
-void worldMapTrySetTile(UBYTE ubX, UBYTE ubY, UBYTE ubLogicTileIdx) {
-	if(s_pBufferTiles[ubX][ubY] != ubLogicTileIdx) {
-		worldMapSetTile(ubX, ubY, ubLogicTileIdx);
+void worldMapTrySetTile(
+	tTilePos uwX, tTilePos uwY, UBYTE ubLogicTileIdx
+) {
+	if(mapGfxAt(uwX, uwY) != ubLogicTileIdx) {
+		worldMapSetTile(uwX, uwY, ubLogicTileIdx);
 	}
 }
 
@@ -259,13 +262,13 @@ UBYTE worldMapTileWater(void) {
 	return MAP_TILE_WATER;
 }
 
-UBYTE worldMapTileDirt(UBYTE ubX, UBYTE ubY) {
-	return MAP_TILE_DIRT + worldMapCheckWater(ubX, ubY);
+UBYTE worldMapTileDirt(tTilePos uwX, tTilePos uwY) {
+	return MAP_TILE_DIRT + worldMapCheckWater(uwX, uwY);
 }
 
-UBYTE worldMapTileRoad(UBYTE ubX, UBYTE ubY) {
+UBYTE worldMapTileRoad(tTilePos uwX, tTilePos uwY) {
 	return MAP_TILE_ROAD + worldMapCheckNeighbours(
-		ubX, ubY, worldMapIsRoadFriend
+		uwX, uwY, worldMapIsRoadFriend
 	);
 }
 
@@ -277,9 +280,9 @@ UBYTE worldMapTileSpawn(UBYTE ubTeam, UBYTE ubIsActive) {
 	return ubTileIdx;
 }
 
-UBYTE worldMapTileWall(UBYTE ubX, UBYTE ubY) {
+UBYTE worldMapTileWall(tTilePos uwX, tTilePos uwY) {
 	return MAP_TILE_WALL + worldMapCheckNeighbours(
-		ubX, ubY, worldMapIsWall
+		uwX, uwY, worldMapIsWall
 	);
 }
 
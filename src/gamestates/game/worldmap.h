@@ -54,8 +54,8 @@
 
 
 typedef struct _tTileCoord {
-	UBYTE ubX;
-	UBYTE ubY;
+	tTilePos uwX;
+	tTilePos uwY;
 } tTileCoord;
 
 void worldMapCreate(tBitMap *pFront, tBitMap *pBack);
@@ -64,7 +64,7 @@ void worldMapDestroy(void);
 
 void worldMapSwapBuffers(void);
 
-UBYTE worldMapTileFromLogic(FUBYTE ubTileX, FUBYTE ubTileY);
+UBYTE worldMapTileFromLogic(tTilePos uwTileX, tTilePos uwTileY);
 
 UBYTE worldMapIsWall(UBYTE ubMapTile);
 
@@ -72,23 +72,23 @@ void worldMapUpdateTiles(void);
 
 //-------------------------------------------------- Tile manipulation functions
 
-void worldMapSetTile(UBYTE ubX, UBYTE ubY, UBYTE ubLogicTileIdx);
+void worldMapSetTile(tTilePos uwX, tTilePos uwY, UBYTE ubLogicTileIdx);
 
-void worldMapTrySetTile(UBYTE ubX, UBYTE ubY, UBYTE ubLogicTileIdx);
+void worldMapTrySetTile(tTilePos uwX, tTilePos uwY, UBYTE ubLogicTileIdx);
 
-void worldMapRequestUpdateTile(UBYTE ubTileX, UBYTE ubTileY);
+void worldMapRequestUpdateTile(tTilePos uwTileX, tTilePos uwTileY);
 
 //----------------------------------------------------------- Tile idx functions
 
 UBYTE worldMapTileWater(void);
 
-UBYTE worldMapTileDirt(UBYTE ubX, UBYTE ubY);
+UBYTE worldMapTileDirt(tTilePos uwX, tTilePos uwY);
 
-UBYTE worldMapTileRoad(UBYTE ubX, UBYTE ubY);
+UBYTE worldMapTileRoad(tTilePos uwX, tTilePos uwY);
 
 UBYTE worldMapTileSpawn(UBYTE ubTeam, UBYTE ubIsActive);
 
-UBYTE worldMapTileWall(UBYTE ubX, UBYTE ubY);
+UBYTE worldMapTileWall(tTilePos uwX, tTilePos uwY);
 
 UBYTE worldMapTileTurret(void);
 
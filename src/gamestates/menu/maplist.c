@@ -7,7 +7,9 @@
 #include <ace/managers/mouse.h>
 #include <ace/managers/system.h>
 #include <ace/utils/dir.h>
+#include <ace/utils/file.h>
 #include "cursor.h"
+#include "cache.h"
 #include "map.h"
 #include "gamestates/menu/menu.h"
 #include "gamestates/menu/button.h"
@@ -16,72 +18,221 @@
 #include "gamestates/game/game.h"
 
 #define MAPLIST_FILENAME_MAX 108
+#define MAPLIST_ALLOC_STEP 16
+#define MAPLIST_INDEX_PATH "precalc/maps/index.dat"
+#define MAPLIST_INDEX_VERSION 2
 
 #define MAPLIST_COLOR_MINIMAP_BORDER 1
 
-typedef char tMapListEntry[MAPLIST_FILENAME_MAX];
+typedef struct _tMapListEntry {
+	char szFileName[MAPLIST_FILENAME_MAX];
+	tCacheStamp sStamp; ///< Of map source file, for detecting changes.
+	char szName[MAP_NAME_MAX];
+	char szAuthor[MAP_AUTHOR_MAX];
+	tTilePos uwWidth;
+	tTilePos uwHeight;
+	UBYTE ubMode;
+	UBYTE ubPad;
+} tMapListEntry;
 
 typedef struct _tMapList {
 	UWORD uwMapCount;
+	UWORD uwMapAlloc;
 	tMapListEntry *pMaps;
 } tMapList;
 
 static tMapList s_sMapList;
 static tListCtl *s_pListCtl;
+static tMinimap s_sMinimap;
+
+static void mapListGetMinimapPath(const char *szFileName, char *szPath) {
+	// precalc/maps/name.mmp for data/maps/name.json
+	sprintf(
+		szPath, "precalc/maps/%.*s.mmp",
+		(int)(strlen(szFileName) - strlen(".json")), szFileName
+	);
+}
+
+static tMapListEntry *mapListIndexLoad(UWORD *pCount) {
+	*pCount = 0;
+	tFile *pFile = fileOpen(MAPLIST_INDEX_PATH, "rb");
+	if(!pFile) {
+		return 0;
+	}
+	UWORD uwVersion, uwCount;
+	fileRead(pFile, &uwVersion, sizeof(UWORD));
+	fileRead(pFile, &uwCount, sizeof(UWORD));
+	if(uwVersion != MAPLIST_INDEX_VERSION || !uwCount) {
+		fileClose(pFile);
+		return 0;
+	}
+	ULONG ulSize = uwCount * sizeof(tMapListEntry);
+	tMapListEntry *pEntries = memAllocFast(ulSize);
+	if(fileRead(pFile, pEntries, ulSize) != ulSize) {
+		memFree(pEntries, ulSize);
+		fileClose(pFile);
+		return 0;
+	}
+	fileClose(pFile);
+	*pCount = uwCount;
+	return pEntries;
+}
+
+static void mapListIndexSave(void) {
+	tFile *pFile = fileOpen(MAPLIST_INDEX_PATH, "wb");
+	if(!pFile) {
+		logWrite("WARN: Couldn't write map index\n");
+		return;
+	}
+	UWORD uwVersion = MAPLIST_INDEX_VERSION;
+	fileWrite(pFile, &uwVersion, sizeof(UWORD));
+	fileWrite(pFile, &s_sMapList.uwMapCount, sizeof(UWORD));
+	fileWrite(
+		pFile, s_sMapList.pMaps, s_sMapList.uwMapCount * sizeof(tMapListEntry)
+	);
+	fileClose(pFile);
+}
+
+static const tMapListEntry *mapListIndexFind(
+	const tMapListEntry *pEntries, UWORD uwCount, const char *szFileName,
+	UWORD uwHint
+) {
+	// Directory order rarely changes, so try same position first
+	if(uwHint < uwCount && !strcmp(pEntries[uwHint].szFileName, szFileName)) {
+		return &pEntries[uwHint];
+	}
+	for(UWORD i = 0; i < uwCount; ++i) {
+		if(!strcmp(pEntries[i].szFileName, szFileName)) {
+			return &pEntries[i];
+		}
+	}
+	return 0;
+}
+
+static tMapListEntry *mapListAddEntry(void) {
+	if(s_sMapList.uwMapCount >= s_sMapList.uwMapAlloc) {
+		UWORD uwNewAlloc = s_sMapList.uwMapAlloc + MAPLIST_ALLOC_STEP;
+		tMapListEntry *pNewMaps = memAllocFast(
+			uwNewAlloc * sizeof(tMapListEntry)
+		);
+		if(s_sMapList.pMaps) {
+			memcpy(
+				pNewMaps, s_sMapList.pMaps,
+				s_sMapList.uwMapCount * sizeof(tMapListEntry)
+			);
+			memFree(
+				s_sMapList.pMaps, s_sMapList.uwMapAlloc * sizeof(tMapListEntry)
+			);
+		}
+		s_sMapList.pMaps = pNewMaps;
+		s_sMapList.uwMapAlloc = uwNewAlloc;
+	}
+	tMapListEntry *pEntry = &s_sMapList.pMaps[s_sMapList.uwMapCount++];
+	memset(pEntry, 0, sizeof(tMapListEntry));
+	return pEntry;
+}
+
+/**
+ * Loads map to fill its list entry & writes its minimap.
+ */
+static void mapListBuildEntry(tMapListEntry *pEntry) {
+	mapInit(pEntry->szFileName);
+	memcpy(pEntry->szName, g_sMap.szName, MAP_NAME_MAX);
+	memcpy(pEntry->szAuthor, g_sMap.szAuthor, MAP_AUTHOR_MAX);
+	pEntry->ubMode = g_sMap.ubMode;
+	pEntry->uwWidth = g_sMap.uwWidth;
+	pEntry->uwHeight = g_sMap.uwHeight;
+
+	char szMinimapPath[MAPLIST_FILENAME_MAX + 20];
+	mapListGetMinimapPath(pEntry->szFileName, szMinimapPath);
+	minimapCreate(&s_sMinimap, &g_sMap);
+	minimapSave(&s_sMinimap, szMinimapPath);
+}
 
 static void mapListPrepareList(void) {
 	systemUse();
-	// Get map count
+	logBlockBegin("mapListPrepareList()");
+	UWORD uwIndexCount;
+	tMapListEntry *pIndex = mapListIndexLoad(&uwIndexCount);
 	s_sMapList.uwMapCount = 0;
+	s_sMapList.uwMapAlloc = 0;
+	s_sMapList.pMaps = 0;
+
+	// Single dir pass - only new & changed maps get loaded
+	UBYTE isIndexChanged = 0;
 	tDir *pDir = dirOpen("data/maps");
-	char szFileName[MAPLIST_FILENAME_MAX];
-	if(!pDir) {
-		systemUnuse();
-		return;
-	}
-	while(dirRead(pDir, szFileName, MAPLIST_FILENAME_MAX)) {
-		if(!strcmp(&szFileName[strlen(szFileName)-strlen(".json")], ".json")) {
-			++s_sMapList.uwMapCount;
+	if(pDir) {
+		char szFileName[MAPLIST_FILENAME_MAX];
+		char szPath[MAPLIST_FILENAME_MAX + 20];
+		while(dirRead(pDir, szFileName, MAPLIST_FILENAME_MAX)) {
+			UWORD uwLength = strlen(szFileName);
+			if(
+				uwLength <= strlen(".json") ||
+				strcmp(&szFileName[uwLength - strlen(".json")], ".json")
+			) {
+				continue;
+			}
+			tMapListEntry *pEntry = mapListAddEntry();
+			strcpy(pEntry->szFileName, szFileName);
+			sprintf(szPath, "data/maps/%s", szFileName);
+			cacheGetStamp(szPath, &pEntry->sStamp);
+
+			const tMapListEntry *pIndexed = mapListIndexFind(
+				pIndex, uwIndexCount, szFileName, s_sMapList.uwMapCount - 1
+			);
+			if(
+				pIndexed && cacheStampsEqual(&pIndexed->sStamp, &pEntry->sStamp)
+			) {
+				*pEntry = *pIndexed;
+			}
+			else {
+				logWrite("Indexing %s\n", szFileName);
+				mapListBuildEntry(pEntry);
+				isIndexChanged = 1;
+			}
 		}
+		dirClose(pDir);
 	}
-	dirClose(pDir);
 
-	// Alloc map list
-	if(!s_sMapList.uwMapCount) {
-		systemUnuse();
-		return;
+	if(isIndexChanged || s_sMapList.uwMapCount != uwIndexCount) {
+		mapListIndexSave();
 	}
-	s_sMapList.pMaps = memAllocFast(s_sMapList.uwMapCount * sizeof(tMapListEntry));
-	UBYTE i = 0;
-	pDir = dirOpen("data/maps");
-	while(dirRead(pDir, szFileName, MAPLIST_FILENAME_MAX)) {
-		if(!strcmp(&szFileName[strlen(szFileName)-strlen(".json")], ".json")) {
-			memcpy(s_sMapList.pMaps[i], szFileName, MAPLIST_FILENAME_MAX);
-			++i;
-		}
+	if(pIndex) {
+		memFree(pIndex, uwIndexCount * sizeof(tMapListEntry));
 	}
-	dirClose(pDir);
+	logWrite("Map count: %hu\n", s_sMapList.uwMapCount);
+	logBlockEnd("mapListPrepareList()");
 	systemUnuse();
 }
 
 static void mapListSelect(UWORD uwIdx) {
+	if(uwIdx >= s_sMapList.uwMapCount) {
+		return;
+	}
 	systemUse();
-	mapInit(s_sMapList.pMaps[uwIdx]);
-	minimapDraw(g_pMenuBuffer->pBack, &g_sMap);
+	const tMapListEntry *pEntry = &s_sMapList.pMaps[uwIdx];
+	char szMinimapPath[MAPLIST_FILENAME_MAX + 20];
+	mapListGetMinimapPath(pEntry->szFileName, szMinimapPath);
+	if(!minimapLoad(&s_sMinimap, szMinimapPath)) {
+		// Minimap wasn't written, e.g. there's no precalc dir - make it now
+		mapInit(pEntry->szFileName);
+		minimapCreate(&s_sMinimap, &g_sMap);
+	}
+	minimapDraw(g_pMenuBuffer->pBack, &s_sMinimap);
 	char szBfr[20 + MAX(MAP_AUTHOR_MAX, MAP_NAME_MAX)];
 	blitRect(
 		g_pMenuBuffer->pBack, MAPLIST_MINIMAP_X,
 		MAPLIST_MINIMAP_Y + MAPLIST_MINIMAP_WIDTH + 16,
 		320-MAPLIST_MINIMAP_X, 3*(g_pMenuFont->uwHeight + 1), MENU_COLOR_BG
 	);
-	sprintf(szBfr, "Map name: %s", g_sMap.szName);
+	sprintf(szBfr, "Map name: %s", pEntry->szName);
 	fontFillTextBitMap(g_pMenuFont, g_pMenuTextBitmap, szBfr);
 	fontDrawTextBitMap(g_pMenuBuffer->pBack, g_pMenuTextBitmap,
 		MAPLIST_MINIMAP_X,
 		MAPLIST_MINIMAP_Y + MAPLIST_MINIMAP_WIDTH + 16 + 0*(g_pMenuFont->uwHeight+1),
 		MENU_COLOR_TEXT, 0
 	);
-	sprintf(szBfr, "Author: %s", g_sMap.szAuthor);
+	sprintf(szBfr, "Author: %s", pEntry->szAuthor);
 	fontFillTextBitMap(g_pMenuFont, g_pMenuTextBitmap, szBfr);
 	fontDrawTextBitMap(g_pMenuBuffer->pBack, g_pMenuTextBitmap,
 		MAPLIST_MINIMAP_X,
@@ -91,10 +242,10 @@ static void mapListSelect(UWORD uwIdx) {
 	const char szModeConquest[] = "Mode: Conquest";
 	const char szModeCtf[] = "Mode: CTF";
 	const char *pMode = 0;
-	if(g_sMap.ubMode == MAP_MODE_CONQUEST) {
+	if(pEntry->ubMode == MAP_MODE_CONQUEST) {
 		pMode = szModeConquest;
 	}
-	else if(g_sMap.ubMode == MAP_MODE_CTF) {
+	else if(pEntry->ubMode == MAP_MODE_CTF) {
 		pMode = szModeCtf;
 	}
 	fontFillTextBitMap(g_pMenuFont, g_pMenuTextBitmap, pMode);
@@ -107,6 +258,13 @@ static void mapListSelect(UWORD uwIdx) {
 }
 
 static void mapListOnBtnStart(void) {
+	if(s_pListCtl->uwEntrySel >= s_sMapList.uwMapCount) {
+		return;
+	}
+	// List shows cached data only - load selected map for real
+	systemUse();
+	mapInit(s_sMapList.pMaps[s_pListCtl->uwEntrySel].szFileName);
+	systemUnuse();
 	g_isLocalBot = 0;
 	gamePopState(); // From menu substate
 	gameChangeState(gsGameCreate, gsGameLoop, gsGameDestroy);
@@ -142,9 +300,11 @@ void mapListCreate(void) {
 		mapListOnMapChange
 	);
 	for(UWORD i = 0; i != s_sMapList.uwMapCount; ++i) {
-		s_sMapList.pMaps[i][strlen(s_sMapList.pMaps[i])-5] = '\0';
-		listCtlAddEntry(s_pListCtl, s_sMapList.pMaps[i]);
-		s_sMapList.pMaps[i][strlen(s_sMapList.pMaps[i])] = '.';
+		// Display name without extension
+		char szEntryName[MAPLIST_FILENAME_MAX];
+		strcpy(szEntryName, s_sMapList.pMaps[i].szFileName);
+		szEntryName[strlen(szEntryName) - strlen(".json")] = '\0';
+		listCtlAddEntry(s_pListCtl, szEntryName);
 	}
 	listCtlDraw(s_pListCtl);
 
@@ -186,7 +346,9 @@ void mapListLoop(void) {
 void mapListDestroy(void) {
 	systemUse();
 	logBlockBegin("mapListDestroy()");
-	memFree(s_sMapList.pMaps, s_sMapList.uwMapCount * sizeof(tMapListEntry));
+	if(s_sMapList.pMaps) {
+		memFree(s_sMapList.pMaps, s_sMapList.uwMapAlloc * sizeof(tMapListEntry));
+	}
 	listCtlDestroy(s_pListCtl);
 	buttonListDestroy();
 	logBlockEnd("mapListDestroy()");
@@ -1,9 +1,13 @@
 #include "gamestates/menu/minimap.h"
 #include "gamestates/menu/maplist.h"
+#include <string.h>
+#include <ace/managers/blit.h>
 #include <ace/utils/bitmap.h>
+#include <ace/utils/file.h>
 #include "map.h"
 #include "gamestates/menu/menu.h"
 
+// Ordered by importance - cell gets highest color of tiles it covers
 #define MINIMAP_COLOR_WATER     0
 #define MINIMAP_COLOR_TERRAIN   1
 #define MINIMAP_COLOR_WALL      2
@@ -14,59 +18,243 @@
 #define MINIMAP_COLOR_CONTROL1  7
 #define MINIMAP_COLOR_CONTROL2  8
 
-void minimapDraw(tBitMap *pDest, tMap *pMap) {
+// Each run needs at least one cell & there's a gap between runs
+#define MINIMAP_RUNS_MAX ((MINIMAP_CELLS_MAX + 1) / 2)
+
+typedef struct _tMinimapRun {
+	UBYTE ubStart; ///< First cell.
+	UBYTE ubEnd;   ///< One past last cell.
+	UBYTE ubTop;   ///< Row in which run has started.
+} tMinimapRun;
+
+static UBYTE minimapGetTileColor(UBYTE ubLogic) {
+	switch(ubLogic) {
+		case MAP_LOGIC_WATER:
+			return MINIMAP_COLOR_WATER;
+		case MAP_LOGIC_WALL:
+		case MAP_LOGIC_SENTRY0:
+		case MAP_LOGIC_SENTRY1:
+		case MAP_LOGIC_SENTRY2:
+			return MINIMAP_COLOR_WALL;
+		case MAP_LOGIC_SPAWN0:
+			return MINIMAP_COLOR_SPAWN0;
+		case MAP_LOGIC_SPAWN1:
+			return MINIMAP_COLOR_SPAWN1;
+		case MAP_LOGIC_SPAWN2:
+			return MINIMAP_COLOR_SPAWN2;
+		case MAP_LOGIC_CAPTURE0:
+			return MINIMAP_COLOR_CONTROL0;
+		case MAP_LOGIC_CAPTURE1:
+			return MINIMAP_COLOR_CONTROL1;
+		case MAP_LOGIC_CAPTURE2:
+			return MINIMAP_COLOR_CONTROL2;
+		default:
+			return MINIMAP_COLOR_TERRAIN;
+	}
+}
+
+static inline UBYTE minimapGetCell(const tMinimap *pMinimap, UWORD uwIdx) {
+	UBYTE ubPacked = pMinimap->pCells[uwIdx >> 1];
+	return (uwIdx & 1) ? (ubPacked & 0xF) : (ubPacked >> 4);
+}
+
+static inline void minimapSetCell(
+	tMinimap *pMinimap, UWORD uwIdx, UBYTE ubColor
+) {
+	UBYTE *pPacked = &pMinimap->pCells[uwIdx >> 1];
+	if(uwIdx & 1) {
+		*pPacked = (*pPacked & 0xF0) | ubColor;
+	}
+	else {
+		*pPacked = (*pPacked & 0x0F) | (ubColor << 4);
+	}
+}
+
+/**
+ * Finds runs of given color in minimap row. Run starts & ends on cell of given
+ * color, but may contain cells of more important colors.
+ * @param pMinimap Minimap to be scanned.
+ * @param y Row index.
+ * @param ubColor Color of runs.
+ * @param pRuns Gets runs, sorted by start, with top set to y.
+ * @return Number of runs found.
+ */
+static UBYTE minimapGetRuns(
+	const tMinimap *pMinimap, UBYTE y, UBYTE ubColor, tMinimapRun *pRuns
+) {
+	UBYTE ubCount = 0;
+	UWORD uwRowIdx = y * pMinimap->ubWidth;
+	UBYTE x = 0;
+	while(x != pMinimap->ubWidth) {
+		if(minimapGetCell(pMinimap, uwRowIdx + x) != ubColor) {
+			++x;
+			continue;
+		}
+		tMinimapRun *pRun = &pRuns[ubCount++];
+		pRun->ubStart = x;
+		pRun->ubTop = y;
+		pRun->ubEnd = ++x;
+		// Extend over more important cells, but end on own color
+		while(x != pMinimap->ubWidth) {
+			UBYTE ubCell = minimapGetCell(pMinimap, uwRowIdx + x);
+			if(ubCell < ubColor) {
+				break;
+			}
+			++x;
+			if(ubCell == ubColor) {
+				pRun->ubEnd = x;
+			}
+		}
+	}
+	return ubCount;
+}
+
+static UWORD minimapGetPackedSize(const tMinimap *pMinimap) {
+	return (pMinimap->ubWidth * pMinimap->ubHeight + 1) >> 1;
+}
+
+void minimapCreate(tMinimap *pMinimap, const tMap *pMap) {
+	// Each cell covers ubFactor x ubFactor tiles
+	tTilePos uwMapSize = MAX(pMap->uwWidth, pMap->uwHeight);
+	UBYTE ubFactor = (uwMapSize + MINIMAP_CELLS_MAX - 1) / MINIMAP_CELLS_MAX;
+	ubFactor = MAX(1, ubFactor);
+	pMinimap->ubWidth = (pMap->uwWidth + ubFactor - 1) / ubFactor;
+	pMinimap->ubHeight = (pMap->uwHeight + ubFactor - 1) / ubFactor;
+	memset(pMinimap->pCells, 0, sizeof(pMinimap->pCells)); // Water
+
+	// Unused chunks contain only water, so there's no need to scan them
+	const tChunkedGrid *pLogic = &pMap->sLogic;
+	for(UWORD uwChunkY = 0; uwChunkY < pLogic->uwChunksY; ++uwChunkY) {
+		tTilePos uwY1 = uwChunkY << GRID_CHUNK_BITS;
+		tTilePos uwY2 = MIN(uwY1 + GRID_CHUNK_SIZE, pMap->uwHeight);
+		for(UWORD uwChunkX = 0; uwChunkX < pLogic->uwChunksX; ++uwChunkX) {
+			UWORD uwChunkIdx = uwChunkY * pLogic->uwChunksX + uwChunkX;
+			if(!chunkedGridIsChunkUsed(pLogic, uwChunkIdx)) {
+				continue;
+			}
+			tTilePos uwX1 = uwChunkX << GRID_CHUNK_BITS;
+			tTilePos uwX2 = MIN(uwX1 + GRID_CHUNK_SIZE, pMap->uwWidth);
+			for(tTilePos x = uwX1; x < uwX2; ++x) {
+				UBYTE ubCellX = x / ubFactor;
+				for(tTilePos y = uwY1; y < uwY2; ++y) {
+					UWORD uwIdx = (y / ubFactor) * pMinimap->ubWidth + ubCellX;
+					UBYTE ubColor = minimapGetTileColor(
+						chunkedGridAt(pLogic, UBYTE, x, y)
+					);
+					if(ubColor > minimapGetCell(pMinimap, uwIdx)) {
+						minimapSetCell(pMinimap, uwIdx, ubColor);
+					}
+				}
+			}
+		}
+	}
+}
+
+UBYTE minimapLoad(tMinimap *pMinimap, const char *szPath) {
+	tFile *pFile = fileOpen(szPath, "rb");
+	if(!pFile) {
+		return 0;
+	}
+	UBYTE isOk = (
+		fileRead(pFile, &pMinimap->ubWidth, sizeof(UBYTE)) == sizeof(UBYTE) &&
+		fileRead(pFile, &pMinimap->ubHeight, sizeof(UBYTE)) == sizeof(UBYTE) &&
+		pMinimap->ubWidth <= MINIMAP_CELLS_MAX &&
+		pMinimap->ubHeight <= MINIMAP_CELLS_MAX
+	);
+	if(isOk) {
+		UWORD uwSize = minimapGetPackedSize(pMinimap);
+		isOk = fileRead(pFile, pMinimap->pCells, uwSize) == uwSize;
+	}
+	fileClose(pFile);
+	return isOk;
+}
+
+UBYTE minimapSave(const tMinimap *pMinimap, const char *szPath) {
+	tFile *pFile = fileOpen(szPath, "wb");
+	if(!pFile) {
+		return 0;
+	}
+	fileWrite(pFile, &pMinimap->ubWidth, sizeof(UBYTE));
+	fileWrite(pFile, &pMinimap->ubHeight, sizeof(UBYTE));
+	fileWrite(pFile, pMinimap->pCells, minimapGetPackedSize(pMinimap));
+	fileClose(pFile);
+	return 1;
+}
+
+void minimapDraw(tBitMap *pDest, const tMinimap *pMinimap) {
 	// Clear Map area
 	blitRect(
 		pDest, MAPLIST_MINIMAP_X, MAPLIST_MINIMAP_Y,
 		MAPLIST_MINIMAP_WIDTH, MAPLIST_MINIMAP_WIDTH, MINIMAP_COLOR_WATER
 	);
+	if(!pMinimap->ubWidth || !pMinimap->ubHeight) {
+		return;
+	}
 
 	// Padding, scale
-	UBYTE ubScale = MAPLIST_MINIMAP_WIDTH / MAX(pMap->fubWidth, pMap->fubHeight);
-	UBYTE ubPadX = (MAPLIST_MINIMAP_WIDTH - pMap->fubWidth*ubScale) >> 1;
-	UBYTE ubPadY = (MAPLIST_MINIMAP_WIDTH - pMap->fubHeight*ubScale) >> 1;
+	UBYTE ubScale = MAPLIST_MINIMAP_WIDTH / MAX(
+		pMinimap->ubWidth, pMinimap->ubHeight
+	);
+	UBYTE ubPadX = (MAPLIST_MINIMAP_WIDTH - pMinimap->ubWidth*ubScale) >> 1;
+	UBYTE ubPadY = (MAPLIST_MINIMAP_WIDTH - pMinimap->ubHeight*ubScale) >> 1;
 
-	UBYTE ubTileColor;
-	for (FUBYTE y = 0; y != pMap->fubHeight; ++y) {
-		for (FUBYTE x = 0; x != pMap->fubWidth; ++x) {
-			switch (pMap->pData[x][y].ubIdx) {
-				case MAP_LOGIC_WATER:
-					ubTileColor = MINIMAP_COLOR_WATER;
-					break;
-				case MAP_LOGIC_WALL:
-				case MAP_LOGIC_SENTRY0:
-				case MAP_LOGIC_SENTRY1:
-				case MAP_LOGIC_SENTRY2:
-					ubTileColor = MINIMAP_COLOR_WALL;
-					break;
-				case MAP_LOGIC_SPAWN0:
-					ubTileColor = MINIMAP_COLOR_SPAWN0;
-					break;
-				case MAP_LOGIC_SPAWN1:
-					ubTileColor = MINIMAP_COLOR_SPAWN1;
-					break;
-				case MAP_LOGIC_SPAWN2:
-					ubTileColor = MINIMAP_COLOR_SPAWN2;
-					break;
-				case MAP_LOGIC_CAPTURE0:
-					ubTileColor = MINIMAP_COLOR_CONTROL0;
-					break;
-				case MAP_LOGIC_CAPTURE1:
-					ubTileColor = MINIMAP_COLOR_CONTROL1;
-					break;
-				case MAP_LOGIC_CAPTURE2:
-					ubTileColor = MINIMAP_COLOR_CONTROL2;
-					break;
-				default:
-					ubTileColor = MINIMAP_COLOR_TERRAIN;
+	// Cells are painted in order of importance, so runs of each color may
+	// extend over cells of more important ones - they get painted over later.
+	// Same runs in consecutive rows are merged into single rect.
+	UWORD uwColorMask = 0;
+	for(UWORD i = pMinimap->ubWidth * pMinimap->ubHeight; i--;) {
+		uwColorMask |= 1 << minimapGetCell(pMinimap, i);
+	}
+	tMinimapRun pRunBuffers[2][MINIMAP_RUNS_MAX];
+	for(
+		UBYTE ubColor = MINIMAP_COLOR_TERRAIN; ubColor <= MINIMAP_COLOR_CONTROL2;
+		++ubColor
+	) {
+		if(!(uwColorMask & (1 << ubColor))) {
+			continue;
+		}
+		tMinimapRun *pPrev = pRunBuffers[0], *pCurr = pRunBuffers[1];
+		UBYTE ubPrevCount = 0;
+		// Extra empty row at the end flushes runs reaching bottom edge
+		for(UBYTE y = 0; y <= pMinimap->ubHeight; ++y) {
+			UBYTE ubCurrCount = 0;
+			if(y != pMinimap->ubHeight) {
+				ubCurrCount = minimapGetRuns(pMinimap, y, ubColor, pCurr);
 			}
-
-			blitRect(
-				pDest,
-				MAPLIST_MINIMAP_X + ubPadX + x * ubScale,
-				MAPLIST_MINIMAP_Y + ubPadY + y * ubScale,
-				ubScale, ubScale, ubTileColor
-			);
+			// Both lists are sorted by start, so match them in single pass
+			UBYTE i = 0, j = 0;
+			while(i != ubPrevCount) {
+				if(
+					j != ubCurrCount &&
+					pCurr[j].ubStart == pPrev[i].ubStart &&
+					pCurr[j].ubEnd == pPrev[i].ubEnd
+				) {
+					// Run continues
+					pCurr[j].ubTop = pPrev[i].ubTop;
+					++i;
+					++j;
+				}
+				else if(j == ubCurrCount || pPrev[i].ubStart <= pCurr[j].ubStart) {
+					// Run has ended in previous row
+					const tMinimapRun *pRun = &pPrev[i];
+					blitRect(
+						pDest,
+						MAPLIST_MINIMAP_X + ubPadX + pRun->ubStart * ubScale,
+						MAPLIST_MINIMAP_Y + ubPadY + pRun->ubTop * ubScale,
+						(pRun->ubEnd - pRun->ubStart) * ubScale,
+						(y - pRun->ubTop) * ubScale, ubColor
+					);
+					++i;
+				}
+				else {
+					// New run, its top is already set
+					++j;
+				}
+			}
+			tMinimapRun *pTmp = pPrev;
+			pPrev = pCurr;
+			pCurr = pTmp;
+			ubPrevCount = ubCurrCount;
 		}
 	}
 }
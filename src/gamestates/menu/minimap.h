@@ -5,6 +5,42 @@
 #include <ace/utils/bitmap.h>
 #include "map.h"
 
-void minimapDraw(tBitMap *pDest, tMap *pMap);
+#define MINIMAP_CELLS_MAX 64
+
+/**
+ * Low-res map preview. Each cell covers square block of map tiles & holds
+ * most important color found in it. Colors are packed two per byte,
+ * row-major, first cell in upper nibble.
+ */
+typedef struct _tMinimap {
+	UBYTE ubWidth;  ///< In cells.
+	UBYTE ubHeight; ///< Ditto.
+	UBYTE pCells[MINIMAP_CELLS_MAX * MINIMAP_CELLS_MAX / 2];
+} tMinimap;
+
+/**
+ * Builds minimap from map's logic plane.
+ * @param pMinimap Minimap to be filled.
+ * @param pMap Loaded map.
+ */
+void minimapCreate(tMinimap *pMinimap, const tMap *pMap);
+
+/**
+ * Loads minimap previously written with minimapSave().
+ * @param pMinimap Minimap to be filled.
+ * @param szPath Path to minimap file.
+ * @return 1 on success, otherwise 0.
+ */
+UBYTE minimapLoad(tMinimap *pMinimap, const char *szPath);
+
+/**
+ * Writes minimap, storing only used cells.
+ * @param pMinimap Minimap to be written.
+ * @param szPath Destination file path.
+ * @return 1 on success, otherwise 0.
+ */
+UBYTE minimapSave(const tMinimap *pMinimap, const char *szPath);
+
+void minimapDraw(tBitMap *pDest, const tMinimap *pMinimap);
 
 #endif // GUARD_OF_GAMESTATES_MENU_MINIMAP_H
@@ -1,8 +1,13 @@
 #include "gamestates/precalc/precalc.h"
+#include <string.h>
 #include <ace/managers/log.h>
 #include <ace/managers/game.h>
 #include <ace/utils/font.h>
 #include <ace/utils/palette.h>
+#include <ace/utils/dir.h>
+#include "atlas.h"
+#include "cache.h"
+#include "map.h"
 #include "vehicletypes.h"
 #include "gamestates/menu/menu.h"
 #include "gamestates/game/projectile.h"
@@ -10,6 +15,7 @@
 #include "gamestates/game/gamemath.h"
 
 #define PRECALC_BPP 4
+#define PRECALC_FILENAME_MAX 108
 // Colors
 #define PRECALC_COLOR_TEXT             13
 #define PRECALC_COLOR_PROGRESS_OUTLINE 15
@@ -93,7 +99,12 @@ void precalcLoop(void) {
 	}
 	logBlockBegin("precalcLoop()");
 
+	// Generated files are written there - they're not shipped with game
+	cacheCreateDir("precalc");
+	cacheCreateDir("precalc/maps");
+
 	precalcIncreaseProgress(10, "Initializing vehicle types");
+	atlasLoad();
 	vehicleTypesCreate();
 
 	// TODO load tileset for turret use
@@ -104,9 +115,29 @@ void precalcLoop(void) {
 	g_pTurretFrames[TEAM_RED] = turretGenerateFrames("vehicles/turret/turret_red.bm");
 	g_pTurretFrames[TEAM_BLUE] = turretGenerateFrames("vehicles/turret/turret_blue.bm");
 	g_pTurretFrames[TEAM_NONE] = turretGenerateFrames("vehicles/turret/turret_gray.bm");
+	atlasSave();
 
 	precalcIncreaseProgress(10, "Working on projectiles");
 
+	// Compile maps so that game won't need to parse JSON
+	precalcIncreaseProgress(10, "Compiling maps");
+	tDir *pDir = dirOpen("data/maps");
+	if(pDir) {
+		char szFileName[PRECALC_FILENAME_MAX];
+		while(dirRead(pDir, szFileName, PRECALC_FILENAME_MAX)) {
+			UWORD uwLength = strlen(szFileName);
+			if(
+				uwLength > strlen(".json") &&
+				!strcmp(&szFileName[uwLength - strlen(".json")], ".json")
+			) {
+				mapInit(szFileName);
+			}
+		}
+		dirClose(pDir);
+	}
+	mapDestroy();
+	cacheManifestFlush();
+
 	// View is no longer needed
 	viewLoad(0);
 	viewDestroy(s_pView);
@@ -127,8 +158,9 @@ void precalcDestroy(void) {
 
 	vehicleTypesDestroy();
 	for(UBYTE i = 0; i < 3; ++i) {
-		bitmapDestroy(g_pTurretFrames[i]);
+		g_pTurretFrames[i] = 0;
 	}
+	atlasDestroy();
 	bitmapDestroy(g_pMapTileset);
 
 	logBlockEnd("precalcDestroy()");
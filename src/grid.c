@@ -0,0 +1,78 @@
+#include "grid.h"
+#include <string.h>
+#include <ace/managers/log.h>
+
+UBYTE gridCreate(
+	tGrid *pGrid, tArena *pArena, UBYTE ubTag, UWORD uwWidth, UWORD uwHeight,
+	UBYTE ubElementSize, UBYTE ubMajor
+) {
+	pGrid->pData = arenaAllocClear(
+		pArena, ubTag, uwWidth * uwHeight * ubElementSize
+	);
+	if(!pGrid->pData) {
+		logWrite("ERR: Couldn't allocate %hux%hu grid\n", uwWidth, uwHeight);
+		return 0;
+	}
+	pGrid->uwWidth = uwWidth;
+	pGrid->uwHeight = uwHeight;
+	pGrid->ubElementSize = ubElementSize;
+	if(ubMajor == GRID_COLUMN_MAJOR) {
+		pGrid->uwStrideX = uwHeight;
+		pGrid->uwStrideY = 1;
+	}
+	else {
+		pGrid->uwStrideX = 1;
+		pGrid->uwStrideY = uwWidth;
+	}
+	return 1;
+}
+
+void gridFill(tGrid *pGrid, UBYTE ubValue) {
+	memset(
+		pGrid->pData, ubValue,
+		pGrid->uwWidth * pGrid->uwHeight * pGrid->ubElementSize
+	);
+}
+
+UBYTE chunkedGridCreate(
+	tChunkedGrid *pGrid, tArena *pArena, UBYTE ubTag, UWORD uwWidth,
+	UWORD uwHeight, UBYTE ubElementSize, const UBYTE *pChunkUsage
+) {
+	pGrid->uwWidth = uwWidth;
+	pGrid->uwHeight = uwHeight;
+	pGrid->uwChunksX = gridChunkCount(uwWidth);
+	pGrid->uwChunksY = gridChunkCount(uwHeight);
+	pGrid->ubElementSize = ubElementSize;
+	UWORD uwChunkCount = pGrid->uwChunksX * pGrid->uwChunksY;
+	UWORD uwChunkSize = chunkedGridGetChunkSize(pGrid);
+
+	pGrid->pChunks = arenaAlloc(pArena, ubTag, uwChunkCount * sizeof(UBYTE*));
+	pGrid->pShared = arenaAllocClear(pArena, ubTag, uwChunkSize);
+	if(!pGrid->pChunks || !pGrid->pShared) {
+		logWrite("ERR: Couldn't allocate %hux%hu chunk table\n", uwWidth, uwHeight);
+		return 0;
+	}
+	for(UWORD i = 0; i < uwChunkCount; ++i) {
+		if(!pChunkUsage[i]) {
+			pGrid->pChunks[i] = pGrid->pShared;
+			continue;
+		}
+		pGrid->pChunks[i] = arenaAllocClear(pArena, ubTag, uwChunkSize);
+		if(!pGrid->pChunks[i]) {
+			logWrite("ERR: Couldn't allocate chunk %hu\n", i);
+			return 0;
+		}
+	}
+	return 1;
+}
+
+void chunkedGridFill(tChunkedGrid *pGrid, UBYTE ubValue) {
+	UWORD uwChunkCount = pGrid->uwChunksX * pGrid->uwChunksY;
+	UWORD uwChunkSize = chunkedGridGetChunkSize(pGrid);
+	memset(pGrid->pShared, ubValue, uwChunkSize);
+	for(UWORD i = 0; i < uwChunkCount; ++i) {
+		if(chunkedGridIsChunkUsed(pGrid, i)) {
+			memset(pGrid->pChunks[i], ubValue, uwChunkSize);
+		}
+	}
+}
@@ -0,0 +1,151 @@
+#ifndef GUARD_OF_GRID_H
+#define GUARD_OF_GRID_H
+
+#include <ace/types.h>
+#include <ace/macros.h>
+#include "arena.h"
+
+// Grid layouts - pick one which keeps inner loop's neighbours adjacent
+#define GRID_COLUMN_MAJOR 0 ///< (x,y) and (x,y+1) are adjacent in memory.
+#define GRID_ROW_MAJOR 1    ///< (x,y) and (x+1,y) are adjacent in memory.
+
+/**
+ * Contiguous 2D array of fixed-size elements.
+ * Whole grid is a single allocation, so there are no per-column pointers
+ * to chase.
+ */
+typedef struct _tGrid {
+	UBYTE *pData;
+	UWORD uwWidth;
+	UWORD uwHeight;
+	UWORD uwStrideX; ///< Element offset between (x,y) and (x+1,y).
+	UWORD uwStrideY; ///< Element offset between (x,y) and (x,y+1).
+	UBYTE ubElementSize;
+} tGrid;
+
+/**
+ * Accesses grid element as lvalue of given type.
+ * Type size must match element size passed to gridCreate().
+ */
+#define gridAt(pGrid, tType, uwX, uwY) \
+	(((tType*)(pGrid)->pData)[ \
+		(uwX) * (pGrid)->uwStrideX + (uwY) * (pGrid)->uwStrideY \
+	])
+
+/**
+ * Returns pointer to first element of given line along the major axis,
+ * i.e. column x for GRID_COLUMN_MAJOR and row y for GRID_ROW_MAJOR.
+ * Consecutive elements of line are adjacent.
+ */
+#define gridLine(pGrid, tType, uwIdx) \
+	(&((tType*)(pGrid)->pData)[(uwIdx) * MAX( \
+		(pGrid)->uwStrideX, (pGrid)->uwStrideY \
+	)])
+
+/**
+ * Allocates grid data from arena.
+ * There is no destroy fn - data is released along with arena.
+ * @param pGrid Grid struct to be filled.
+ * @param pArena Arena from which grid's data will be allocated.
+ * @param ubTag Memstats tag of subsystem which owns grid.
+ * @param uwWidth Number of columns.
+ * @param uwHeight Number of rows.
+ * @param ubElementSize Size of single element, in bytes.
+ * @param ubMajor Memory layout, see GRID_*_MAJOR defines.
+ * @return 1 on success, otherwise 0.
+ */
+UBYTE gridCreate(
+	tGrid *pGrid, tArena *pArena, UBYTE ubTag, UWORD uwWidth, UWORD uwHeight,
+	UBYTE ubElementSize, UBYTE ubMajor
+);
+
+/**
+ * Sets each byte of grid's data to given value.
+ * @param pGrid Grid to be filled.
+ * @param ubValue Value to be written.
+ */
+void gridFill(tGrid *pGrid, UBYTE ubValue);
+
+// Chunked grid - chunk side is power of two so that lookups are shifts
+#define GRID_CHUNK_BITS 5
+#define GRID_CHUNK_SIZE (1 << GRID_CHUNK_BITS)
+#define GRID_CHUNK_MASK (GRID_CHUNK_SIZE - 1)
+
+/**
+ * 2D array split into GRID_CHUNK_SIZE x GRID_CHUNK_SIZE chunks, each one
+ * column-major. Only chunks marked as used get memory of their own - all
+ * other ones point to single shared chunk, so memory scales with used area.
+ * Since shared chunk is aliased, values written to it must be same for all
+ * tiles of unused chunks.
+ */
+typedef struct _tChunkedGrid {
+	UBYTE **pChunks; ///< Row-major chunk table.
+	UBYTE *pShared;  ///< Data of all unused chunks.
+	UWORD uwWidth;
+	UWORD uwHeight;
+	UWORD uwChunksX;
+	UWORD uwChunksY;
+	UBYTE ubElementSize;
+} tChunkedGrid;
+
+#define gridChunkIdx(pGrid, uwX, uwY) ( \
+	((uwY) >> GRID_CHUNK_BITS) * (pGrid)->uwChunksX + ((uwX) >> GRID_CHUNK_BITS) \
+)
+
+/**
+ * Accesses chunked grid element as lvalue of given type.
+ */
+#define chunkedGridAt(pGrid, tType, uwX, uwY) \
+	(((tType*)(pGrid)->pChunks[gridChunkIdx(pGrid, uwX, uwY)])[ \
+		(((uwX) & GRID_CHUNK_MASK) << GRID_CHUNK_BITS) | ((uwY) & GRID_CHUNK_MASK) \
+	])
+
+/**
+ * Returns number of chunks needed along given dimension.
+ */
+#define gridChunkCount(uwSize) (((uwSize) + GRID_CHUNK_MASK) >> GRID_CHUNK_BITS)
+
+/**
+ * Allocates chunked grid data from arena.
+ * @param pGrid Grid struct to be filled.
+ * @param pArena Arena from which grid's data will be allocated.
+ * @param ubTag Memstats tag of subsystem which owns grid.
+ * @param uwWidth Number of columns.
+ * @param uwHeight Number of rows.
+ * @param ubElementSize Size of single element, in bytes.
+ * @param pChunkUsage Row-major array with non-zero byte for each chunk
+ * which needs its own memory.
+ * @return 1 on success, otherwise 0.
+ */
+UBYTE chunkedGridCreate(
+	tChunkedGrid *pGrid, tArena *pArena, UBYTE ubTag, UWORD uwWidth,
+	UWORD uwHeight, UBYTE ubElementSize, const UBYTE *pChunkUsage
+);
+
+/**
+ * Sets each byte of all chunks, including shared one, to given value.
+ * @param pGrid Grid to be filled.
+ * @param ubValue Value to be written.
+ */
+void chunkedGridFill(tChunkedGrid *pGrid, UBYTE ubValue);
+
+/**
+ * Checks if chunk has memory of its own.
+ * @param pGrid Grid to be checked.
+ * @param uwChunkIdx Row-major chunk idx.
+ * @return 1 if chunk is used, 0 if it's aliased to shared chunk.
+ */
+static inline UBYTE chunkedGridIsChunkUsed(
+	const tChunkedGrid *pGrid, UWORD uwChunkIdx
+) {
+	return pGrid->pChunks[uwChunkIdx] != pGrid->pShared;
+}
+
+/**
+ * Returns size of single chunk's data, in bytes.
+ */
+static inline UWORD chunkedGridGetChunkSize(const tChunkedGrid *pGrid) {
+	return GRID_CHUNK_SIZE * GRID_CHUNK_SIZE * pGrid->ubElementSize;
+}
+
+#endif // GUARD_OF_GRID_H
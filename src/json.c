@@ -1,115 +1,159 @@
 #include "json.h"
 #include <stdlib.h>
+#include <string.h>
 #include <ace/managers/log.h>
-#include <ace/managers/memory.h>
 #include <ace/utils/file.h>
+#include "memstats.h"
+
+// Initial token array size guess, grown by doubling if too small
+#define JSON_BYTES_PER_TOKEN 16
+#define JSON_TOKEN_ALLOC_MIN 32
+#define JSON_TOKEN_ALLOC_MAX 16384
+
+static UBYTE jsonGrowTokens(tJson *pJson) {
+	UWORD uwNewAlloc = pJson->uwTokenAlloc * 2;
+	if(uwNewAlloc <= pJson->uwTokenAlloc) {
+		// UWORD overflow - can't be indexed anyway
+		return 0;
+	}
+	jsmntok_t *pNewTokens = memAllocFastTagged(
+		MEMSTATS_TAG_JSON, uwNewAlloc * sizeof(jsmntok_t)
+	);
+	if(!pNewTokens) {
+		return 0;
+	}
+	memcpy(pNewTokens, pJson->pTokens, pJson->uwTokenAlloc * sizeof(jsmntok_t));
+	memFreeTagged(
+		MEMSTATS_TAG_JSON, pJson->pTokens, pJson->uwTokenAlloc * sizeof(jsmntok_t)
+	);
+	pJson->pTokens = pNewTokens;
+	pJson->uwTokenAlloc = uwNewAlloc;
+	return 1;
+}
+
+/**
+ * Builds first child/next sibling links from jsmn's parent links.
+ * Going backwards, each token is prepended to its parent's child list,
+ * so children end up in file order.
+ */
+static void jsonBuildNodes(tJson *pJson) {
+	pJson->pNodes = memAllocFastClearTagged(
+		MEMSTATS_TAG_JSON, pJson->fwTokenCount * sizeof(tJsonNode)
+	);
+	for(FWORD i = pJson->fwTokenCount - 1; i > 0; --i) {
+		int iParent = pJson->pTokens[i].parent;
+		if(iParent < 0) {
+			continue;
+		}
+		pJson->pNodes[i].uwNextSibling = pJson->pNodes[iParent].uwFirstChild;
+		pJson->pNodes[iParent].uwFirstChild = i;
+	}
+}
 
 tJson *jsonCreate(const char *szFilePath) {
 	logBlockBegin("jsonCreate(szFilePath: %s)", szFilePath);
-	tJson *pJson = memAllocFast(sizeof(tJson));
 
 	// Read whole file to string
 	tFile *pFile = fileOpen(szFilePath, "rb");
 	if(!pFile) {
 		logWrite("ERR: File doesn't exist: '%s'\n", szFilePath);
+		logBlockEnd("jsonCreate()");
+		return 0;
 	}
 	fileSeek(pFile, 0, FILE_SEEK_END);
 	ULONG ulFileSize = fileGetPos(pFile);
 	fileSeek(pFile, 0, FILE_SEEK_SET);
 
-	pJson->szData = memAllocFast(ulFileSize+1);
+	tJson *pJson = memAllocFastTagged(MEMSTATS_TAG_JSON, sizeof(tJson));
+	pJson->pNodes = 0;
+	pJson->szData = memAllocFastTagged(MEMSTATS_TAG_JSON, ulFileSize+1);
 	fileRead(pFile, pJson->szData, ulFileSize);
 	pJson->szData[ulFileSize] = '\0';
 	fileClose(pFile);
 
+	// Parse in one go - when parser runs out of tokens, it stops at last
+	// complete token, so it may be resumed after growing token array.
+	pJson->uwTokenAlloc = MIN(
+		JSON_TOKEN_ALLOC_MAX,
+		ulFileSize / JSON_BYTES_PER_TOKEN + JSON_TOKEN_ALLOC_MIN
+	);
+	pJson->pTokens = memAllocFastTagged(
+		MEMSTATS_TAG_JSON, pJson->uwTokenAlloc * sizeof(jsmntok_t)
+	);
 	jsmn_parser sJsonParser;
 	jsmn_init(&sJsonParser);
-
-	// Count tokens & alloc
-	pJson->fwTokenCount = jsmn_parse(&sJsonParser, pJson->szData, ulFileSize+1, 0, 0);
-	if(pJson->fwTokenCount < 0) {
-		logWrite(
-			"ERR: JSON during token counting: %"PRI_FWORD"\n", pJson->fwTokenCount
+	FWORD fwResult;
+	do {
+		fwResult = jsmn_parse(
+			&sJsonParser, pJson->szData, ulFileSize+1,
+			pJson->pTokens, pJson->uwTokenAlloc
 		);
-		logBlockEnd("jsonCreate()");
-		return 0;
-	}
-	pJson->pTokens = memAllocFast(pJson->fwTokenCount * sizeof(jsmntok_t));
+	} while(fwResult == JSMN_ERROR_NOMEM && jsonGrowTokens(pJson));
+	pJson->fwTokenCount = sJsonParser.toknext;
 
-	// Read tokens
-	jsmn_init(&sJsonParser);
-	FWORD fwResult = jsmn_parse(
-		&sJsonParser, pJson->szData, ulFileSize+1, pJson->pTokens, pJson->fwTokenCount
-	);
-	if(fwResult < 0) {
+	if(fwResult <= 0) {
+		// Empty JSON is also an error - there's no root token to search in
 		logWrite("ERR: JSON during tokenize: %"PRI_FWORD"\n", fwResult);
+		jsonDestroy(pJson);
 		logBlockEnd("jsonCreate()");
 		return 0;
 	}
+	logWrite(
+		"Tokens: %"PRI_FWORD", allocated: %hu\n",
+		pJson->fwTokenCount, pJson->uwTokenAlloc
+	);
+	jsonBuildNodes(pJson);
 
 	logBlockEnd("jsonCreate()");
 	return pJson;
 }
 
 void jsonDestroy(tJson *pJson) {
-	memFree(pJson->pTokens, sizeof(jsmntok_t) * pJson->fwTokenCount);
-	memFree(pJson->szData, strlen(pJson->szData) + 1);
-	memFree(pJson, sizeof(tJson));
+	if(pJson->pNodes) {
+		memFreeTagged(
+			MEMSTATS_TAG_JSON, pJson->pNodes, sizeof(tJsonNode) * pJson->fwTokenCount
+		);
+	}
+	memFreeTagged(
+		MEMSTATS_TAG_JSON, pJson->pTokens, sizeof(jsmntok_t) * pJson->uwTokenAlloc
+	);
+	memFreeTagged(MEMSTATS_TAG_JSON, pJson->szData, strlen(pJson->szData) + 1);
+	memFreeTagged(MEMSTATS_TAG_JSON, pJson, sizeof(tJson));
 }
 
 UWORD jsonGetElementInArray(
 	const tJson *pJson, UWORD uwParentIdx, UWORD uwIdx
 ) {
-	UWORD uwCurrIdx = 0;
 	if(pJson->pTokens[uwParentIdx].type != JSMN_ARRAY) {
 		return 0;
 	}
-	for(UWORD i = uwParentIdx+1; i < pJson->fwTokenCount; ++i) {
-		if(pJson->pTokens[i].start > pJson->pTokens[uwParentIdx].end) {
-			// We're outside of parent - nothing found
-			return 0;
-		}
-		if(uwCurrIdx == uwIdx) {
-			return i;
-		}
-		else {
-			// Something else - skip it
-			UWORD uwSkipPos = pJson->pTokens[i].end;
-			while(pJson->pTokens[i+1].start < uwSkipPos) {
-				++i;
-			}
-		}
-		++uwCurrIdx;
+	UWORD uwTok = jsonGetFirstChild(pJson, uwParentIdx);
+	while(uwTok && uwIdx--) {
+		uwTok = jsonGetNextSibling(pJson, uwTok);
 	}
-	// Unxepected end of JSON
-	return 0;
+	return uwTok;
 }
 
 UWORD jsonGetElementInStruct(
 	const tJson *pJson, UWORD uwParentIdx, const char *szElement
 ) {
-	for(UWORD i = uwParentIdx+1; i < pJson->fwTokenCount; ++i) {
-		if(pJson->pTokens[i].start > pJson->pTokens[uwParentIdx].end) {
-			// We're outside of parent - nothing found
-			return 0;
-		}
-		const char *pNextElementName = pJson->szData + pJson->pTokens[i].start;
+	if(pJson->pTokens[uwParentIdx].type != JSMN_OBJECT) {
+		return 0;
+	}
+	UWORD uwElementLength = strlen(szElement);
+	for(
+		UWORD uwKey = jsonGetFirstChild(pJson, uwParentIdx); uwKey;
+		uwKey = jsonGetNextSibling(pJson, uwKey)
+	) {
+		const jsmntok_t *pKey = &pJson->pTokens[uwKey];
 		if(
-			!memcmp(pNextElementName, szElement, strlen(szElement)) &&
-			pNextElementName[strlen(szElement)] == '"'
+			pKey->end - pKey->start == uwElementLength &&
+			!memcmp(pJson->szData + pKey->start, szElement, uwElementLength)
 		) {
-			// Found label - next is content
-			return i+1;
-		}
-		else {
-			// Something else - skip it
-			UWORD uwSkipPos = pJson->pTokens[++i].end;
-			while(pJson->pTokens[i+1].start < uwSkipPos) {
-				++i;
-			}
+			// Found label - its only child is content
+			return jsonGetFirstChild(pJson, uwKey);
 		}
 	}
-	// Unxepected end of JSON
 	return 0;
 }
 
@@ -118,9 +162,13 @@ UWORD jsonGetDom(const tJson *pJson, const char *szPattern) {
 	UWORD uwParentTok = 0;
 	const char *c = szPattern;
 	do {
+		if(*c == '.') {
+			++c;
+		}
 		if(*c == '[') {
 			// Array element - read number
 			UWORD uwIdx = 0;
+			++c;
 			while(*c != ']') {
 				if(*c < '0' || *c > '9') {
 					return 0;
@@ -128,6 +176,7 @@ UWORD jsonGetDom(const tJson *pJson, const char *szPattern) {
 				uwIdx = uwIdx*10 + (*c - '0');
 				++c;
 			}
+			++c;
 			uwParentTok = jsonGetElementInArray(pJson, uwParentTok, uwIdx);
 		}
 		else {
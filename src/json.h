@@ -1,24 +1,62 @@
 #ifndef GUARD_OF_JSON_H
 #define GUARD_OF_JSON_H
 
-#define JSMN_STRICT       /* Strict JSON parsing */
-// JSMN_PARENT_LINKS breaks things up!
-// #define JSMN_PARENT_LINKS /* Speeds things up */
+// JSMN_STRICT & JSMN_PARENT_LINKS are passed from makefile - defining them
+// here only would make jsmn.c use different token layout than its callers.
 #include "jsmn.h"
 #include <ace/types.h>
 
+/**
+ * Tree links of single token. 0 means no token, since root token
+ * can't be anyone's child nor sibling.
+ */
+typedef struct _tJsonNode {
+	UWORD uwFirstChild;  ///< For objects: 1st key, for keys: value.
+	UWORD uwNextSibling; ///< Next token with same parent.
+} tJsonNode;
+
 typedef struct _tJson {
 	char *szData;
 	jsmntok_t *pTokens;
+	tJsonNode *pNodes; ///< Same count & order as pTokens.
 	FWORD fwTokenCount;
+	UWORD uwTokenAlloc; ///< Allocated token count, >= fwTokenCount.
 } tJson;
 
+/**
+ * Reads & tokenizes JSON file in single pass.
+ * Token array starts with size estimated from file length and is grown
+ * whenever parser runs out of it.
+ * @param szFilePath Path to JSON file.
+ * @return Tokenized JSON or 0 on failure.
+ */
 tJson *jsonCreate(const char *szFilePath);
 
 void jsonDestroy(tJson *pJson);
 
 UWORD jsonGetElementInArray(const tJson *pJson,UWORD uwParentIdx,UWORD uwIdx);
 
+/**
+ * Returns first element of array or object, or value of given key.
+ * @param pJson JSON to be searched.
+ * @param uwTok Parent token idx.
+ * @return Child token idx or 0 if there are no children.
+ */
+static inline UWORD jsonGetFirstChild(const tJson *pJson, UWORD uwTok) {
+	return pJson->pNodes[uwTok].uwFirstChild;
+}
+
+/**
+ * Returns next element of same array or next key of same object.
+ * Use it with jsonGetFirstChild() to iterate over elements in linear time.
+ * @param pJson JSON to be searched.
+ * @param uwTok Current element's token idx.
+ * @return Next element's token idx or 0 if it was last one.
+ */
+static inline UWORD jsonGetNextSibling(const tJson *pJson, UWORD uwTok) {
+	return pJson->pNodes[uwTok].uwNextSibling;
+}
+
 UWORD jsonGetElementInStruct(
 	const tJson *pJson,UWORD uwParentIdx,const char *szElement
 );
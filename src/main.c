@@ -2,8 +2,10 @@
 #include <ace/generic/main.h>
 #include <ace/managers/game.h>
 
+#include "cache.h"
 #include "config.h"
 #include "input.h"
+#include "map.h"
 #include "gamestates/precalc/precalc.h"
 
 void genericCreate(void) {
@@ -17,5 +19,9 @@ void genericProcess(void) {
 }
 
 void genericDestroy(void) {
+	mapDestroy();
+	// Maps may be recompiled after precalc if their source has changed
+	cacheManifestFlush();
+	cacheManifestDestroy();
 	inputClose();
 }
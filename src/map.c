@@ -1,29 +1,174 @@
 #include "map.h"
+#include <string.h>
 #include <ace/managers/log.h>
-#include <ace/managers/memory.h>
+#include <ace/utils/file.h>
 #include "mapjson.h"
+#include "mapofm.h"
+#include "arena.h"
+#include "cache.h"
+#include "memstats.h"
 
-tMap g_sMap = {.fubWidth = 0, .fubHeight = 0, .pData = {{{0}}}};
+#define MAP_PLANE_COUNT 5
 
-void mapInit(char *szFileName) {
-	logBlockBegin("mapInit(szPath: %s)", szFileName);
-	sprintf(g_sMap.szPath, "data/maps/%s", szFileName);
+tMap g_sMap = {.uwWidth = 0, .uwHeight = 0};
+
+static tArena *s_pMapArena = 0; ///< Holds all planes of current map.
+
+static UBYTE mapCreatePlane(
+	tChunkedGrid *pPlane, UBYTE ubElementSize, const UBYTE *pChunkUsage
+) {
+	return chunkedGridCreate(
+		pPlane, s_pMapArena, MEMSTATS_TAG_MAP, g_sMap.uwWidth, g_sMap.uwHeight,
+		ubElementSize, pChunkUsage
+	);
+}
+
+UBYTE mapCreatePlanes(const UBYTE *pChunkUsage) {
+	UWORD uwChunkCount = (
+		gridChunkCount(g_sMap.uwWidth) * gridChunkCount(g_sMap.uwHeight)
+	);
+	g_sMap.uwUsedChunkCount = 0;
+	for(UWORD i = 0; i < uwChunkCount; ++i) {
+		if(pChunkUsage[i]) {
+			++g_sMap.uwUsedChunkCount;
+		}
+	}
+	// All planes are UBYTE. Each one has its chunk table and shared chunk
+	// besides used ones.
+	ULONG ulChunkSize = GRID_CHUNK_SIZE * GRID_CHUNK_SIZE;
+	s_pMapArena = arenaCreate(
+		(g_sMap.uwUsedChunkCount + 1) * ulChunkSize * MAP_PLANE_COUNT +
+		uwChunkCount * sizeof(UBYTE*) * MAP_PLANE_COUNT
+	);
+	if(!s_pMapArena) {
+		return 0;
+	}
+	if(
+		!mapCreatePlane(&g_sMap.sLogic, sizeof(UBYTE), pChunkUsage) ||
+		!mapCreatePlane(&g_sMap.sBuilding, sizeof(UBYTE), pChunkUsage) ||
+		!mapCreatePlane(&g_sMap.sGfx, sizeof(UBYTE), pChunkUsage) ||
+		!mapCreatePlane(&g_sMap.sAiCost, sizeof(UBYTE), pChunkUsage) ||
+		!mapCreatePlane(&g_sMap.sControl, sizeof(UBYTE), pChunkUsage)
+	) {
+		return 0;
+	}
+	// Shared chunk must describe water tiles
+	chunkedGridFill(&g_sMap.sLogic, MAP_LOGIC_WATER);
+	chunkedGridFill(&g_sMap.sControl, MAP_CONTROL_NONE);
+	logWrite(
+		"Used chunks: %hu/%hu\n", g_sMap.uwUsedChunkCount, uwChunkCount
+	);
+	return 1;
+}
+
+static UBYTE mapLoadCompiled(const char *szCompiledPath) {
+	char szFullPath[100];
+	sprintf(szFullPath, "precalc/%s", szCompiledPath);
+	tFile *pFile = fileOpen(szFullPath, "rb");
+	if(!pFile) {
+		return 0;
+	}
+	if(!mapOfmReadMeta(pFile, &g_sMap)) {
+		fileClose(pFile);
+		return 0;
+	}
+	mapDestroy();
+	// Building plane is cleared on alloc, which is BUILDING_IDX_INVALID
+	if(!mapOfmReadPlanes(pFile, &g_sMap)) {
+		fileClose(pFile);
+		return 0;
+	}
+	fileClose(pFile);
+	return 1;
+}
+
+static UBYTE mapLoadJson(void) {
 	tJson *pMapJson = jsonCreate(g_sMap.szPath);
+	if(!pMapJson) {
+		return 0;
+	}
 
 	// Objects may have properties passed in random order
 	// so 1st pass will extract only general data
-	mapJsonGetMeta(pMapJson, &g_sMap);
-	logWrite(
-		"Dimensions: %" PRI_FUBYTE "x%" PRI_FUBYTE "\n",
-		g_sMap.fubWidth, g_sMap.fubHeight
+	if(!mapJsonGetMeta(pMapJson, &g_sMap)) {
+		jsonDestroy(pMapJson);
+		return 0;
+	}
+	mapDestroy();
+	ULONG ulUsageSize = (
+		gridChunkCount(g_sMap.uwWidth) * gridChunkCount(g_sMap.uwHeight)
 	);
+	UBYTE *pChunkUsage = memAllocFastTagged(MEMSTATS_TAG_MAP, ulUsageSize);
+	if(!pChunkUsage) {
+		jsonDestroy(pMapJson);
+		return 0;
+	}
+	mapJsonGetChunkUsage(pMapJson, &g_sMap, pChunkUsage);
+	UBYTE isCreated = mapCreatePlanes(pChunkUsage);
+	memFreeTagged(MEMSTATS_TAG_MAP, pChunkUsage, ulUsageSize);
+	if(!isCreated) {
+		jsonDestroy(pMapJson);
+		return 0;
+	}
 
-	mapJsonReadTiles(pMapJson, &g_sMap);
+	// Map with garbage planes mustn't get compiled & cached
+	if(!mapJsonReadTiles(pMapJson, &g_sMap)) {
+		jsonDestroy(pMapJson);
+		return 0;
+	}
+	mapJsonReadControlPoints(pMapJson, &g_sMap);
 
 	jsonDestroy(pMapJson);
+	return 1;
+}
+
+void mapInit(const char *szFileName) {
+	logBlockBegin("mapInit(szPath: %s)", szFileName);
+	sprintf(g_sMap.szPath, "data/maps/%s", szFileName);
+
+	// Compiled map is stored as precalc/maps/name.ofm for data/maps/name.json
+	char szSourcePath[100], szCompiledPath[100];
+	sprintf(szSourcePath, "maps/%s", szFileName);
+	strcpy(szCompiledPath, szSourcePath);
+	char *pExt = strrchr(szCompiledPath, '.');
+	if(pExt) {
+		*pExt = '\0';
+	}
+	strcat(szCompiledPath, ".ofm");
+
+	if(
+		cacheIsValidCompiled(szSourcePath, szCompiledPath, MAP_OFM_VERSION) &&
+		mapLoadCompiled(szCompiledPath)
+	) {
+		logWrite("Loaded compiled map\n");
+	}
+	else if(mapLoadJson()) {
+		char szFullPath[100];
+		sprintf(szFullPath, "precalc/%s", szCompiledPath);
+		if(mapOfmSave(&g_sMap, szFullPath)) {
+			cacheGenerateChecksumCompiled(
+				szSourcePath, szCompiledPath, MAP_OFM_VERSION
+			);
+		}
+	}
+	else {
+		logWrite("ERR: Couldn't load map\n");
+		mapDestroy();
+		g_sMap.uwWidth = 0;
+		g_sMap.uwHeight = 0;
+		g_sMap.fubControlPointCount = 0;
+	}
+	logWrite("Dimensions: %hux%hu\n", g_sMap.uwWidth, g_sMap.uwHeight);
 	logBlockEnd("mapInit()");
 }
 
-void mapSetLogic(UBYTE ubX, UBYTE ubY, UBYTE ubLogic) {
-	g_sMap.pData[ubX][ubY].ubIdx = ubLogic;
+void mapDestroy(void) {
+	if(s_pMapArena) {
+		arenaDestroy(s_pMapArena);
+		s_pMapArena = 0;
+	}
+}
+
+void mapSetLogic(tTilePos uwX, tTilePos uwY, UBYTE ubLogic) {
+	mapLogicAt(uwX, uwY) = ubLogic;
 }
@@ -2,6 +2,7 @@
 #define GUARD_OF_MAP_H
 
 #include <ace/types.h>
+#include "grid.h"
 
 #define MAP_LOGIC_WATER   '.'
 #define MAP_LOGIC_DIRT    ' '
@@ -22,32 +23,83 @@
 #define MAP_LOGIC_CAPTURE1 'c'
 #define MAP_LOGIC_CAPTURE2 'C'
 
-#define MAP_MAX_SIZE 128
+#define MAP_MAX_SIZE 512
 #define MAP_NAME_MAX 30
 #define MAP_AUTHOR_MAX 30
 
 #define MAP_MODE_CONQUEST 1
 #define MAP_MODE_CTF 2
 
-typedef struct _tTile {
-	UBYTE ubIdx;  ///< Tileset idx
-	UBYTE ubBuilding; ///< For buildings/gates/spawns used as array idx.
-} tMapTile;
+#define MAP_CONTROL_NONE 0xFF
+#define MAP_CONTROL_NAME_MAX 20
+#define MAP_CONTROL_POINT_MAX 16
+
+/**
+ * Single tile coordinate. Must hold values up to MAP_MAX_SIZE, so use it
+ * instead of UBYTE for anything expressed in tiles.
+ */
+typedef UWORD tTilePos;
+
+typedef struct _tMapControlPoint {
+	char szName[MAP_CONTROL_NAME_MAX];
+	tTilePos uwCaptureX;
+	tTilePos uwCaptureY;
+} tMapControlPoint;
 
 typedef struct _tMap {
 	char szPath[200];
 	char szName[MAP_NAME_MAX];
 	char szAuthor[MAP_AUTHOR_MAX];
-	FUBYTE fubWidth;
-	FUBYTE fubHeight;
+	tTilePos uwWidth;
+	tTilePos uwHeight;
 	FUBYTE fubSpawnCount;
+	FUWORD fuwTurretCount;
 	UBYTE ubMode;
-	tMapTile pData[MAP_MAX_SIZE][MAP_MAX_SIZE];
+	FUBYTE fubControlPointCount;
+	tMapControlPoint pControlPoints[MAP_CONTROL_POINT_MAX];
+	UWORD uwUsedChunkCount; ///< Chunks with anything else than water.
+	// Planes - chunked, sized to uwWidth x uwHeight. Chunks containing only
+	// water share memory, so only values valid for any water tile may be
+	// written there.
+	tChunkedGrid sLogic;    ///< UBYTE, see MAP_LOGIC_* defines.
+	tChunkedGrid sBuilding; ///< UBYTE, for buildings/gates/spawns as array idx.
+	tChunkedGrid sGfx;      ///< UBYTE, tileset idx currently drawn on tile.
+	tChunkedGrid sAiCost;   ///< UBYTE, cost of crossing tile, used by AI.
+	tChunkedGrid sControl;  ///< UBYTE, control point idx or MAP_CONTROL_NONE.
 } tMap;
 
-void mapInit(char *szPath);
+#define mapLogicAt(uwX, uwY) chunkedGridAt(&g_sMap.sLogic, UBYTE, uwX, uwY)
+#define mapBuildingAt(uwX, uwY) \
+	chunkedGridAt(&g_sMap.sBuilding, UBYTE, uwX, uwY)
+#define mapGfxAt(uwX, uwY) chunkedGridAt(&g_sMap.sGfx, UBYTE, uwX, uwY)
+#define mapAiCostAt(uwX, uwY) chunkedGridAt(&g_sMap.sAiCost, UBYTE, uwX, uwY)
+#define mapControlAt(uwX, uwY) \
+	chunkedGridAt(&g_sMap.sControl, UBYTE, uwX, uwY)
+
+/**
+ * Loads map metadata, logic tiles & control point zones, allocating planes
+ * for its real size. Previous map's planes are released.
+ * Compiled map from precalc/maps is used if it's up to date, otherwise JSON
+ * source is parsed and compiled map is written for next time.
+ * @param szPath Map file name, relative to data/maps.
+ */
+void mapInit(const char *szPath);
+
+/**
+ * Releases planes of currently loaded map.
+ */
+void mapDestroy(void);
+
+/**
+ * Allocates planes of current map's size, giving memory only to chunks
+ * marked as used. Previous planes must be already released.
+ * @param pChunkUsage Row-major, non-zero byte for each chunk which
+ * has anything else than water.
+ * @return 1 on success, otherwise 0.
+ */
+UBYTE mapCreatePlanes(const UBYTE *pChunkUsage);
 
-void mapSetLogic(UBYTE ubX, UBYTE ubY, UBYTE ubLogic);
+void mapSetLogic(tTilePos uwX, tTilePos uwY, UBYTE ubLogic);
 
 extern tMap g_sMap;
 
@@ -3,8 +3,8 @@
 #include <ace/macros.h>
 #include <ace/managers/log.h>
 #include "map.h"
-#include "gamestates/game/control.h"
 #include "gamestates/game/building.h"
+#include "memstats.h"
 
 UBYTE mapJsonGetMeta(const tJson *pJson, tMap *pMap) {
 	logBlockBegin(
@@ -26,8 +26,20 @@ UBYTE mapJsonGetMeta(const tJson *pJson, tMap *pMap) {
 		return 0;
 	}
 
-	pMap->fubWidth = jsonTokToUlong(pJson, uwTokWidth, 10);
-	pMap->fubHeight = jsonTokToUlong(pJson, uwTokHeight, 10);
+	ULONG ulWidth = jsonTokToUlong(pJson, uwTokWidth, 10);
+	ULONG ulHeight = jsonTokToUlong(pJson, uwTokHeight, 10);
+	if(
+		!ulWidth || ulWidth > MAP_MAX_SIZE || !ulHeight || ulHeight > MAP_MAX_SIZE
+	) {
+		logWrite(
+			"ERR: Invalid map size: %lux%lu, max %d\n",
+			ulWidth, ulHeight, MAP_MAX_SIZE
+		);
+		logBlockEnd("mapJsonGetMeta()");
+		return 0;
+	}
+	pMap->uwWidth = ulWidth;
+	pMap->uwHeight = ulHeight;
 	jsonTokStrCpy(pJson, uwTokAuthor, pMap->szAuthor, MAP_AUTHOR_MAX);
 	jsonTokStrCpy(pJson, uwTokName, pMap->szName, MAP_NAME_MAX);
 	jsonTokStrCpy(pJson, uwTokMode, szModeStr, 20);
@@ -47,53 +59,238 @@ UBYTE mapJsonGetMeta(const tJson *pJson, tMap *pMap) {
 	return 1;
 }
 
-void mapJsonReadTiles(const tJson *pJson, tMap *pMap) {
+void mapJsonGetChunkUsage(
+	const tJson *pJson, const tMap *pMap, UBYTE *pChunkUsage
+) {
+	UWORD uwChunksX = gridChunkCount(pMap->uwWidth);
+	UWORD uwChunksY = gridChunkCount(pMap->uwHeight);
+	memset(pChunkUsage, 0, uwChunksX * uwChunksY);
+
+	// Chunks with anything else than water
+	UWORD uwTokTiles = jsonGetDom(pJson, "tiles");
+	if(uwTokTiles && pJson->pTokens[uwTokTiles].type == JSMN_ARRAY) {
+		tTilePos uwY = 0;
+		for(
+			UWORD uwTokRow = jsonGetFirstChild(pJson, uwTokTiles);
+			uwTokRow && uwY < pMap->uwHeight;
+			uwTokRow = jsonGetNextSibling(pJson, uwTokRow), ++uwY
+		) {
+			const jsmntok_t *pTokRow = &pJson->pTokens[uwTokRow];
+			UWORD uwRowWidth = MIN(pTokRow->end - pTokRow->start, pMap->uwWidth);
+			const char *pRow = &pJson->szData[pTokRow->start];
+			UBYTE *pUsageRow = &pChunkUsage[(uwY >> GRID_CHUNK_BITS) * uwChunksX];
+			for(tTilePos uwX = 0; uwX < uwRowWidth; ++uwX) {
+				if(pRow[uwX] != MAP_LOGIC_WATER) {
+					pUsageRow[uwX >> GRID_CHUNK_BITS] = 1;
+				}
+			}
+		}
+	}
+
+	// Control zones may span over water, so mark their bounding boxes too
+	UWORD uwTokPts = jsonGetDom(pJson, "controlPoints");
+	if(!uwTokPts || pJson->pTokens[uwTokPts].type != JSMN_ARRAY) {
+		return;
+	}
+	for(
+		UWORD uwTokPoint = jsonGetFirstChild(pJson, uwTokPts); uwTokPoint;
+		uwTokPoint = jsonGetNextSibling(pJson, uwTokPoint)
+	) {
+		UWORD uwTokPoly = jsonGetElementInStruct(pJson, uwTokPoint, "polygon");
+		if(!uwTokPoly || pJson->pTokens[uwTokPoly].type != JSMN_ARRAY) {
+			continue;
+		}
+		tTilePos uwX1 = 0xFFFF, uwY1 = 0xFFFF, uwX2 = 0, uwY2 = 0;
+		for(
+			UWORD uwTokPolyPt = jsonGetFirstChild(pJson, uwTokPoly); uwTokPolyPt;
+			uwTokPolyPt = jsonGetNextSibling(pJson, uwTokPolyPt)
+		) {
+			if(pJson->pTokens[uwTokPolyPt].size != 2) {
+				continue;
+			}
+			tTilePos uwX = jsonTokToUlong(pJson, uwTokPolyPt+1, 10);
+			tTilePos uwY = jsonTokToUlong(pJson, uwTokPolyPt+2, 10);
+			uwX1 = MIN(uwX1, uwX);
+			uwY1 = MIN(uwY1, uwY);
+			uwX2 = MAX(uwX2, uwX);
+			uwY2 = MAX(uwY2, uwY);
+		}
+		uwX2 = MIN(uwX2, pMap->uwWidth - 1);
+		uwY2 = MIN(uwY2, pMap->uwHeight - 1);
+		UWORD uwChunkX1 = uwX1 >> GRID_CHUNK_BITS;
+		UWORD uwChunkX2 = uwX2 >> GRID_CHUNK_BITS;
+		UWORD uwChunkY2 = uwY2 >> GRID_CHUNK_BITS;
+		for(UWORD uwCy = uwY1 >> GRID_CHUNK_BITS; uwCy <= uwChunkY2; ++uwCy) {
+			for(UWORD uwCx = uwChunkX1; uwCx <= uwChunkX2; ++uwCx) {
+				pChunkUsage[uwCy * uwChunksX + uwCx] = 1;
+			}
+		}
+	}
+}
+
+UBYTE mapJsonReadTiles(const tJson *pJson, tMap *pMap) {
 	UWORD uwTokTiles = jsonGetDom(pJson, "tiles");
 	if(!uwTokTiles) {
 		logWrite("ERR: JSON 'tiles' array not found!\n");
+		return 0;
 	}
 
 	// Tiles found - check row count
-	if(pJson->pTokens[uwTokTiles].size != pMap->fubHeight) {
+	if(pJson->pTokens[uwTokTiles].size != pMap->uwHeight) {
 		logWrite(
-			"ERR: tile rows provided: %d, expected %"PRI_FUBYTE"\n",
-			pJson->pTokens[uwTokTiles].size, pMap->fubHeight
+			"ERR: tile rows provided: %d, expected %hu\n",
+			pJson->pTokens[uwTokTiles].size, pMap->uwHeight
 		);
-		return;
+		return 0;
 	}
 
 	// Do some reading
 	pMap->fubSpawnCount = 0;
+	pMap->fuwTurretCount = 0;
 	UWORD uwTokRow = jsonGetElementInArray(pJson, uwTokTiles, 0);
-	for(FUBYTE y = 0; y < pMap->fubHeight; ++y) {
+	for(tTilePos y = 0; y < pMap->uwHeight; ++y) {
 		jsmntok_t *pTokRow = &pJson->pTokens[uwTokRow+y];
 		FUWORD fuwWidth = pTokRow->end - pTokRow->start;
-		if(pTokRow->type != JSMN_STRING || fuwWidth != pMap->fubWidth) {
+		if(pTokRow->type != JSMN_STRING || fuwWidth != pMap->uwWidth) {
 			logWrite(
-				"ERR: Malformed row @y %"PRI_FUBYTE": %d(%"PRI_FUBYTE")\n",
+				"ERR: Malformed row @y %hu: %d(%"PRI_FUWORD")\n",
 				y, pTokRow->type, fuwWidth
 			);
-			return;
+			return 0;
 		}
 
 		// Read row to logic tiles
-		for(FUBYTE x = 0; x < fuwWidth; ++x) {
-			pMap->pData[x][y].ubIdx = (UBYTE)pJson->szData[pTokRow->start + x];
-			pMap->pData[x][y].ubBuilding = BUILDING_IDX_INVALID;
+		for(tTilePos x = 0; x < fuwWidth; ++x) {
+			UBYTE *pLogic = &chunkedGridAt(&pMap->sLogic, UBYTE, x, y);
+			*pLogic = (UBYTE)pJson->szData[pTokRow->start + x];
+			chunkedGridAt(&pMap->sBuilding, UBYTE, x, y) = BUILDING_IDX_INVALID;
 			if(
-				pMap->pData[x][y].ubIdx == MAP_LOGIC_SPAWN0 ||
-				pMap->pData[x][y].ubIdx == MAP_LOGIC_SPAWN1 ||
-				pMap->pData[x][y].ubIdx == MAP_LOGIC_SPAWN2
+				*pLogic == MAP_LOGIC_SPAWN0 ||
+				*pLogic == MAP_LOGIC_SPAWN1 ||
+				*pLogic == MAP_LOGIC_SPAWN2
 			)
 				++pMap->fubSpawnCount;
-			else if(pMap->pData[x][y].ubIdx == MAP_LOGIC_WALL_VERTICAL)
-				pMap->pData[x][y].ubIdx = MAP_LOGIC_WALL;
+			else if(
+				*pLogic == MAP_LOGIC_SENTRY0 ||
+				*pLogic == MAP_LOGIC_SENTRY1 ||
+				*pLogic == MAP_LOGIC_SENTRY2
+			)
+				++pMap->fuwTurretCount;
+			else if(*pLogic == MAP_LOGIC_WALL_VERTICAL)
+				*pLogic = MAP_LOGIC_WALL;
 		}
 	}
+	return 1;
+}
+
+static inline void mapJsonSetZoneTile(
+	tMap *pMap, UBYTE ubIdx, WORD wX, WORD wY
+) {
+	// Chunks outside zones' bounding boxes are shared between water tiles
+	if(
+		wX >= 0 && wY >= 0 && wX < pMap->uwWidth && wY < pMap->uwHeight &&
+		chunkedGridIsChunkUsed(
+			&pMap->sControl, gridChunkIdx(&pMap->sControl, wX, wY)
+		)
+	) {
+		chunkedGridAt(&pMap->sControl, UBYTE, wX, wY) = ubIdx;
+	}
 }
 
-void mapJsonReadControlPoints(const tJson *pJson) {
-	logBlockBegin("mapJsonReadControlPoints(pJson: %p)", pJson);
+/**
+ * Division rounding to nearest, for positive divisors.
+ */
+static inline WORD mapJsonRoundDiv(LONG lNum, LONG lDen) {
+	return lNum >= 0 ? (lNum + lDen/2) / lDen : -((-lNum + lDen/2) / lDen);
+}
+
+/**
+ * Marks tiles covered by control point's polygon on map's control plane.
+ * Polygon vertices are tile centers, edges may go in any direction.
+ * Interior is filled scanline by scanline using even-odd rule, then edges
+ * are plotted so that tiles on polygon's border are included too.
+ * @param pMap Map with control plane allocated.
+ * @param ubIdx Control point idx to be written.
+ * @param fubPolyPtCnt Number of polygon points, including closing one.
+ * @param pPolyPts Polygon points, last one being same as first.
+ */
+static void mapJsonFillControlZone(
+	tMap *pMap, UBYTE ubIdx, FUBYTE fubPolyPtCnt, const tUwCoordYX *pPolyPts
+) {
+	tTilePos uwY1 = 0xFFFF, uwY2 = 0;
+	for(FUBYTE i = 0; i < fubPolyPtCnt; ++i) {
+		uwY1 = MIN(uwY1, pPolyPts[i].sUwCoord.uwY);
+		uwY2 = MAX(uwY2, pPolyPts[i].sUwCoord.uwY);
+	}
+
+	// Each edge crosses scanline at most once
+	ULONG ulCrossingsSize = fubPolyPtCnt * sizeof(LONG);
+	LONG *pCrossings = memAllocFastTagged(MEMSTATS_TAG_MAP, ulCrossingsSize);
+	for(LONG y = uwY1; y <= uwY2; ++y) {
+		// Find crossings as 24.8 fixed point, half-open on edge's Y range
+		// so that shared vertices aren't counted twice
+		FUBYTE fubCrossingCount = 0;
+		for(FUBYTE i = 1; i < fubPolyPtCnt; ++i) {
+			LONG lX1 = pPolyPts[i-1].sUwCoord.uwX;
+			LONG lY1 = pPolyPts[i-1].sUwCoord.uwY;
+			LONG lX2 = pPolyPts[i].sUwCoord.uwX;
+			LONG lY2 = pPolyPts[i].sUwCoord.uwY;
+			if((lY1 <= y && y < lY2) || (lY2 <= y && y < lY1)) {
+				pCrossings[fubCrossingCount++] = (lX1 << 8) +
+					(y - lY1) * (lX2 - lX1) * 256 / (lY2 - lY1);
+			}
+		}
+
+		// Sort crossings - there are only few of them
+		for(FUBYTE i = 1; i < fubCrossingCount; ++i) {
+			LONG lCrossing = pCrossings[i];
+			FUBYTE j = i;
+			for(; j && pCrossings[j-1] > lCrossing; --j) {
+				pCrossings[j] = pCrossings[j-1];
+			}
+			pCrossings[j] = lCrossing;
+		}
+
+		// Fill tiles with centers between pairs of crossings
+		for(FUBYTE i = 0; i + 1 < fubCrossingCount; i += 2) {
+			WORD wStart = (pCrossings[i] + 255) >> 8;
+			WORD wEnd = pCrossings[i+1] >> 8;
+			for(WORD x = wStart; x <= wEnd; ++x) {
+				mapJsonSetZoneTile(pMap, ubIdx, x, y);
+			}
+		}
+	}
+	memFreeTagged(MEMSTATS_TAG_MAP, pCrossings, ulCrossingsSize);
+
+	// Plot edges, stepping along their longer axis
+	for(FUBYTE i = 1; i < fubPolyPtCnt; ++i) {
+		WORD wX1 = pPolyPts[i-1].sUwCoord.uwX;
+		WORD wY1 = pPolyPts[i-1].sUwCoord.uwY;
+		WORD wDx = pPolyPts[i].sUwCoord.uwX - wX1;
+		WORD wDy = pPolyPts[i].sUwCoord.uwY - wY1;
+		WORD wSteps = MAX(ABS(wDx), ABS(wDy));
+		if(!wSteps) {
+			mapJsonSetZoneTile(pMap, ubIdx, wX1, wY1);
+			continue;
+		}
+		for(WORD wStep = 0; wStep <= wSteps; ++wStep) {
+			mapJsonSetZoneTile(
+				pMap, ubIdx,
+				wX1 + mapJsonRoundDiv((LONG)wDx * wStep, wSteps),
+				wY1 + mapJsonRoundDiv((LONG)wDy * wStep, wSteps)
+			);
+		}
+	}
+	logWrite(
+		"Zone %hhu rows: %hu..%hu\n", ubIdx, uwY1, uwY2
+	);
+}
+
+void mapJsonReadControlPoints(const tJson *pJson, tMap *pMap) {
+	logBlockBegin(
+		"mapJsonReadControlPoints(pJson: %p, pMap: %p)", pJson, pMap
+	);
+	pMap->fubControlPointCount = 0;
 	UWORD uwTokPts = jsonGetDom(pJson, "controlPoints");
 	if(!uwTokPts || pJson->pTokens[uwTokPts].type != JSMN_ARRAY) {
 		logWrite("ERR: JSON controlPoints array not found!\n");
@@ -102,9 +299,20 @@ void mapJsonReadControlPoints(const tJson *pJson) {
 	}
 
 	UBYTE ubControlPointCount = pJson->pTokens[uwTokPts].size;
+	if(ubControlPointCount > MAP_CONTROL_POINT_MAX) {
+		logWrite(
+			"ERR: Too many control points: %hhu, max %d\n",
+			ubControlPointCount, MAP_CONTROL_POINT_MAX
+		);
+		logBlockEnd("mapJsonReadControlPoints()");
+		return;
+	}
 	logWrite("Adding %hu control points\n", ubControlPointCount);
-	for(UBYTE ubCtrlPt = 0; ubCtrlPt < ubControlPointCount; ++ubCtrlPt) {
-		UWORD uwTokPoint = jsonGetElementInArray(pJson, uwTokPts, ubCtrlPt);
+	UWORD uwTokPoint = jsonGetFirstChild(pJson, uwTokPts);
+	for(
+		UBYTE ubCtrlPt = 0; ubCtrlPt < ubControlPointCount;
+		++ubCtrlPt, uwTokPoint = jsonGetNextSibling(pJson, uwTokPoint)
+	) {
 		if(!uwTokPoint || pJson->pTokens[uwTokPoint].type != JSMN_OBJECT) {
 			logWrite(
 				"ERR: Malformed control point: %hhu (%hu => %d)\n",
@@ -124,8 +332,8 @@ void mapJsonReadControlPoints(const tJson *pJson) {
 		}
 
 		// Name
-		char szControlName[CONTROL_NAME_MAX];
-		jsonTokStrCpy(pJson, uwTokPtName, szControlName, CONTROL_NAME_MAX);
+		char szControlName[MAP_CONTROL_NAME_MAX];
+		jsonTokStrCpy(pJson, uwTokPtName, szControlName, MAP_CONTROL_NAME_MAX);
 
 		// Control point
 		if(
@@ -140,8 +348,8 @@ void mapJsonReadControlPoints(const tJson *pJson) {
 			logBlockEnd("mapJsonReadControlPoints()");
 			return;
 		}
-		FUBYTE fubCaptureX = jsonTokToUlong(pJson, uwTokPtCapture+1, 10);
-		FUBYTE fubCaptureY = jsonTokToUlong(pJson, uwTokPtCapture+2, 10);
+		tTilePos uwCaptureX = jsonTokToUlong(pJson, uwTokPtCapture+1, 10);
+		tTilePos uwCaptureY = jsonTokToUlong(pJson, uwTokPtCapture+2, 10);
 
 		// Polygon
 		FUBYTE fubPolyPointCnt = pJson->pTokens[uwTokPtPoly].size;
@@ -151,9 +359,14 @@ void mapJsonReadControlPoints(const tJson *pJson) {
 			return;
 		}
 		++fubPolyPointCnt; // One more for closing
-		tUbCoordYX *pPolyPoints = memAllocFast(fubPolyPointCnt * sizeof(tUbCoordYX));
-		for(UBYTE pp = 0; pp < fubPolyPointCnt - 1; ++pp) {
-			UWORD uwTokPolyPoint = jsonGetElementInArray(pJson, uwTokPtPoly, pp);
+		tUwCoordYX *pPolyPoints = memAllocFastTagged(
+			MEMSTATS_TAG_MAP, fubPolyPointCnt * sizeof(tUwCoordYX)
+		);
+		UWORD uwTokPolyPoint = jsonGetFirstChild(pJson, uwTokPtPoly);
+		for(
+			UBYTE pp = 0; pp < fubPolyPointCnt - 1;
+			++pp, uwTokPolyPoint = jsonGetNextSibling(pJson, uwTokPolyPoint)
+		) {
 			if(
 				!uwTokPolyPoint ||
 				pJson->pTokens[uwTokPolyPoint].type != JSMN_ARRAY ||
@@ -165,31 +378,43 @@ void mapJsonReadControlPoints(const tJson *pJson) {
 					pJson->pTokens[uwTokPolyPoint].end - pJson->pTokens[uwTokPolyPoint].start,
 					pJson->szData + pJson->pTokens[uwTokPolyPoint].start
 				);
-				memFree(pPolyPoints, fubPolyPointCnt * sizeof(tUbCoordYX));
+				memFreeTagged(
+					MEMSTATS_TAG_MAP, pPolyPoints, fubPolyPointCnt * sizeof(tUwCoordYX)
+				);
 				logBlockEnd("mapJsonReadControlPoints()");
 				return;
 			}
-			pPolyPoints[pp].sUbCoord.ubX = jsonTokToUlong(pJson, uwTokPolyPoint+1, 10);
-			pPolyPoints[pp].sUbCoord.ubY = jsonTokToUlong(pJson, uwTokPolyPoint+2, 10);
+			pPolyPoints[pp].sUwCoord.uwX = jsonTokToUlong(pJson, uwTokPolyPoint+1, 10);
+			pPolyPoints[pp].sUwCoord.uwY = jsonTokToUlong(pJson, uwTokPolyPoint+2, 10);
 		}
 
-		if(!fubCaptureX && !fubCaptureY) {
+		if(!uwCaptureX && !uwCaptureY) {
 			logWrite("ERR: No capture point supplied @point %"PRI_FUBYTE"!\n", ubCtrlPt);
-			memFree(pPolyPoints, fubPolyPointCnt * sizeof(tUbCoordYX));
+			memFreeTagged(
+				MEMSTATS_TAG_MAP, pPolyPoints, fubPolyPointCnt * sizeof(tUwCoordYX)
+			);
 			logBlockEnd("mapJsonReadControlPoints()");
 			return;
 		}
 		if(!strlen(szControlName)) {
 			logWrite("ERR: No control point name! @point %"PRI_FUBYTE"\n", ubCtrlPt);
-			memFree(pPolyPoints, fubPolyPointCnt * sizeof(tUbCoordYX));
+			memFreeTagged(
+				MEMSTATS_TAG_MAP, pPolyPoints, fubPolyPointCnt * sizeof(tUwCoordYX)
+			);
 			logBlockEnd("mapJsonReadControlPoints()");
 			return;
 		}
 		// Close polygon
-		pPolyPoints[fubPolyPointCnt-1].uwYX = pPolyPoints[0].uwYX;
-		controlAddPoint(
-			szControlName, fubCaptureX, fubCaptureY, fubPolyPointCnt, pPolyPoints
+		pPolyPoints[fubPolyPointCnt-1].ulYX = pPolyPoints[0].ulYX;
+		tMapControlPoint *pPoint = &pMap->pControlPoints[ubCtrlPt];
+		memcpy(pPoint->szName, szControlName, MAP_CONTROL_NAME_MAX);
+		pPoint->uwCaptureX = uwCaptureX;
+		pPoint->uwCaptureY = uwCaptureY;
+		mapJsonFillControlZone(pMap, ubCtrlPt, fubPolyPointCnt, pPolyPoints);
+		++pMap->fubControlPointCount;
+		memFreeTagged(
+			MEMSTATS_TAG_MAP, pPolyPoints, fubPolyPointCnt * sizeof(tUwCoordYX)
 		);
-		memFree(pPolyPoints, fubPolyPointCnt * sizeof(tUbCoordYX));
 	}
+	logBlockEnd("mapJsonReadControlPoints()");
 }
@@ -7,8 +7,25 @@
 
 UBYTE mapJsonGetMeta(const tJson *pJson, tMap *pMap);
 
-void mapJsonReadTiles(const tJson *pJson, tMap *pMap);
+/**
+ * Finds which plane chunks need memory of their own - ones with anything
+ * else than water or overlapping control zones' bounding boxes.
+ * @param pJson Map's JSON.
+ * @param pMap Map with size already read by mapJsonGetMeta().
+ * @param pChunkUsage Row-major array to be filled, one byte per chunk.
+ */
+void mapJsonGetChunkUsage(
+	const tJson *pJson, const tMap *pMap, UBYTE *pChunkUsage
+);
 
-void mapJsonReadControlPoints(const tJson *pJson);
+/**
+ * Reads logic tiles & counts spawns and turrets.
+ * @param pJson Map's JSON.
+ * @param pMap Map with planes already created.
+ * @return 1 on success, 0 if tiles are missing or malformed.
+ */
+UBYTE mapJsonReadTiles(const tJson *pJson, tMap *pMap);
+
+void mapJsonReadControlPoints(const tJson *pJson, tMap *pMap);
 
 #endif // GUARD_OF_MAPJSON_H
@@ -0,0 +1,164 @@
+#include "mapofm.h"
+#include <string.h>
+#include <ace/managers/log.h>
+#include "memstats.h"
+
+typedef struct _tMapOfmHeader {
+	char pMagic[4];
+	UWORD uwVersion;
+	UWORD uwTurretCount;
+	UWORD uwWidth;
+	UWORD uwHeight;
+	UBYTE ubMode;
+	UBYTE ubSpawnCount;
+	UBYTE ubControlPointCount;
+	UBYTE ubPad;
+	char szName[MAP_NAME_MAX];
+	char szAuthor[MAP_AUTHOR_MAX];
+} tMapOfmHeader;
+
+static const char s_pMagic[4] = {'O', 'F', 'M', 'P'};
+
+UBYTE mapOfmReadMeta(tFile *pFile, tMap *pMap) {
+	tMapOfmHeader sHeader;
+	ULONG ulRead = fileRead(pFile, &sHeader, sizeof(tMapOfmHeader));
+	if(ulRead != sizeof(tMapOfmHeader)) {
+		logWrite("ERR: Compiled map header truncated\n");
+		return 0;
+	}
+	if(memcmp(sHeader.pMagic, s_pMagic, sizeof(s_pMagic))) {
+		logWrite("ERR: Not a compiled map\n");
+		return 0;
+	}
+	if(sHeader.uwVersion != MAP_OFM_VERSION) {
+		logWrite(
+			"WARN: Compiled map version %hu, expected %d\n",
+			sHeader.uwVersion, MAP_OFM_VERSION
+		);
+		return 0;
+	}
+	if(
+		!sHeader.uwWidth || sHeader.uwWidth > MAP_MAX_SIZE ||
+		!sHeader.uwHeight || sHeader.uwHeight > MAP_MAX_SIZE
+	) {
+		logWrite(
+			"ERR: Invalid map size: %hux%hu\n", sHeader.uwWidth, sHeader.uwHeight
+		);
+		return 0;
+	}
+	if(sHeader.ubControlPointCount > MAP_CONTROL_POINT_MAX) {
+		logWrite(
+			"ERR: Too many control points: %hhu\n", sHeader.ubControlPointCount
+		);
+		return 0;
+	}
+
+	pMap->uwWidth = sHeader.uwWidth;
+	pMap->uwHeight = sHeader.uwHeight;
+	pMap->ubMode = sHeader.ubMode;
+	pMap->fubSpawnCount = sHeader.ubSpawnCount;
+	pMap->fuwTurretCount = sHeader.uwTurretCount;
+	pMap->fubControlPointCount = sHeader.ubControlPointCount;
+	memcpy(pMap->szName, sHeader.szName, MAP_NAME_MAX);
+	memcpy(pMap->szAuthor, sHeader.szAuthor, MAP_AUTHOR_MAX);
+
+	ULONG ulPointsSize = pMap->fubControlPointCount * sizeof(tMapControlPoint);
+	if(fileRead(pFile, pMap->pControlPoints, ulPointsSize) != ulPointsSize) {
+		logWrite("ERR: Compiled map control points truncated\n");
+		return 0;
+	}
+	return 1;
+}
+
+static UBYTE mapOfmReadChunks(tFile *pFile, tChunkedGrid *pPlane) {
+	UWORD uwChunkCount = pPlane->uwChunksX * pPlane->uwChunksY;
+	ULONG ulChunkSize = chunkedGridGetChunkSize(pPlane);
+	for(UWORD i = 0; i < uwChunkCount; ++i) {
+		if(
+			chunkedGridIsChunkUsed(pPlane, i) &&
+			fileRead(pFile, pPlane->pChunks[i], ulChunkSize) != ulChunkSize
+		) {
+			return 0;
+		}
+	}
+	return 1;
+}
+
+static void mapOfmWriteChunks(tFile *pFile, const tChunkedGrid *pPlane) {
+	UWORD uwChunkCount = pPlane->uwChunksX * pPlane->uwChunksY;
+	ULONG ulChunkSize = chunkedGridGetChunkSize(pPlane);
+	for(UWORD i = 0; i < uwChunkCount; ++i) {
+		if(chunkedGridIsChunkUsed(pPlane, i)) {
+			fileWrite(pFile, pPlane->pChunks[i], ulChunkSize);
+		}
+	}
+}
+
+UBYTE mapOfmReadPlanes(tFile *pFile, tMap *pMap) {
+	ULONG ulUsageSize = (
+		gridChunkCount(pMap->uwWidth) * gridChunkCount(pMap->uwHeight)
+	);
+	UBYTE *pChunkUsage = memAllocFastTagged(MEMSTATS_TAG_MAP, ulUsageSize);
+	if(!pChunkUsage) {
+		return 0;
+	}
+	UBYTE isRead = fileRead(pFile, pChunkUsage, ulUsageSize) == ulUsageSize;
+	UBYTE isCreated = isRead && mapCreatePlanes(pChunkUsage);
+	memFreeTagged(MEMSTATS_TAG_MAP, pChunkUsage, ulUsageSize);
+	if(!isCreated) {
+		logWrite("ERR: Couldn't create planes of compiled map\n");
+		return 0;
+	}
+
+	// Unused chunks are water and already filled by mapCreatePlanes()
+	if(
+		!mapOfmReadChunks(pFile, &pMap->sLogic) ||
+		!mapOfmReadChunks(pFile, &pMap->sControl)
+	) {
+		logWrite("ERR: Compiled map planes truncated\n");
+		return 0;
+	}
+	return 1;
+}
+
+UBYTE mapOfmSave(const tMap *pMap, const char *szPath) {
+	logBlockBegin("mapOfmSave(pMap: %p, szPath: '%s')", pMap, szPath);
+	tFile *pFile = fileOpen(szPath, "wb");
+	if(!pFile) {
+		logWrite("ERR: Couldn't open file for writing\n");
+		logBlockEnd("mapOfmSave()");
+		return 0;
+	}
+
+	tMapOfmHeader sHeader;
+	memset(&sHeader, 0, sizeof(tMapOfmHeader));
+	memcpy(sHeader.pMagic, s_pMagic, sizeof(s_pMagic));
+	sHeader.uwVersion = MAP_OFM_VERSION;
+	sHeader.uwTurretCount = pMap->fuwTurretCount;
+	sHeader.uwWidth = pMap->uwWidth;
+	sHeader.uwHeight = pMap->uwHeight;
+	sHeader.ubMode = pMap->ubMode;
+	sHeader.ubSpawnCount = pMap->fubSpawnCount;
+	sHeader.ubControlPointCount = pMap->fubControlPointCount;
+	memcpy(sHeader.szName, pMap->szName, MAP_NAME_MAX);
+	memcpy(sHeader.szAuthor, pMap->szAuthor, MAP_AUTHOR_MAX);
+	fileWrite(pFile, &sHeader, sizeof(tMapOfmHeader));
+
+	fileWrite(
+		pFile, pMap->pControlPoints,
+		pMap->fubControlPointCount * sizeof(tMapControlPoint)
+	);
+
+	const tChunkedGrid *pLogic = &pMap->sLogic;
+	UWORD uwChunkCount = pLogic->uwChunksX * pLogic->uwChunksY;
+	for(UWORD i = 0; i < uwChunkCount; ++i) {
+		UBYTE isUsed = chunkedGridIsChunkUsed(pLogic, i);
+		fileWrite(pFile, &isUsed, sizeof(isUsed));
+	}
+	mapOfmWriteChunks(pFile, &pMap->sLogic);
+	mapOfmWriteChunks(pFile, &pMap->sControl);
+	fileClose(pFile);
+
+	logBlockEnd("mapOfmSave()");
+	return 1;
+}
@@ -0,0 +1,46 @@
+#ifndef GUARD_OF_MAPOFM_H
+#define GUARD_OF_MAPOFM_H
+
+#include <ace/types.h>
+#include <ace/utils/file.h>
+#include "map.h"
+
+/**
+ * Compiled map (.ofm) layout:
+ * - tMapOfmHeader,
+ * - tMapControlPoint for each control point,
+ * - chunk usage, one byte per plane chunk, row-major,
+ * - logic plane, data of used chunks only, in chunk order,
+ * - control plane, ditto.
+ * Written & read on same machine, so no endianness conversion is done.
+ * Bump MAP_OFM_VERSION on each layout change so that stale files get rebuilt.
+ */
+#define MAP_OFM_VERSION 2
+
+/**
+ * Reads compiled map's header & control points into map struct.
+ * Planes aren't touched, so they may be allocated after this call.
+ * @param pFile File opened at its beginning.
+ * @param pMap Map to be filled.
+ * @return 1 on success, 0 if file is malformed or has different version.
+ */
+UBYTE mapOfmReadMeta(tFile *pFile, tMap *pMap);
+
+/**
+ * Allocates current map's planes & reads them from compiled map,
+ * continuing after mapOfmReadMeta().
+ * @param pFile File positioned right after metadata.
+ * @param pMap Map filled by mapOfmReadMeta(), with no planes allocated.
+ * @return 1 on success, otherwise 0.
+ */
+UBYTE mapOfmReadPlanes(tFile *pFile, tMap *pMap);
+
+/**
+ * Writes map in compiled form.
+ * @param pMap Fully loaded map.
+ * @param szPath Destination file path.
+ * @return 1 on success, otherwise 0.
+ */
+UBYTE mapOfmSave(const tMap *pMap, const char *szPath);
+
+#endif // GUARD_OF_MAPOFM_H
@@ -0,0 +1,88 @@
+#include "memstats.h"
+#include <ace/managers/log.h>
+
+static tMemStats s_pStats[MEMSTATS_TAG_COUNT] = {{0}};
+static ULONG s_ulTotalCurrBytes = 0;
+static ULONG s_ulTotalPeakBytes = 0;
+
+static const char *s_pTagNames[MEMSTATS_TAG_COUNT] = {
+	"AI", "map", "turrets", "bobs", "JSON", "precalc", "arena", "other"
+};
+
+void *memStatsAlloc(UBYTE ubTag, ULONG ulSize, ULONG ulFlags) {
+	void *pMem = memAlloc(ulSize, ulFlags);
+	if(!pMem) {
+		logWrite(
+			"ERR: Couldn't allocate %lu bytes for %s\n", ulSize, s_pTagNames[ubTag]
+		);
+		return 0;
+	}
+	tMemStats *pStats = &s_pStats[ubTag];
+	pStats->ulCurrBytes += ulSize;
+	pStats->ulPeakBytes = MAX(pStats->ulPeakBytes, pStats->ulCurrBytes);
+	++pStats->uwCurrAllocs;
+	pStats->uwPeakAllocs = MAX(pStats->uwPeakAllocs, pStats->uwCurrAllocs);
+	s_ulTotalCurrBytes += ulSize;
+	s_ulTotalPeakBytes = MAX(s_ulTotalPeakBytes, s_ulTotalCurrBytes);
+	return pMem;
+}
+
+void memStatsFree(UBYTE ubTag, void *pMem, ULONG ulSize) {
+	tMemStats *pStats = &s_pStats[ubTag];
+	if(pStats->ulCurrBytes < ulSize || !pStats->uwCurrAllocs) {
+		logWrite(
+			"ERR: Freeing %lu bytes from %s, only %lu allocated\n",
+			ulSize, s_pTagNames[ubTag], pStats->ulCurrBytes
+		);
+	}
+	else {
+		pStats->ulCurrBytes -= ulSize;
+		--pStats->uwCurrAllocs;
+		s_ulTotalCurrBytes -= ulSize;
+	}
+	memFree(pMem, ulSize);
+}
+
+void memStatsMove(UBYTE ubFrom, UBYTE ubTo, ULONG ulSize) {
+	tMemStats *pFrom = &s_pStats[ubFrom];
+	if(pFrom->ulCurrBytes < ulSize) {
+		logWrite(
+			"ERR: Moving %lu bytes from %s, only %lu allocated\n",
+			ulSize, s_pTagNames[ubFrom], pFrom->ulCurrBytes
+		);
+		return;
+	}
+	pFrom->ulCurrBytes -= ulSize;
+	tMemStats *pTo = &s_pStats[ubTo];
+	pTo->ulCurrBytes += ulSize;
+	pTo->ulPeakBytes = MAX(pTo->ulPeakBytes, pTo->ulCurrBytes);
+}
+
+void memStatsResetPeaks(void) {
+	for(FUBYTE fubTag = 0; fubTag < MEMSTATS_TAG_COUNT; ++fubTag) {
+		s_pStats[fubTag].ulPeakBytes = s_pStats[fubTag].ulCurrBytes;
+		s_pStats[fubTag].uwPeakAllocs = s_pStats[fubTag].uwCurrAllocs;
+	}
+	s_ulTotalPeakBytes = s_ulTotalCurrBytes;
+}
+
+const tMemStats *memStatsGet(UBYTE ubTag) {
+	return &s_pStats[ubTag];
+}
+
+void memStatsReport(const char *szWhen) {
+	logBlockBegin("memStatsReport(szWhen: %s)", szWhen);
+	for(FUBYTE fubTag = 0; fubTag < MEMSTATS_TAG_COUNT; ++fubTag) {
+		const tMemStats *pStats = &s_pStats[fubTag];
+		logWrite(
+			"%-8s curr: %7lu bytes in %3hu allocs, peak: %7lu bytes in %3hu allocs\n",
+			s_pTagNames[fubTag], pStats->ulCurrBytes, pStats->uwCurrAllocs,
+			pStats->ulPeakBytes, pStats->uwPeakAllocs
+		);
+	}
+	logWrite(
+		"Total curr: %lu bytes, peak: %lu bytes\n",
+		s_ulTotalCurrBytes, s_ulTotalPeakBytes
+	);
+	logBlockEnd("memStatsReport()");
+}
@@ -0,0 +1,69 @@
+#ifndef GUARD_OF_MEMSTATS_H
+#define GUARD_OF_MEMSTATS_H
+
+#include <ace/types.h>
+#include <ace/managers/memory.h>
+
+// Subsystems which get their own allocation counters
+#define MEMSTATS_TAG_AI 0
+#define MEMSTATS_TAG_MAP 1
+#define MEMSTATS_TAG_TURRETS 2
+#define MEMSTATS_TAG_BOBS 3
+#define MEMSTATS_TAG_JSON 4
+#define MEMSTATS_TAG_PRECALC 5
+#define MEMSTATS_TAG_ARENA 6 ///< Arena blocks not yet handed out to others.
+#define MEMSTATS_TAG_OTHER 7
+#define MEMSTATS_TAG_COUNT 8
+
+#define memAllocFastTagged(ubTag, ulSize) memStatsAlloc(ubTag, ulSize, MEMF_ANY)
+#define memAllocFastClearTagged(ubTag, ulSize) \
+	memStatsAlloc(ubTag, ulSize, MEMF_ANY | MEMF_CLEAR)
+#define memFreeTagged(ubTag, pMem, ulSize) memStatsFree(ubTag, pMem, ulSize)
+
+typedef struct _tMemStats {
+	ULONG ulCurrBytes; ///< Bytes currently allocated under given tag.
+	ULONG ulPeakBytes; ///< High-water mark of ulCurrBytes.
+	UWORD uwCurrAllocs; ///< Number of live allocations.
+	UWORD uwPeakAllocs; ///< High-water mark of uwCurrAllocs.
+} tMemStats;
+
+/**
+ * Allocates memory using ACE's memAlloc and accounts it to given subsystem.
+ * @param ubTag   Subsystem tag, one of MEMSTATS_TAG_*.
+ * @param ulSize  Number of bytes to allocate.
+ * @param ulFlags Flags passed to memAlloc.
+ * @return Pointer to allocated memory or 0 on failure.
+ */
+void *memStatsAlloc(UBYTE ubTag, ULONG ulSize, ULONG ulFlags);
+
+/**
+ * Frees memory previously allocated with memStatsAlloc.
+ * @param ubTag  Subsystem tag used for allocation.
+ * @param pMem   Pointer to memory to be freed.
+ * @param ulSize Size of allocation, same as passed to memStatsAlloc.
+ */
+void memStatsFree(UBYTE ubTag, void *pMem, ULONG ulSize);
+
+/**
+ * Moves accounted bytes from one subsystem to another without changing
+ * allocation counts, e.g. when arena hands out part of its block.
+ * @param ubFrom Tag which gives bytes away.
+ * @param ubTo   Tag which receives bytes.
+ * @param ulSize Number of bytes moved.
+ */
+void memStatsMove(UBYTE ubFrom, UBYTE ubTo, ULONG ulSize);
+
+/**
+ * Resets peak counters to current values, e.g. before loading next map.
+ */
+void memStatsResetPeaks(void);
+
+const tMemStats *memStatsGet(UBYTE ubTag);
+
+/**
+ * Writes current and peak usage of each subsystem to log.
+ * @param szWhen Short description of the moment when report is made.
+ */
+void memStatsReport(const char *szWhen);
+
+#endif // GUARD_OF_MEMSTATS_H
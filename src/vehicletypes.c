@@ -1,27 +1,73 @@
 #include "vehicletypes.h"
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
 #include <ace/managers/blit.h>
 #include <ace/utils/chunky.h>
 #include <fixmath/fix16.h>
+#include "atlas.h"
+#include "c2p.h"
 #include "cache.h"
 #include "gamestates/game/gamemath.h"
 #include "gamestates/precalc/precalc.h"
+#include "memstats.h"
 
 tVehicleType g_pVehicleTypes[VEHICLE_TYPE_COUNT];
 
-tBitMap *vehicleTypeGenerateRotatedFrames(const char *szPath) {
-	logBlockBegin("vehicleTypeGenerateRotatedFrames(szPath: '%s')", szPath);
+// Bump on each change of rotated frames generator so that caches get rebuilt
+#define VEHICLE_FRAMES_VERSION 4
 
-	char szBitmapFileName[100];
-	if(cacheIsValid(szPath)) {
-		sprintf(szBitmapFileName, "precalc/%s", szPath);
-		tBitMap *pBitmap = bitmapCreateFromFile(szBitmapFileName);
-		logBlockEnd("vehicleTypeGenerateRotatedFrames()");
-		return pBitmap;
+/**
+ * Sheets waiting for rotated frames. They are generated after all of them
+ * are queued, so that sheets used by same bob can be checked for mirroring
+ * together.
+ */
+#define VEHICLE_PENDING_SHEET_MAX (VEHICLE_TYPE_COUNT * 6)
+// Sheets in group of frames & mask are mirrored if at most 1/32 of pixels
+// in their missing frames would differ from exact ones
+#define VEHICLE_MIRROR_TOLERANCE_DIV 32
+
+typedef struct _tPendingSheet {
+	char szPath[ATLAS_NAME_MAX];
+	tBitMap *pBitmap;
+	const tFramePack **ppDst; ///< Gets packed sheet once it's generated.
+	UBYTE *pMirror;           ///< Shared by all sheets used by same bob.
+	UBYTE *pChunkySrc;
+	UWORD uwFrameWidth;
+} tPendingSheet;
+
+static tPendingSheet s_pPendingSheets[VEHICLE_PENDING_SHEET_MAX];
+static UBYTE s_ubPendingSheetCount = 0;
+
+/**
+ * Creates sheet with only first frame filled and puts it on pending list.
+ * @param szPath Path to file with source frame, relative to data dir.
+ * @param ppDst Where to store packed sheet pointer.
+ * @param pMirror Mirror row sum of bob which uses sheet.
+ */
+static void vehicleTypeQueueFrames(
+	const char *szPath, const tFramePack **ppDst, UBYTE *pMirror
+) {
+	logBlockBegin("vehicleTypeQueueFrames(szPath: '%s')", szPath);
+	*ppDst = 0;
+	if(
+		s_ubPendingSheetCount == VEHICLE_PENDING_SHEET_MAX ||
+		strlen(szPath) >= ATLAS_NAME_MAX
+	) {
+		logWrite("ERR: Can't generate frames for %s\n", szPath);
+		logBlockEnd("vehicleTypeQueueFrames()");
+		return;
 	}
 
 	// Load first frame to determine sizes
+	char szBitmapFileName[100];
 	sprintf(szBitmapFileName, "data/%s", szPath);
 	tBitMap *pFirstFrame = bitmapCreateFromFile(szBitmapFileName);
+	if(!pFirstFrame) {
+		logWrite("ERR: Couldn't load source frame\n");
+		logBlockEnd("vehicleTypeQueueFrames()");
+		return;
+	}
 	UWORD uwFrameWidth = bitmapGetByteWidth(pFirstFrame) * 8;
 
 	// Create huge-ass bitmap for all frames
@@ -35,8 +81,9 @@ tBitMap *vehicleTypeGenerateRotatedFrames(const char *szPath) {
 	);
 	if(!pBitmap) {
 		logWrite("ERR: Couldn't allocate bitmap\n");
-		logBlockEnd("vehicleTypeGenerateRotatedFrames()");
-		return 0;
+		bitmapDestroy(pFirstFrame);
+		logBlockEnd("vehicleTypeQueueFrames()");
+		return;
 	}
 
 	// Copy first frame to main bitmap
@@ -44,59 +91,310 @@ tBitMap *vehicleTypeGenerateRotatedFrames(const char *szPath) {
 	bitmapDestroy(pFirstFrame);
 
 	// Convert first frame to chunky
-	UBYTE *pChunkySrc = memAllocFast(uwFrameWidth * uwFrameWidth);
-	chunkyFromBitmap(pBitmap, pChunkySrc, 0, 0, uwFrameWidth, uwFrameWidth);
-
-	UBYTE *pChunkyRotated = memAllocFast(uwFrameWidth * uwFrameWidth);
-	for(FUBYTE fubFrame = 1; fubFrame < VEHICLE_BODY_ANGLE_COUNT; ++fubFrame) {
-		// Rotate chunky source and place on huge-ass bitmap
-		UBYTE ubAngle = ANGLE_360 - (fubFrame<<1);
-		chunkyRotate(
-			pChunkySrc, pChunkyRotated,	csin(ubAngle), ccos(ubAngle),
-			0, uwFrameWidth, uwFrameWidth
-		);
-		chunkyToBitmap(
-			pChunkyRotated, pBitmap,
-			0, uwFrameWidth*fubFrame, uwFrameWidth, uwFrameWidth
-		);
+	UBYTE *pChunkySrc = memAllocFastTagged(
+		MEMSTATS_TAG_PRECALC, uwFrameWidth * uwFrameWidth
+	);
+	if(!pChunkySrc) {
+		logWrite("ERR: Couldn't allocate chunky source\n");
+		bitmapDestroy(pBitmap);
+		logBlockEnd("vehicleTypeQueueFrames()");
+		return;
 	}
-	memFree(pChunkySrc, uwFrameWidth * uwFrameWidth);
-	memFree(pChunkyRotated, uwFrameWidth * uwFrameWidth);
+	c2pBitmapToChunky(pBitmap, pChunkySrc, 0, 0, uwFrameWidth, uwFrameWidth);
+	tPendingSheet *pSheet = &s_pPendingSheets[s_ubPendingSheetCount++];
+	strcpy(pSheet->szPath, szPath);
+	pSheet->pBitmap = pBitmap;
+	pSheet->ppDst = ppDst;
+	pSheet->pMirror = pMirror;
+	pSheet->uwFrameWidth = uwFrameWidth;
+	pSheet->pChunkySrc = pChunkySrc;
+	logBlockEnd("vehicleTypeQueueFrames()");
+}
 
-	// Generate cache
-	sprintf(szBitmapFileName, "precalc/%s", szPath);
-	bitmapSave(pBitmap, szBitmapFileName);
-	cacheGenerateChecksum(szPath);
+/**
+ * Counts pixels of frames past VEHICLE_MIRROR_FRAME_COUNT which differ from
+ * ones made by mirroring frames of opposite angle.
+ */
+static ULONG vehicleTypeCountMirrorDiffs(
+	const tBitMap *pSheet, UWORD uwFrameWidth, UWORD uwRowSum
+) {
+	UWORD uwByteWidth = uwFrameWidth / 8;
+	ULONG ulDiffs = 0;
+	for(
+		UBYTE ubFrame = VEHICLE_MIRROR_FRAME_COUNT;
+		ubFrame < VEHICLE_BODY_ANGLE_COUNT; ++ubFrame
+	) {
+		UWORD uwRow = ubFrame * uwFrameWidth;
+		UWORD uwMirroredRow = (VEHICLE_BODY_ANGLE_COUNT - ubFrame) * uwFrameWidth;
+		for(UWORD y = 0; y < uwFrameWidth; ++y) {
+			UWORD uwSrcY = uwRowSum - y;
+			for(UWORD x = 0; x < uwByteWidth; ++x) {
+				UBYTE ubDiff = 0;
+				for(UBYTE ubPlane = 0; ubPlane < pSheet->Depth; ++ubPlane) {
+					const UBYTE *pPlane = pSheet->Planes[ubPlane];
+					UBYTE ubMirrored = 0;
+					if(uwSrcY < uwFrameWidth) {
+						ubMirrored = pPlane[(uwMirroredRow + uwSrcY) * pSheet->BytesPerRow + x];
+					}
+					ubDiff |= pPlane[(uwRow + y) * pSheet->BytesPerRow + x] ^ ubMirrored;
+				}
+				while(ubDiff) {
+					ubDiff &= ubDiff - 1;
+					++ulDiffs;
+				}
+			}
+		}
+	}
+	return ulDiffs;
+}
 
-	logBlockEnd("vehicleTypeGenerateRotatedFrames()");
-	return pBitmap;
+/**
+ * Creates copy of sheet holding only first VEHICLE_MIRROR_FRAME_COUNT frames.
+ */
+static tBitMap *vehicleTypeCreateCropped(const tPendingSheet *pSheet) {
+	const tBitMap *pFull = pSheet->pBitmap;
+	tBitMap *pCropped = bitmapCreate(
+		pSheet->uwFrameWidth, pSheet->uwFrameWidth * VEHICLE_MIRROR_FRAME_COUNT,
+		pFull->Depth, bitmapIsInterleaved(pFull) ? BMF_INTERLEAVED : 0
+	);
+	if(!pCropped) {
+		return 0;
+	}
+	UWORD uwByteWidth = bitmapGetByteWidth(pFull);
+	for(UBYTE ubPlane = 0; ubPlane < pFull->Depth; ++ubPlane) {
+		for(UWORD y = 0; y < pCropped->Rows; ++y) {
+			memcpy(
+				&pCropped->Planes[ubPlane][y * pCropped->BytesPerRow],
+				&pFull->Planes[ubPlane][y * pFull->BytesPerRow], uwByteWidth
+			);
+		}
+	}
+	return pCropped;
 }
 
-static void vehicleTypeFramesCreate(tVehicleType *pType, char *szVehicleName, UBYTE isAux) {
-	char szFilePath[100];
+/**
+ * Checks if all sheets of group can be mirrored and crops them if so.
+ * Rotation center may lie on pixel edge or middle, so both axes are tried.
+ * @param pGroup First sheet of group.
+ * @param ubCount Number of sheets in group.
+ */
+static void vehicleTypeTryMirror(tPendingSheet *pGroup, UBYTE ubCount) {
+	UWORD uwFrameWidth = pGroup[0].uwFrameWidth;
+	for(UBYTE i = 1; i < ubCount; ++i) {
+		if(pGroup[i].uwFrameWidth != uwFrameWidth) {
+			return;
+		}
+	}
+	ULONG ulMaxDiffs = (
+		(ULONG)uwFrameWidth * uwFrameWidth *
+		(VEHICLE_BODY_ANGLE_COUNT - VEHICLE_MIRROR_FRAME_COUNT) /
+		VEHICLE_MIRROR_TOLERANCE_DIV
+	);
+	UWORD uwBestSum = 0;
+	ULONG ulBestDiffs = 0;
+	for(UWORD uwSum = uwFrameWidth - 1; uwSum <= uwFrameWidth; ++uwSum) {
+		ULONG ulTotalDiffs = 0;
+		UBYTE isOk = 1;
+		for(UBYTE i = 0; isOk && i < ubCount; ++i) {
+			ULONG ulDiffs = vehicleTypeCountMirrorDiffs(
+				pGroup[i].pBitmap, uwFrameWidth, uwSum
+			);
+			isOk = (ulDiffs <= ulMaxDiffs);
+			ulTotalDiffs += ulDiffs;
+		}
+		if(isOk && (!uwBestSum || ulTotalDiffs < ulBestDiffs)) {
+			uwBestSum = uwSum;
+			ulBestDiffs = ulTotalDiffs;
+		}
+	}
+	if(!uwBestSum) {
+		return;
+	}
 
-	sprintf(szFilePath, "vehicles/%s/main_blue.bm", szVehicleName);
-	pType->pMainFrames[TEAM_BLUE] = vehicleTypeGenerateRotatedFrames(szFilePath);
+	// Replace sheets only if all of them got cropped
+	tBitMap *pCropped[VEHICLE_PENDING_SHEET_MAX];
+	for(UBYTE i = 0; i < ubCount; ++i) {
+		pCropped[i] = vehicleTypeCreateCropped(&pGroup[i]);
+		if(!pCropped[i]) {
+			logWrite("ERR: Couldn't allocate mirrored sheet\n");
+			while(i--) {
+				bitmapDestroy(pCropped[i]);
+			}
+			return;
+		}
+	}
+	for(UBYTE i = 0; i < ubCount; ++i) {
+		bitmapDestroy(pGroup[i].pBitmap);
+		pGroup[i].pBitmap = pCropped[i];
+	}
+	*pGroup[0].pMirror = uwBestSum;
+	logWrite(
+		"Mirrored %s & co, axis sum %hu, %lu pixels off\n",
+		pGroup[0].szPath, uwBestSum, ulBestDiffs
+	);
+}
 
-	sprintf(szFilePath, "vehicles/%s/main_red.bm", szVehicleName);
-	pType->pMainFrames[TEAM_RED] = vehicleTypeGenerateRotatedFrames(szFilePath);
+/**
+ * Frees sheets which won't get generated, leaving their destinations empty.
+ */
+static void vehicleTypesDropPendingFrames(void) {
+	for(UBYTE i = 0; i < s_ubPendingSheetCount; ++i) {
+		tPendingSheet *pSheet = &s_pPendingSheets[i];
+		memFreeTagged(
+			MEMSTATS_TAG_PRECALC, pSheet->pChunkySrc,
+			pSheet->uwFrameWidth * pSheet->uwFrameWidth
+		);
+		bitmapDestroy(pSheet->pBitmap);
+	}
+	s_ubPendingSheetCount = 0;
+}
 
-	sprintf(szFilePath, "vehicles/%s/main_mask.bm", szVehicleName);
-	pType->pMainMask = vehicleTypeGenerateRotatedFrames(szFilePath);
-	if(isAux) {
-		sprintf(szFilePath, "vehicles/%s/aux_blue.bm", szVehicleName);
-		pType->pAuxFrames[TEAM_BLUE] = vehicleTypeGenerateRotatedFrames(szFilePath);
+static void vehicleTypesGeneratePendingFrames(void) {
+	if(!s_ubPendingSheetCount) {
+		return;
+	}
+	logBlockBegin(
+		"vehicleTypesGeneratePendingFrames(): %hhu sheets", s_ubPendingSheetCount
+	);
+
+	UWORD uwMaxWidth = 0;
+	for(UBYTE i = 0; i < s_ubPendingSheetCount; ++i) {
+		uwMaxWidth = MAX(uwMaxWidth, s_pPendingSheets[i].uwFrameWidth);
+	}
+	// Rotated frame buffer is shared by all sheets
+	ULONG ulFrameSize = uwMaxWidth * uwMaxWidth;
+	UBYTE *pChunkyRotated = memAllocFastTagged(MEMSTATS_TAG_PRECALC, ulFrameSize);
+	if(!pChunkyRotated) {
+		logWrite("ERR: No memory for rotation, frames not generated\n");
+		vehicleTypesDropPendingFrames();
+		logBlockEnd("vehicleTypesGeneratePendingFrames()");
+		return;
+	}
+
+	for(UBYTE i = 0; i < s_ubPendingSheetCount; ++i) {
+		const tPendingSheet *pSheet = &s_pPendingSheets[i];
+		UWORD uwFrameWidth = pSheet->uwFrameWidth;
+		for(FUBYTE fubFrame = 1; fubFrame < VEHICLE_BODY_ANGLE_COUNT; ++fubFrame) {
+			// Rotate chunky source and place on huge-ass bitmap
+			UBYTE ubAngle = ANGLE_360 - (fubFrame<<1);
+			chunkyRotate(
+				pSheet->pChunkySrc, pChunkyRotated, csin(ubAngle), ccos(ubAngle),
+				0, uwFrameWidth, uwFrameWidth
+			);
+			c2pChunkyToBitmap(
+				pChunkyRotated, pSheet->pBitmap,
+				0, uwFrameWidth*fubFrame, uwFrameWidth, uwFrameWidth
+			);
+		}
+	}
+	memFreeTagged(MEMSTATS_TAG_PRECALC, pChunkyRotated, ulFrameSize);
+
+	// Sheets of same bob are queued one after another
+	UBYTE ubGroupStart = 0;
+	for(UBYTE i = 1; i <= s_ubPendingSheetCount; ++i) {
+		if(
+			i == s_ubPendingSheetCount ||
+			s_pPendingSheets[i].pMirror != s_pPendingSheets[ubGroupStart].pMirror
+		) {
+			vehicleTypeTryMirror(&s_pPendingSheets[ubGroupStart], i - ubGroupStart);
+			ubGroupStart = i;
+		}
+	}
+
+	for(UBYTE i = 0; i < s_ubPendingSheetCount; ++i) {
+		tPendingSheet *pSheet = &s_pPendingSheets[i];
+		memFreeTagged(
+			MEMSTATS_TAG_PRECALC, pSheet->pChunkySrc,
+			pSheet->uwFrameWidth * pSheet->uwFrameWidth
+		);
+		// Sheets are drawn from frame cache, so only packed ones are kept
+		ULONG ulPackSize;
+		tFramePack *pPack = framePackCreate(
+			pSheet->pBitmap, pSheet->uwFrameWidth, &ulPackSize
+		);
+		logWrite(
+			"Packed %s: %lu -> %lu bytes\n", pSheet->szPath,
+			(ULONG)pSheet->pBitmap->BytesPerRow * pSheet->pBitmap->Rows, ulPackSize
+		);
+		bitmapDestroy(pSheet->pBitmap);
+		if(pPack) {
+			// Atlas gets saved after all sheets are generated
+			atlasAddBlob(
+				pSheet->szPath, VEHICLE_FRAMES_VERSION, pPack, ulPackSize,
+				*pSheet->pMirror
+			);
+			*pSheet->ppDst = pPack;
+		}
+	}
+	s_ubPendingSheetCount = 0;
+	logBlockEnd("vehicleTypesGeneratePendingFrames()");
+}
+
+/**
+ * Gets frames & mask sheets used by single bob. They are regenerated together
+ * unless all of them are cached, since they must share mirroring.
+ */
+static void vehicleTypeGroupFramesCreate(
+	const char *szVehicleName, const char *szPart,
+	const tFramePack **pFrames, const tFramePack **ppMask, UBYTE *pMirror
+) {
+	static const char * const pSuffixes[3] = {"blue", "red", "mask"};
+	const tFramePack **pDsts[3] = {
+		&pFrames[TEAM_BLUE], &pFrames[TEAM_RED], ppMask
+	};
+	char szFilePath[3][ATLAS_NAME_MAX];
+	UWORD uwGroupMirror = 0;
+	UBYTE isCached = 1;
+	for(UBYTE i = 0; i < 3; ++i) {
+		sprintf(
+			szFilePath[i], "vehicles/%s/%s_%s.bm", szVehicleName, szPart,
+			pSuffixes[i]
+		);
+		UWORD uwMirror = 0;
+		ULONG ulSize = 0;
+		*pDsts[i] = atlasGetBlob(
+			szFilePath[i], VEHICLE_FRAMES_VERSION, &ulSize, &uwMirror
+		);
+		if(*pDsts[i] && !framePackIsValid(*pDsts[i], ulSize)) {
+			logWrite("ERR: Packed frames of %s are malformed\n", szFilePath[i]);
+			*pDsts[i] = 0;
+		}
+		if(!i) {
+			uwGroupMirror = uwMirror;
+		}
+		if(!*pDsts[i] || uwMirror != uwGroupMirror) {
+			isCached = 0;
+		}
+	}
+	if(isCached) {
+		*pMirror = uwGroupMirror;
+		return;
+	}
 
-		sprintf(szFilePath, "vehicles/%s/aux_red.bm", szVehicleName);
-		pType->pAuxFrames[TEAM_RED] = vehicleTypeGenerateRotatedFrames(szFilePath);
+	*pMirror = 0;
+	for(UBYTE i = 0; i < 3; ++i) {
+		vehicleTypeQueueFrames(szFilePath[i], pDsts[i], pMirror);
+	}
+}
 
-		sprintf(szFilePath, "vehicles/%s/aux_mask.bm", szVehicleName);
-		pType->pAuxMask = vehicleTypeGenerateRotatedFrames(szFilePath);
+static void vehicleTypeFramesCreate(
+	tVehicleType *pType, const char *szVehicleName, UBYTE isAux
+) {
+	vehicleTypeGroupFramesCreate(
+		szVehicleName, "main", pType->pMainFrames, &pType->pMainMask,
+		&pType->ubMainMirror
+	);
+	if(isAux) {
+		vehicleTypeGroupFramesCreate(
+			szVehicleName, "aux", pType->pAuxFrames, &pType->pAuxMask,
+			&pType->ubAuxMirror
+		);
 	}
 	else {
 		pType->pAuxFrames[TEAM_BLUE] = 0;
 		pType->pAuxFrames[TEAM_RED] = 0;
 		pType->pAuxMask = 0;
+		pType->ubAuxMirror = 0;
 	}
 }
 
@@ -142,101 +440,282 @@ static void vehicleTypeGenerateRotatedCollisions(tCollisionPts *pFrameCollisions
 	logBlockEnd("vehicleTypeGenerateRotatedCollisions()");
 }
 
+static UBYTE vehicleTypesParseNumber(
+	const char **ppLine, LONG lMin, LONG lMax, LONG *pOut
+) {
+	// Don't let strtol() skip to next line
+	const char *pLine = *ppLine;
+	while(*pLine == ' ' || *pLine == '\t') {
+		++pLine;
+	}
+	char *pEnd;
+	LONG lValue = strtol(pLine, &pEnd, 10);
+	if(pEnd == pLine || lValue < lMin || lValue > lMax) {
+		return 0;
+	}
+	*ppLine = pEnd;
+	*pOut = lValue;
+	return 1;
+}
+
+static UBYTE vehicleTypesParseName(const char **ppLine, char *szName) {
+	const char *pLine = *ppLine;
+	while(*pLine == ' ' || *pLine == '\t') {
+		++pLine;
+	}
+	UBYTE ubLength = 0;
+	while(*pLine > ' ') {
+		if(ubLength + 1 >= VEHICLE_NAME_MAX) {
+			return 0;
+		}
+		szName[ubLength++] = *(pLine++);
+	}
+	szName[ubLength] = '\0';
+	*ppLine = pLine;
+	return ubLength != 0;
+}
+
+/**
+ * Reads whole text file into zero-terminated buffer.
+ * @param szPath Path to file.
+ * @param pSize Size of returned buffer, for freeing it.
+ * @return Buffer with file contents or 0 on failure.
+ */
+static char *vehicleTypesReadText(const char *szPath, ULONG *pSize) {
+	tFile *pFile = fileOpen(szPath, "rb");
+	if(!pFile) {
+		logWrite("ERR: File doesn't exist: '%s'\n", szPath);
+		return 0;
+	}
+	fileSeek(pFile, 0, FILE_SEEK_END);
+	ULONG ulFileSize = fileGetPos(pFile);
+	fileSeek(pFile, 0, FILE_SEEK_SET);
+	*pSize = ulFileSize + 1;
+	char *szText = memAllocFastTagged(MEMSTATS_TAG_PRECALC, *pSize);
+	if(!szText) {
+		logWrite("ERR: Couldn't allocate %lu bytes for '%s'\n", *pSize, szPath);
+		fileClose(pFile);
+		return 0;
+	}
+	fileRead(pFile, szText, ulFileSize);
+	szText[ulFileSize] = '\0';
+	fileClose(pFile);
+	return szText;
+}
+
+/**
+ * Parses definition file, one vehicle type per line. Each line starts with
+ * type idx, lines starting with ';' are comments.
+ * @param szPath Path to file.
+ * @param parseLine Callback for parsing rest of line, returns 0 on error.
+ * @return 1 on success, otherwise 0.
+ */
+static UBYTE vehicleTypesParseFile(
+	const char *szPath,
+	UBYTE (*parseLine)(tVehicleType *pType, const char **ppLine)
+) {
+	ULONG ulSize;
+	char *szText = vehicleTypesReadText(szPath, &ulSize);
+	if(!szText) {
+		return 0;
+	}
+	UBYTE isOk = 1;
+	UWORD uwLine = 1;
+	for(const char *pLine = szText; *pLine && isOk; ++uwLine) {
+		const char *pLineEnd = strchr(pLine, '\n');
+		if(!pLineEnd) {
+			pLineEnd = pLine + strlen(pLine);
+		}
+		const char *pFirst = pLine;
+		while(*pFirst == ' ' || *pFirst == '\t') {
+			++pFirst;
+		}
+		if(*pFirst != ';' && pFirst < pLineEnd && *pFirst > ' ') {
+			LONG lType;
+			isOk = (
+				vehicleTypesParseNumber(&pFirst, 0, VEHICLE_TYPE_COUNT - 1, &lType) &&
+				parseLine(&g_pVehicleTypes[lType], &pFirst)
+			);
+			if(!isOk) {
+				logWrite("ERR: Malformed line %hu of '%s'\n", uwLine, szPath);
+			}
+		}
+		pLine = *pLineEnd ? pLineEnd + 1 : pLineEnd;
+	}
+	memFreeTagged(MEMSTATS_TAG_PRECALC, szText, ulSize);
+	return isOk;
+}
+
+static UBYTE vehicleTypeParseStats(tVehicleType *pType, const char **ppLine) {
+	UBYTE *pStats[] = {
+		&pType->ubFwdSpeed, &pType->ubBwSpeed, &pType->ubRotSpeed,
+		&pType->ubRotSpeedDiv, &pType->ubMaxBaseAmmo, &pType->ubMaxSuperAmmo,
+		&pType->ubMaxFuel, &pType->ubMaxLife, &pType->isAux
+	};
+	if(!vehicleTypesParseName(ppLine, pType->szName)) {
+		return 0;
+	}
+	for(UBYTE i = 0; i < sizeof(pStats) / sizeof(pStats[0]); ++i) {
+		LONG lValue;
+		if(!vehicleTypesParseNumber(ppLine, 0, 255, &lValue)) {
+			return 0;
+		}
+		*pStats[i] = lValue;
+	}
+	return 1;
+}
+
+static UBYTE vehicleTypeParseCollisions(
+	tVehicleType *pType, const char **ppLine
+) {
+	tBCoordYX *pPts = pType->pCollisionPts[0].pPts;
+	for(UBYTE i = 0; i != 8; ++i) {
+		LONG lX, lY;
+		if(
+			!vehicleTypesParseNumber(ppLine, 0, VEHICLE_BODY_WIDTH - 1, &lX) ||
+			!vehicleTypesParseNumber(ppLine, 0, VEHICLE_BODY_HEIGHT - 1, &lY)
+		) {
+			return 0;
+		}
+		pPts[i].bX = lX - VEHICLE_BODY_WIDTH/2;
+		pPts[i].bY = lY - VEHICLE_BODY_HEIGHT/2;
+	}
+	return 1;
+}
+
+// Cached defs are written & read on same machine, so they're raw structs.
+// Bump version on each tVehicleType change.
+#define VEHICLE_TYPES_CACHE_VERSION 1
+#define VEHICLE_TYPES_CACHE_PATH "vehicles/types.dat"
+#define VEHICLE_TYPES_DEF_SIZE offsetof(tVehicleType, pMainFrames)
+
+static UBYTE vehicleTypesLoadCache(void) {
+	if(
+		!cacheIsValidCompiled(
+			"vehicles/vehicles.txt", VEHICLE_TYPES_CACHE_PATH,
+			VEHICLE_TYPES_CACHE_VERSION
+		) ||
+		!cacheIsValidCompiled(
+			"vehicles/vehiclecollisions.txt", VEHICLE_TYPES_CACHE_PATH,
+			VEHICLE_TYPES_CACHE_VERSION
+		)
+	) {
+		return 0;
+	}
+	tFile *pFile = fileOpen("precalc/" VEHICLE_TYPES_CACHE_PATH, "rb");
+	if(!pFile) {
+		return 0;
+	}
+	UWORD uwVersion = 0;
+	fileRead(pFile, &uwVersion, sizeof(uwVersion));
+	UBYTE isOk = (uwVersion == VEHICLE_TYPES_CACHE_VERSION);
+	for(UBYTE i = 0; isOk && i < VEHICLE_TYPE_COUNT; ++i) {
+		isOk = (
+			fileRead(pFile, &g_pVehicleTypes[i], VEHICLE_TYPES_DEF_SIZE) ==
+			VEHICLE_TYPES_DEF_SIZE
+		);
+	}
+	fileClose(pFile);
+	return isOk;
+}
+
+static void vehicleTypesSaveCache(void) {
+	tFile *pFile = fileOpen("precalc/" VEHICLE_TYPES_CACHE_PATH, "wb");
+	if(!pFile) {
+		logWrite("ERR: Couldn't save vehicle types cache\n");
+		return;
+	}
+	UWORD uwVersion = VEHICLE_TYPES_CACHE_VERSION;
+	fileWrite(pFile, &uwVersion, sizeof(uwVersion));
+	for(UBYTE i = 0; i < VEHICLE_TYPE_COUNT; ++i) {
+		fileWrite(pFile, &g_pVehicleTypes[i], VEHICLE_TYPES_DEF_SIZE);
+	}
+	fileClose(pFile);
+	cacheGenerateChecksumCompiled(
+		"vehicles/vehicles.txt", VEHICLE_TYPES_CACHE_PATH,
+		VEHICLE_TYPES_CACHE_VERSION
+	);
+	cacheGenerateChecksumCompiled(
+		"vehicles/vehiclecollisions.txt", VEHICLE_TYPES_CACHE_PATH,
+		VEHICLE_TYPES_CACHE_VERSION
+	);
+}
+
+static UBYTE vehicleTypesLoadDefs(void) {
+	memset(g_pVehicleTypes, 0, sizeof(g_pVehicleTypes));
+	if(
+		!vehicleTypesParseFile(
+			"data/vehicles/vehicles.txt", vehicleTypeParseStats
+		) ||
+		!vehicleTypesParseFile(
+			"data/vehicles/vehiclecollisions.txt", vehicleTypeParseCollisions
+		)
+	) {
+		return 0;
+	}
+	for(UBYTE i = 0; i < VEHICLE_TYPE_COUNT; ++i) {
+		if(g_pVehicleTypes[i].szName[0]) {
+			vehicleTypeGenerateRotatedCollisions(g_pVehicleTypes[i].pCollisionPts);
+		}
+	}
+	return 1;
+}
+
 /**
  *  Generates vehicle type defs.
  *  This fn fills g_pVehicleTypes array
- *  @todo Chopper
- *  @todo ASV
  */
 void vehicleTypesCreate(void) {
-	tVehicleType *pType;
-
 	logBlockBegin("vehicleTypesCreate");
 
-	// Tank
-	pType = &g_pVehicleTypes[VEHICLE_TYPE_TANK];
-	pType->ubFwdSpeed = 1;
-	pType->ubBwSpeed = 1;
-	pType->ubRotSpeed = 2;
-	pType->ubRotSpeedDiv = 4;
-	pType->ubMaxBaseAmmo = 100;
-	pType->ubMaxSuperAmmo = 0;
-	pType->ubMaxFuel = 100;
-	pType->ubMaxLife = 100;
-
-	precalcIncreaseProgress(15, "Generating tank frames");
-	vehicleTypeFramesCreate(pType, "tank", 1);
-
-	// Tank collision coords
-	precalcIncreaseProgress(15, "Calculating tank collision coords");
-	pType->pCollisionPts[0].pPts[0].bX = 6;  pType->pCollisionPts[0].pPts[0].bY = 8;
-	pType->pCollisionPts[0].pPts[1].bX = 17; pType->pCollisionPts[0].pPts[1].bY = 8;
-	pType->pCollisionPts[0].pPts[2].bX = 29; pType->pCollisionPts[0].pPts[2].bY = 8;
-	pType->pCollisionPts[0].pPts[3].bX = 6;  pType->pCollisionPts[0].pPts[3].bY = 16;
-	pType->pCollisionPts[0].pPts[4].bX = 29; pType->pCollisionPts[0].pPts[4].bY = 16;
-	pType->pCollisionPts[0].pPts[5].bX = 6;  pType->pCollisionPts[0].pPts[5].bY = 24;
-	pType->pCollisionPts[0].pPts[6].bX = 17; pType->pCollisionPts[0].pPts[6].bY = 24;
-	pType->pCollisionPts[0].pPts[7].bX = 29; pType->pCollisionPts[0].pPts[7].bY = 24;
-	for(FUBYTE i = 0; i != 8; ++i) {
-		pType->pCollisionPts[0].pPts[i].bX -= VEHICLE_BODY_WIDTH/2;
-		pType->pCollisionPts[0].pPts[i].bY -= VEHICLE_BODY_HEIGHT/2;
-	}
-
-	vehicleTypeGenerateRotatedCollisions(pType->pCollisionPts);
-
-	// Jeep
-	pType = &g_pVehicleTypes[VEHICLE_TYPE_JEEP];
-	pType->ubFwdSpeed = 2;
-	pType->ubBwSpeed = 1;
-	pType->ubRotSpeed = 2;
-	pType->ubRotSpeedDiv = 1;
-	pType->ubMaxBaseAmmo = 20;
-	pType->ubMaxSuperAmmo = 0;
-	pType->ubMaxFuel = 100;
-	pType->ubMaxLife = 1;
-
-	precalcIncreaseProgress(15, "Generating jeep frames");
-	vehicleTypeFramesCreate(pType, "jeep", 0);
-
-	// Jeep collision coords
-	precalcIncreaseProgress(15, "Calculating jeep collision coords");
-	pType->pCollisionPts[0].pPts[0].bX = 8;  pType->pCollisionPts[0].pPts[0].bY = 11;
-	pType->pCollisionPts[0].pPts[1].bX = 16; pType->pCollisionPts[0].pPts[1].bY = 11;
-	pType->pCollisionPts[0].pPts[2].bX = 25; pType->pCollisionPts[0].pPts[2].bY = 11;
-	pType->pCollisionPts[0].pPts[3].bX = 8;  pType->pCollisionPts[0].pPts[3].bY = 16;
-	pType->pCollisionPts[0].pPts[4].bX = 25; pType->pCollisionPts[0].pPts[4].bY = 16;
-	pType->pCollisionPts[0].pPts[5].bX = 8;  pType->pCollisionPts[0].pPts[5].bY = 20;
-	pType->pCollisionPts[0].pPts[6].bX = 16; pType->pCollisionPts[0].pPts[6].bY = 20;
-	pType->pCollisionPts[0].pPts[7].bX = 25; pType->pCollisionPts[0].pPts[7].bY = 20;
-	for(FUBYTE i = 0; i != 8; ++i) {
-		pType->pCollisionPts[0].pPts[i].bX -= VEHICLE_BODY_WIDTH/2;
-		pType->pCollisionPts[0].pPts[i].bY -= VEHICLE_BODY_HEIGHT/2;
-	}
-	vehicleTypeGenerateRotatedCollisions(pType->pCollisionPts);
+	precalcIncreaseProgress(10, "Loading vehicle definitions");
+	if(vehicleTypesLoadCache()) {
+		logWrite("Loaded cached vehicle definitions\n");
+	}
+	else if(vehicleTypesLoadDefs()) {
+		vehicleTypesSaveCache();
+	}
+	else {
+		logWrite("ERR: Couldn't load vehicle definitions\n");
+	}
+
+	for(UBYTE i = 0; i < VEHICLE_TYPE_COUNT; ++i) {
+		tVehicleType *pType = &g_pVehicleTypes[i];
+		if(!pType->szName[0]) {
+			continue;
+		}
+		char szProgress[40];
+		sprintf(szProgress, "Loading %s frames", pType->szName);
+		precalcIncreaseProgress(10, szProgress);
+		vehicleTypeFramesCreate(pType, pType->szName, pType->isAux);
+	}
+	precalcIncreaseProgress(20, "Rotating vehicle frames");
+	vehicleTypesGeneratePendingFrames();
 
 	logBlockEnd("vehicleTypesCreate");
 }
 
 static void vehicleTypeUnloadFrameData(tVehicleType *pType) {
-	bitmapDestroy(pType->pMainFrames[TEAM_BLUE]);
-	bitmapDestroy(pType->pMainFrames[TEAM_RED]);
-	bitmapDestroy(pType->pMainMask);
-	if(pType->pAuxFrames[TEAM_BLUE])
-		bitmapDestroy(pType->pAuxFrames[TEAM_BLUE]);
-	if(pType->pAuxFrames[TEAM_RED])
-		bitmapDestroy(pType->pAuxFrames[TEAM_RED]);
-	if(pType->pAuxMask)
-		bitmapDestroy(pType->pAuxMask);
+	// Frames are owned by atlas
+	pType->pMainFrames[TEAM_BLUE] = 0;
+	pType->pMainFrames[TEAM_RED] = 0;
+	pType->pMainMask = 0;
+	pType->pAuxFrames[TEAM_BLUE] = 0;
+	pType->pAuxFrames[TEAM_RED] = 0;
+	pType->pAuxMask = 0;
+	pType->ubMainMirror = 0;
+	pType->ubAuxMirror = 0;
 }
 
 void vehicleTypesDestroy(void) {
 	logBlockBegin("vehicleTypesDestroy()");
 
 	// Free bob sources
-	vehicleTypeUnloadFrameData(&g_pVehicleTypes[VEHICLE_TYPE_TANK]);
-	vehicleTypeUnloadFrameData(&g_pVehicleTypes[VEHICLE_TYPE_JEEP]);
-	// TODO ASV
-	// TODO Chopper
+	for(UBYTE i = 0; i < VEHICLE_TYPE_COUNT; ++i) {
+		if(g_pVehicleTypes[i].szName[0]) {
+			vehicleTypeUnloadFrameData(&g_pVehicleTypes[i]);
+		}
+	}
 
 	logBlockEnd("vehicleTypesDestroy()");
 }
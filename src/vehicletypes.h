@@ -3,6 +3,7 @@
 
 #include "gamestates/game/team.h"
 #include <ace/utils/bitmap.h>
+#include "framepack.h"
 
 #define VEHICLE_TYPE_COUNT 4
 #define VEHICLE_TYPE_TANK 0
@@ -16,6 +17,12 @@
 #define VEHICLE_TURRET_ANGLE_COUNT 128
 #define VEHICLE_TURRET_WIDTH 32
 #define VEHICLE_TURRET_HEIGHT 32
+#define VEHICLE_NAME_MAX 12
+/**
+ * Frame count of mirrored sheet - frames past it are produced from ones with
+ * opposite angle, flipped vertically. See ubMainMirror in tVehicleType.
+ */
+#define VEHICLE_MIRROR_FRAME_COUNT (VEHICLE_BODY_ANGLE_COUNT/2 + 1)
 
 /**
  * 0--1--2
@@ -30,7 +37,14 @@ typedef struct _tCollisionPoints {
 	BYTE bRightmost;
 } tCollisionPts;
 
+/**
+ * Vehicle type definition. Everything up to frame bitmaps is loaded from
+ * data/vehicles/vehicles.txt & vehiclecollisions.txt and stored as-is
+ * in precalc cache, so keep it free of pointers.
+ */
 typedef struct _tVehicleType {
+	char szName[VEHICLE_NAME_MAX]; ///< Frames dir name, empty if undefined.
+	UBYTE isAux;          ///< Has aux bob, e.g. tank turret.
 	UBYTE ubFwdSpeed;     ///< Forward movement speed
 	UBYTE ubBwSpeed;      ///< Backward movement speed
 	UBYTE ubRotSpeed;     ///< Rotate speed
@@ -40,25 +54,26 @@ typedef struct _tVehicleType {
 	UBYTE ubMaxFuel;
 	UBYTE ubMaxLife;
 	tCollisionPts pCollisionPts[VEHICLE_BODY_ANGLE_COUNT];
-	// Main bob source
-	tBitMap *pMainFrames[TEAM_COUNT];
-	tBitMap *pMainMask;
+	// Main bob source, drawn through frame cache
+	const tFramePack *pMainFrames[TEAM_COUNT];
+	const tFramePack *pMainMask;
 	// Aux bob source
-	tBitMap *pAuxFrames[TEAM_COUNT];
-	tBitMap *pAuxMask;
+	const tFramePack *pAuxFrames[TEAM_COUNT];
+	const tFramePack *pAuxMask;
+	// Row y of missing frame comes from row (ubMirror - y) of mirrored one.
+	// Zero if sheets hold all frames.
+	UBYTE ubMainMirror;
+	UBYTE ubAuxMirror;
 } tVehicleType;
 
+/**
+ * Loads vehicle definitions, from precalc cache if it's up to date,
+ * and generates their frames.
+ */
 void vehicleTypesCreate(void);
 
 void vehicleTypesDestroy(void);
 
-/**
- *  Generates rotated frames for vehicle use.
- *  @param szPath Path to file with source frame.
- *  @return       Pointer to newly created bitmap with rotated frames, otherwise zero.
- */
-tBitMap *vehicleTypeGenerateRotatedFrames(const char *szPath);
-
 void vehicleTypeFramesDestroy(tVehicleType *pType);
 
 extern tVehicleType g_pVehicleTypes[VEHICLE_TYPE_COUNT];